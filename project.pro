@@ -8,6 +8,7 @@ CONFIG += ordered
 
 SUBDIRS = src \
           utils \
+          utils/thumbgen \
           tests \
 
 contains( doc, no ) {
@@ -24,6 +24,7 @@ BuildRequires:  pkgconfig(Qt5Test)
 BuildRequires:  pkgconfig(Qt5DBus)
 BuildRequires:  pkgconfig(libexif)
 BuildRequires:  pkgconfig(exempi-2.0)
+BuildRequires:  libjpeg-devel
 BuildRequires:  fdupes
 BuildRequires:  pkgconfig(libffmpegthumbnailer)
 
@@ -114,6 +115,7 @@ rm %{buildroot}/%{_libdir}/libunittests-quill.so
 %defattr(-,root,root,-)
 # >> files quill-qt5-utils
 %{_libdir}/quill-utils/quill-autoclean
+%{_libdir}/quill-utils/quill-thumbgen
 # << files quill-qt5-utils
 
 %files tests
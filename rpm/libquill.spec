@@ -23,6 +23,7 @@ BuildRequires:  pkgconfig(QtCore)
 BuildRequires:  pkgconfig(QtOpenGL)
 BuildRequires:  pkgconfig(libexif)
 BuildRequires:  pkgconfig(exempi-2.0)
+BuildRequires:  libjpeg-devel
 BuildRequires:  fdupes
 BuildRequires:  pkgconfig(libffmpegthumbnailer)
 
@@ -114,6 +115,7 @@ rm %{buildroot}/%{_libdir}/libunittests-quill.so
 %defattr(-,root,root,-)
 # >> files quill-utils
 %{_libdir}/quill-utils/quill-autoclean
+%{_libdir}/quill-utils/quill-thumbgen
 # << files quill-utils
 
 %files tests
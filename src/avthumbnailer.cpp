@@ -3,20 +3,28 @@
 #include "file.h"
 #include "strings.h"
 #include "core.h"
+#include "displaylevel.h"
 #include <libffmpegthumbnailer/videothumbnailer.h>
 #include <QDir>
+#include <QImage>
 #include <QDebug>
 
 AVThumbnailer::AVThumbnailer() :
-  m_taskInProgress(false)
+  m_workerCount(1),
+  m_stopping(false)
 {
 }
 
 AVThumbnailer::~AVThumbnailer()
 {
-  if (m_thread.joinable()) {
-    m_thread.join();
-  }
+  m_mutex.lock();
+  m_stopping = true;
+  m_queue.clear();
+  m_mutex.unlock();
+  m_condition.notify_all();
+
+  for (std::thread &thread : m_threads)
+    thread.join();
 }
 
 bool AVThumbnailer::supports(const QString mimeType)
@@ -26,84 +34,184 @@ bool AVThumbnailer::supports(const QString mimeType)
 
 bool AVThumbnailer::isRunning()
 {
-    bool running;
-    m_mutex.lock();
-    running = m_taskInProgress;
-    m_mutex.unlock();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_queue.empty() || !m_running.empty();
+}
+
+bool AVThumbnailer::isFull()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // One job waiting per worker, so that a worker never idles
+    // waiting for the main thread
+    return (int)(m_queue.size() + m_running.size()) >= 2 * m_workerCount;
+}
+
+bool AVThumbnailer::isPending(const QString &filePath, const QString &flavor)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return containsJob(m_queue, filePath, flavor) ||
+      containsJob(m_running, filePath, flavor);
+}
+
+bool AVThumbnailer::containsJob(const std::deque<Job> &jobs,
+				const QString &filePath, const QString &flavor)
+{
+    for (const Job &job : jobs)
+      if (job.inPath == filePath)
+	foreach (const Output &output, job.outputs)
+	  if (output.flavor == flavor)
+	    return true;
+    return false;
+}
 
-    return running;
+void AVThumbnailer::setWorkerCount(int count)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_workerCount = qMax(count, 1);
+}
+
+int AVThumbnailer::workerCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_workerCount;
 }
 
 void AVThumbnailer::newThumbnailerTask(const QString &filePath,
-                                         const QString &mimeType,
-                                         const QString &flavor)
+                                       const QString &mimeType,
+                                       const QString &flavor)
+{
+    newThumbnailerTask(filePath, mimeType, QStringList() << flavor);
+}
+
+void AVThumbnailer::newThumbnailerTask(const QString &filePath,
+                                       const QString &mimeType,
+                                       const QStringList &flavors)
 {
     Q_UNUSED(mimeType);
 
     QUILL_LOG(Logger::Module_DBusThumbnailer, QString(Q_FUNC_INFO));
 
-    if (isRunning())
+    if (isFull() || flavors.isEmpty())
         return;
 
-    m_taskInProgress = true;
-    int level = Core::instance()->levelFromFlavor(flavor);
-    QSize size = Core::instance()->previewSize(level);
-    QSize min = Core::instance()->minimumPreviewSize(level);
-    bool crop = min.isValid();
-    QString path = File::filePathHash(filePath);
-    path.append(Strings::dot + Core::instance()->thumbnailExtension());
-    path.prepend(Core::instance()->thumbnailPath(level) +
-                            QDir::separator());
-
-    // We will ignore error checking for the sake of simplicity.
-    // thumbnail creation will fail if it cannot save it anyway
-    // and a signal will be emitted
-    QFileInfo(path).absoluteDir().mkpath(".");
-    try {
-      m_taskInProgress = true;
-      if (m_thread.joinable()) {
-	m_thread.join();
-      }
+    Job job;
+    job.inPath = filePath;
+
+    foreach (const QString &flavor, flavors) {
+        if (isPending(filePath, flavor))
+            continue;
+
+        int level = Core::instance()->levelFromFlavor(flavor);
+        QString path = File::filePathHash(filePath);
+        path.append(Strings::dot + Core::instance()->thumbnailExtension());
+        path.prepend(Core::instance()->thumbnailPath(level) +
+                     QDir::separator());
 
-      m_thread = std::thread(createThumbnail, this, flavor, filePath, path,
-			     size.width(), crop);
+        // We will ignore error checking for the sake of simplicity.
+        // thumbnail creation will fail if it cannot save it anyway
+        // and a signal will be emitted
+        QFileInfo(path).absoluteDir().mkpath(".");
 
+        Output output;
+        output.flavor = flavor;
+        output.path = path;
+        output.size = Core::instance()->previewSize(level);
+        output.minimumSize = Core::instance()->minimumPreviewSize(level);
+        job.outputs.append(output);
+    }
+
+    if (job.outputs.isEmpty())
+        return;
+
+    m_mutex.lock();
+    m_queue.push_back(job);
+    bool startWorker = ((int)m_threads.size() < m_workerCount);
+    m_mutex.unlock();
+    m_condition.notify_one();
+
+    if (!startWorker)
+      return;
+
+    try {
+      m_threads.push_back(std::thread(runWorker, this));
     } catch (...) {
-      m_taskInProgress = false;
+      // The job stays queued if any worker is left to take it
+      if (!m_threads.empty())
+	return;
+      m_mutex.lock();
+      m_queue.clear();
+      m_mutex.unlock();
       QMetaObject::invokeMethod(this, "thumbnailError", Qt::QueuedConnection,
 				Q_ARG(QString, filePath), Q_ARG(uint, 0),
 				Q_ARG(QString, QString()));
+      QMetaObject::invokeMethod(this, "requestFinished", Qt::QueuedConnection);
     }
 }
 
-void AVThumbnailer::createThumbnail(AVThumbnailer *that, QString flavor,
-				    QString inPath, QString outPath,
-				    int width, bool crop) {
-
-  try {
-    ffmpegthumbnailer::VideoThumbnailer
-      thumbnailer(width, false, !crop, 8, false);
-    thumbnailer.setSeekPercentage(10);
-    thumbnailer.generateThumbnail(inPath.toStdString(), Jpeg, outPath.toStdString());
-    that->m_mutex.lock();
-    that->m_taskInProgress = false;
-    that->m_mutex.unlock();
-    QMetaObject::invokeMethod(that, "thumbnailGenerated", Qt::QueuedConnection,
-			      Q_ARG(QString, inPath), Q_ARG(QString, flavor));
-  } catch (std::exception& e) {
-    qDebug() << e.what();
-    that->m_mutex.lock();
-    that->m_taskInProgress = false;
-    that->m_mutex.unlock();
-    QMetaObject::invokeMethod(that, "thumbnailError", Qt::QueuedConnection,
-			      Q_ARG(QString, inPath), Q_ARG(uint, 0),
-			      Q_ARG(QString, QString()));
-  } catch (...) {
-    that->m_mutex.lock();
-    that->m_taskInProgress = false;
-    that->m_mutex.unlock();
-    QMetaObject::invokeMethod(that, "thumbnailError", Qt::QueuedConnection,
-			      Q_ARG(QString, inPath), Q_ARG(uint, 0),
-			      Q_ARG(QString, QString()));
+void AVThumbnailer::runWorker(AVThumbnailer *that) {
+
+  // Every worker keeps its own thumbnailer for all of its jobs.
+  // Frames are decoded in their original size, and scaled here to
+  // all flavors
+  ffmpegthumbnailer::VideoThumbnailer thumbnailer(0, false, true, 8, false);
+  thumbnailer.setSeekPercentage(10);
+
+  std::unique_lock<std::mutex> lock(that->m_mutex);
+
+  while (true) {
+    that->m_condition.wait(lock, [that] {
+	return that->m_stopping || !that->m_queue.empty();
+      });
+    if (that->m_stopping)
+      return;
+
+    Job job = that->m_queue.front();
+    that->m_queue.pop_front();
+    that->m_running.push_back(job);
+    lock.unlock();
+
+    QImage frame;
+    try {
+      std::vector<uint8_t> buffer;
+      thumbnailer.generateThumbnail(job.inPath.toStdString(), Png, buffer);
+      frame.loadFromData(buffer.data(), (int)buffer.size(), "PNG");
+    } catch (std::exception& e) {
+      qDebug() << e.what();
+    } catch (...) {
+    }
+
+    // Same sizes and crops as thumbnails made by Quill itself
+    if (!frame.isNull()) {
+      foreach (const Output &output, job.outputs) {
+	DisplayLevel level(output.size);
+	level.setMinimumSize(output.minimumSize);
+	const QSize targetSize = level.targetSize(frame.size());
+	const QRect area = level.targetArea(targetSize, frame.size());
+	frame.copy(area).scaled(targetSize, Qt::IgnoreAspectRatio,
+				Qt::SmoothTransformation).save(output.path);
+      }
+    }
+
+    lock.lock();
+    for (auto it = that->m_running.begin(); it != that->m_running.end(); ++it)
+      if ((it->inPath == job.inPath) &&
+	  (it->outputs.first().flavor == job.outputs.first().flavor)) {
+	that->m_running.erase(it);
+	break;
+      }
+
+    // Missing thumbnail files are detected by the receiver
+    if (!frame.isNull()) {
+      foreach (const Output &output, job.outputs)
+	QMetaObject::invokeMethod(that, "thumbnailGenerated",
+				  Qt::QueuedConnection,
+				  Q_ARG(QString, job.inPath),
+				  Q_ARG(QString, output.flavor));
+    }
+    else
+      QMetaObject::invokeMethod(that, "thumbnailError", Qt::QueuedConnection,
+				Q_ARG(QString, job.inPath), Q_ARG(uint, 0),
+				Q_ARG(QString, QString()));
+    QMetaObject::invokeMethod(that, "requestFinished", Qt::QueuedConnection);
   }
 }
@@ -3,8 +3,12 @@
 
 #include <QObject>
 #include <QStringList>
+#include <QSize>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
 
 class AVThumbnailer : public QObject {
   Q_OBJECT
@@ -15,23 +19,85 @@ public:
 
   bool supports(const QString mimeType);
 
+  /*!
+    True if any thumbnail is queued or being generated.
+   */
+
   bool isRunning();
 
+  /*!
+    True if enough thumbnails are queued to keep all workers busy.
+   */
+
+  bool isFull();
+
+  /*!
+    True if the given file and flavor are queued or being generated.
+   */
+
+  bool isPending(const QString &filePath, const QString &flavor);
+
+  /*!
+    Sets the number of worker threads. Only affects workers which
+    have not been started yet. Default is 1.
+   */
+
+  void setWorkerCount(int count);
+
+  int workerCount();
+
   void newThumbnailerTask(const QString &filePath,
 			  const QString &mimeType,
 			  const QString &flavor);
 
+  /*!
+    Creates thumbnails of all the given flavors from one decoded
+    video frame. Each flavor gets its own thumbnailGenerated()
+    signal, or if the video cannot be decoded, thumbnailError() is
+    emitted once.
+   */
+
+  void newThumbnailerTask(const QString &filePath,
+			  const QString &mimeType,
+			  const QStringList &flavors);
+
 signals:
   void thumbnailGenerated(const QString filePath, const QString flavor);
   void thumbnailError(const QString filePath, uint errorCode,
 		      const QString message);
 
+  /*!
+    A thumbnail has been finished, successfully or not, so a new one
+    can be queued.
+   */
+
+  void requestFinished();
+
 private:
-  static void createThumbnail(AVThumbnailer *that, QString flavor, QString inPath, QString outPath,
-			      int width, bool crop);
+  struct Output {
+    QString flavor;
+    QString path;
+    QSize size;
+    QSize minimumSize;
+  };
+
+  struct Job {
+    QString inPath;
+    QList<Output> outputs;
+  };
+
+  static void runWorker(AVThumbnailer *that);
+  static bool containsJob(const std::deque<Job> &jobs,
+			  const QString &filePath,
+			  const QString &flavor);
+
   std::mutex m_mutex;
-  std::thread m_thread;
-  bool m_taskInProgress;
+  std::condition_variable m_condition;
+  std::vector<std::thread> m_threads;
+  std::deque<Job> m_queue;
+  std::deque<Job> m_running;
+  int m_workerCount;
+  bool m_stopping;
 };
 
 #endif
@@ -40,6 +40,7 @@
 #include "backgroundthread.h"
 #include "task.h"
 #include <QMetaType>
+#include <QElapsedTimer>
 #include <QuillImageFilter>
 
 BackgroundThread::BackgroundThread(QObject *parent) :
@@ -76,7 +77,11 @@ void BackgroundThread::run()
             Task* task = m_TaskQueue.dequeue();
             m_TaskMutex.unlock();
             // Task is available, emit the signal which completes processFinishedTask
-            QuillImage image = task->filter()->apply(task->inputImage());
+            // Small tiles take less than a millisecond
+            QElapsedTimer timer;
+            timer.start();
+            QuillImage image = task->apply();
+            task->setElapsed(timer.nsecsElapsed() / 1000);
             emit taskDone(image,task);
         }
         else
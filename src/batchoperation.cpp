@@ -0,0 +1,224 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QTemporaryFile>
+#include <QuillImageFilter>
+#include <QuillImageFilterFactory>
+#include <QuillImageFilterGenerator>
+#include <QuillMetadata>
+#include <stdio.h>
+
+#include "batchoperation.h"
+#include "strings.h"
+
+BatchFilters::BatchFilters(const QList<QuillImageFilter*> &filters) :
+    filters(filters)
+{
+}
+
+BatchFilters::~BatchFilters()
+{
+    qDeleteAll(filters);
+}
+
+BatchOperation::BatchOperation(const QString &fileName,
+                               const QString &targetFileName,
+                               QSharedPointer<BatchFilters> filters,
+                               const QSize &imageSizeLimit,
+                               qint64 imagePixelsLimit) :
+    m_fileName(fileName), m_targetFileName(targetFileName),
+    m_filters(filters), m_imageSizeLimit(imageSizeLimit),
+    m_imagePixelsLimit(imagePixelsLimit)
+{
+}
+
+BatchOperation::~BatchOperation()
+{
+}
+
+QuillImage BatchOperation::apply(const QuillImage &image)
+{
+    Q_UNUSED(image);
+
+    // Load
+
+    const QByteArray format = QImageReader::imageFormat(m_fileName);
+
+    // The whole image is loaded at once, so it must fit the limits
+    const QSize fullImageSize = QImageReader(m_fileName).size();
+    if ((m_imageSizeLimit.isValid() &&
+         (fullImageSize.boundedTo(m_imageSizeLimit) != fullImageSize)) ||
+        ((m_imagePixelsLimit > 0) &&
+         ((qint64)fullImageSize.width() * fullImageSize.height() >
+          m_imagePixelsLimit))) {
+        m_error = QuillError(QuillError::ImageSizeLimitError,
+                             QuillError::ImageFileErrorSource,
+                             m_fileName);
+        return QuillImage();
+    }
+
+    QuillImageFilter *loadFilter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Role_Load);
+    loadFilter->setOption(QuillImageFilter::FileName, QVariant(m_fileName));
+
+    QuillImage result = loadFilter->apply(QuillImage());
+
+    if (result.isNull()) {
+        m_error = QuillError(QuillError::translateFilterError(loadFilter->error()),
+                             QuillError::ImageFileErrorSource,
+                             m_fileName);
+        delete loadFilter;
+        return QuillImage();
+    }
+    delete loadFilter;
+
+    // Edit
+
+    foreach (QuillImageFilter *filter, m_filters->filters) {
+        result.setFullImageSize(result.size());
+        result.setArea(QRect(QPoint(0, 0), result.size()));
+
+        // A generator only analyses the image, the filter it results
+        // in does the edit
+        QuillImageFilter *editFilter = filter;
+        QuillImageFilterGenerator *generator =
+            dynamic_cast<QuillImageFilterGenerator*>(filter);
+        if (generator) {
+            generator->apply(result);
+            editFilter = generator->resultingFilter();
+            if (!editFilter)
+                continue;
+        }
+
+        const QuillImage edited = editFilter->apply(result);
+        const QuillImageFilter::ImageFilterError filterError =
+            editFilter->error();
+        if (editFilter != filter)
+            delete editFilter;
+
+        if (edited.isNull()) {
+            m_error = QuillError(QuillError::translateFilterError(filterError),
+                                 QuillError::ImageFileErrorSource,
+                                 m_fileName);
+            return QuillImage();
+        }
+        result = edited;
+    }
+
+    // Save
+
+    const QFileInfo info(m_targetFileName);
+    QTemporaryFile temporaryFile(info.path() + QDir::separator()
+                                 + Strings::tempFilePattern
+                                 + info.fileName());
+    if (!temporaryFile.open()) {
+        m_error = QuillError(QuillError::FileOpenForWriteError,
+                             QuillError::TemporaryFileErrorSource,
+                             info.path());
+        return QuillImage();
+    }
+    temporaryFile.close();
+
+    QuillImageFilter *saveFilter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Role_Save);
+    saveFilter->setOption(QuillImageFilter::FileName,
+                          QVariant(temporaryFile.fileName()));
+    saveFilter->setOption(QuillImageFilter::FileFormat,
+                          QVariant(QString(format)));
+
+    // The edited image is upright, so the orientation is reset
+    if (format == "jpeg") {
+        QuillMetadata metadata(m_fileName, QuillMetadata::ExifFormat);
+        if (!metadata.entry(QuillMetadata::Tag_Orientation).isNull())
+            metadata.setEntry(QuillMetadata::Tag_Orientation, QVariant(1));
+        saveFilter->setOption(QuillImageFilter::RawExifData,
+                              QVariant(metadata.dump(QuillMetadata::ExifFormat)));
+    }
+
+    const bool isSaved = !saveFilter->apply(result).isNull();
+    delete saveFilter;
+
+    if (!isSaved) {
+        m_error = QuillError(QuillError::FileWriteError,
+                             QuillError::ImageFileErrorSource,
+                             m_targetFileName);
+        return QuillImage();
+    }
+
+    const QFile::Permissions permissions = QFile::permissions(m_fileName);
+
+    // rename() replaces the target atomically, so the original is
+    // kept if it fails
+    if (::rename(QFile::encodeName(temporaryFile.fileName()).constData(),
+                 QFile::encodeName(m_targetFileName).constData()) != 0) {
+        m_error = QuillError(QuillError::FileOpenForWriteError,
+                             QuillError::ImageFileErrorSource,
+                             m_targetFileName);
+        return QuillImage();
+    }
+
+    // The file now has its final name and must not be removed
+    temporaryFile.setAutoRemove(false);
+    QFile::setPermissions(m_targetFileName, permissions);
+
+    return QuillImage();
+}
+
+QString BatchOperation::name() const
+{
+    return QString("BatchOperation");
+}
+
+QString BatchOperation::fileName() const
+{
+    return m_fileName;
+}
+
+QString BatchOperation::targetFileName() const
+{
+    return m_targetFileName;
+}
+
+QuillError BatchOperation::error() const
+{
+    return m_error;
+}
@@ -0,0 +1,137 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class BatchOperation
+
+  \brief Loads, edits and saves one file of a batch in a single
+  background task.
+
+Batch processing does not need any of the state kept for files being
+shown and edited: there is no undo stack, no preview levels and no
+edit history. Each file of a batch is loaded at full size, run through
+the filters of the batch and saved into the target directory, all on
+the background thread. The result is first written into a temporary
+file in the target directory which then atomically replaces the
+target, so that a failed save never leaves a partial file behind nor
+loses the original.
+
+Filter generators (such as automatic fixes and red-eye detection)
+first analyse the image, and the filter they result in then does the
+edit, as for files being edited. Files too big to be loaded at full
+size within the image size limits of Quill are not processed.
+ */
+
+#ifndef BATCH_OPERATION_H
+#define BATCH_OPERATION_H
+
+#include <QList>
+#include <QString>
+#include <QSize>
+#include <QSharedPointer>
+
+#include "task.h"
+#include "quillerror.h"
+
+class QuillImageFilter;
+
+/*!
+  The filters of a batch, shared by all of its files and deleted
+  together with the last one.
+ */
+
+class BatchFilters
+{
+public:
+    BatchFilters(const QList<QuillImageFilter*> &filters);
+    ~BatchFilters();
+
+    QList<QuillImageFilter*> filters;
+
+private:
+    Q_DISABLE_COPY(BatchFilters)
+};
+
+class BatchOperation : public TaskOperation
+{
+public:
+
+    /*!
+      @param fileName the file to process
+      @param targetFileName where to save the result; may be the same
+      as fileName
+      @param filters the filters to apply, in order
+      @param imageSizeLimit files bigger than this are not processed;
+      ignored if invalid
+      @param imagePixelsLimit files with more pixels than this are not
+      processed; ignored if 0
+     */
+
+    BatchOperation(const QString &fileName, const QString &targetFileName,
+                   QSharedPointer<BatchFilters> filters,
+                   const QSize &imageSizeLimit = QSize(),
+                   qint64 imagePixelsLimit = 0);
+
+    ~BatchOperation();
+
+    QuillImage apply(const QuillImage &image);
+
+    QString name() const;
+
+    QString fileName() const;
+
+    QString targetFileName() const;
+
+    /*!
+      The error which stopped processing the file, or NoError if the
+      file has been saved.
+     */
+
+    QuillError error() const;
+
+private:
+    QString m_fileName;
+    QString m_targetFileName;
+    QSharedPointer<BatchFilters> m_filters;
+    QSize m_imageSizeLimit;
+    qint64 m_imagePixelsLimit;
+    QuillError m_error;
+};
+
+#endif // BATCH_OPERATION_H
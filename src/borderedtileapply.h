@@ -0,0 +1,81 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class BorderedTileApply
+
+  \brief Runs a filter which reads neighbouring pixels on a tile
+  extended by a border, and cuts the tile out of the result.
+
+The input image is the previous tile together with its border, as
+assembled by TileMap::assemble(). The result gets the area of the
+empty tile given to the constructor.
+ */
+
+#ifndef BORDERED_TILE_APPLY_H
+#define BORDERED_TILE_APPLY_H
+
+#include "task.h"
+
+class QuillImageFilter;
+
+class BorderedTileApply : public TaskOperation
+{
+public:
+
+    /*!
+      @param filter the filter of the command
+      @param tile the empty tile to be calculated, as returned by
+      TileMap::tile()
+     */
+
+    BorderedTileApply(QuillImageFilter *filter, const QuillImage &tile);
+
+    ~BorderedTileApply();
+
+    QuillImage apply(const QuillImage &image);
+
+    QString name() const;
+
+private:
+    QuillImageFilter *m_filter;
+    QuillImage m_tile;
+};
+
+#endif // BORDERED_TILE_APPLY_H
@@ -37,18 +37,22 @@
 **
 ****************************************************************************/
 
+#include <limits.h>
 #include <QuillImage>
 #include <QuillImageFilter>
 #include <QuillImageFilterGenerator>
 #include <QImageWriter>
 #include <QDir>
+#include <QFileInfo>
 #include <QEventLoop>
 #include <QTimer>
+#include <QSet>
 #include "quill.h"
 #include "quillerror.h"
 #include "core.h"
 #include "displaylevel.h"
 #include "file.h"
+#include "quillfile.h"
 #include "quillundostack.h"
 #include "quillundocommand.h"
 #include "imagecache.h"
@@ -57,6 +61,11 @@
 #include "threadmanager.h"
 #include "tilemap.h"
 #include "tilecache.h"
+#include "savebufferpool.h"
+#include "tilespill.h"
+#include "resultcache.h"
+#include "batchoperation.h"
+#include "storedimagesave.h"
 #include "historyxml.h"
 #include "logger.h"
 #ifdef USE_AV
@@ -77,8 +86,21 @@ Core::Core(Quill::ThreadingMode threadingMode) :
     m_thumbnailBasePath(QDir::homePath() + Strings::thumbsBasePath),
     m_thumbnailCreationEnabled(true),
     m_dBusThumbnailingEnabled(true),
+    m_viewPortPredictionEnabled(false),
+    m_losslessSaveEnabled(false),
+    m_scaledJpegLoadingEnabled(false),
+    m_exifPreviewEnabled(false),
+    m_pyramidLoadingEnabled(false),
+    m_adaptiveTileSizeEnabled(false),
+    m_editHistoryPreviewsEnabled(false),
+    m_timingCount(0), m_timingPixels(0), m_timingUsec(0),
+    m_timingPixelsSquared(0), m_timingProduct(0),
     m_saveBufferSize(65536*16),
+    m_decodedStripCacheSize(0),
+    m_saveBufferPool(new SaveBufferPool((qint64)65536*16*2*4)),
     m_tileCache(new TileCache(100)),
+    m_tileSpill(0),
+    m_resultCache(new ResultCache(0)),
     m_scheduler(new Scheduler()),
     m_threadManager(new ThreadManager(threadingMode)),
     m_temporaryFilePath(QString())
@@ -89,6 +111,9 @@ Core::Core(Quill::ThreadingMode threadingMode) :
     DisplayLevel *fullLevel = new DisplayLevel(Quill::defaultViewPortSize * 2);
     m_displayLevel.append(fullLevel);
 
+    m_localFilters.insert(QuillImageFilter::Name_RedEyeDetection);
+    m_localFilters.insert(QuillImageFilter::Name_RedEyeReduction);
+
     qRegisterMetaType<QuillImageList>("QuillImageList");
     qRegisterMetaType<QuillError>("QuillError");
 
@@ -101,6 +126,10 @@ Core::Core(Quill::ThreadingMode threadingMode) :
     connect(m_avThumbnailer,
             SIGNAL(thumbnailError(const QString, uint, const QString)),
             SLOT(processDBusThumbnailerError(const QString, uint, const QString)));
+
+    connect(m_avThumbnailer,
+            SIGNAL(requestFinished()),
+            SLOT(processDBusThumbnailerFinished()));
 #else
     m_dBusThumbnailer = new DBusThumbnailer;
     connect(m_dBusThumbnailer,
@@ -110,6 +139,10 @@ Core::Core(Quill::ThreadingMode threadingMode) :
     connect(m_dBusThumbnailer,
             SIGNAL(thumbnailError(const QString, uint, const QString)),
             SLOT(processDBusThumbnailerError(const QString, uint, const QString)));
+
+    connect(m_dBusThumbnailer,
+            SIGNAL(requestFinished()),
+            SLOT(processDBusThumbnailerFinished()));
 #endif
     m_writableImageFormats = QImageWriter::supportedImageFormats();
     m_fileList.clear();
@@ -119,11 +152,18 @@ Core::~Core()
 {
     foreach(File *file, m_fileList)
         delete file;
+    // These have been invalidated above
+    qDeleteAll(m_prefetchFiles);
+    qDeleteAll(m_batchQueue);
+    qDeleteAll(m_storedImageQueue);
     while (!m_displayLevel.isEmpty()) {
         delete m_displayLevel.first();
         m_displayLevel.removeFirst();
     }
     delete m_tileCache;
+    delete m_tileSpill;
+    delete m_saveBufferPool;
+    delete m_resultCache;
     delete m_threadManager;
     delete m_scheduler;
 #ifdef USE_AV
@@ -256,22 +296,22 @@ QSize Core::imageSizeLimit() const
     return m_imageSizeLimit;
 }
 
-void Core::setImagePixelsLimit(int pixels)
+void Core::setImagePixelsLimit(qint64 pixels)
 {
     m_imagePixelsLimit = pixels;
 }
 
-int Core::imagePixelsLimit() const
+qint64 Core::imagePixelsLimit() const
 {
     return m_imagePixelsLimit;
 }
 
-void Core::setNonTiledImagePixelsLimit(int pixels)
+void Core::setNonTiledImagePixelsLimit(qint64 pixels)
 {
     m_nonTiledImagePixelsLimit = pixels;
 }
 
-int Core::nonTiledImagePixelsLimit() const
+qint64 Core::nonTiledImagePixelsLimit() const
 {
     return m_nonTiledImagePixelsLimit;
 }
@@ -405,11 +445,174 @@ QSize Core::defaultTileSize() const
     return m_defaultTileSize;
 }
 
+void Core::setTileBorder(const QString &filterName, int border)
+{
+    if (border > 0)
+        m_tileBorders.insert(filterName, border);
+    else
+        m_tileBorders.remove(filterName);
+}
+
+int Core::tileBorder(QuillImageFilter *filter) const
+{
+    if (!filter)
+        return 0;
+    return m_tileBorders.value(filter->name(), 0);
+}
+
+void Core::setLocalFilter(const QString &filterName, bool local)
+{
+    if (local)
+        m_localFilters.insert(filterName);
+    else
+        m_localFilters.remove(filterName);
+}
+
+bool Core::isLocalFilter(QuillImageFilter *filter) const
+{
+    if (!filter)
+        return false;
+    return m_localFilters.contains(filter->name());
+}
+
+void Core::setAdaptiveTileSizeEnabled(bool enabled)
+{
+    m_adaptiveTileSizeEnabled = enabled;
+}
+
+bool Core::isAdaptiveTileSizeEnabled() const
+{
+    return m_adaptiveTileSizeEnabled;
+}
+
+QSize Core::tileSizeFor(const QSize &fullImageSize) const
+{
+    QSize size = m_defaultTileSize;
+
+    if (!m_adaptiveTileSizeEnabled || size.isEmpty() ||
+        fullImageSize.isEmpty())
+        return size;
+
+    // Least squares fit of msec = overhead + perPixel * pixels
+    const double variance = m_timingCount * m_timingPixelsSquared -
+        m_timingPixels * m_timingPixels;
+    if ((m_timingCount < 2) || (variance <= 0))
+        return size;
+
+    const double perPixel = (m_timingCount * m_timingProduct -
+                             m_timingPixels * m_timingUsec) / variance;
+    const double overhead =
+        (m_timingUsec - perPixel * m_timingPixels) / m_timingCount;
+    if ((perPixel <= 0) || (overhead <= 0))
+        return size;
+
+    // Keep the overhead below a tenth of the time spent on a tile
+    const double minPixels = 9 * overhead / perPixel;
+
+    // The tile cache may use up to 4 times the memory it would
+    // with the default tile size
+    const qint64 cost = m_tileCache->cacheCost();
+    const qint64 budget = 4 * cost * size.width() * size.height();
+
+    while ((double)size.width() * size.height() < minPixels) {
+        QSize next = size;
+
+        // Grow the shorter side, but not past the image
+        if ((size.width() < fullImageSize.width()) &&
+            ((size.width() <= size.height()) ||
+             (size.height() >= fullImageSize.height())))
+            next.setWidth(size.width() * 2);
+        else if (size.height() < fullImageSize.height())
+            next.setHeight(size.height() * 2);
+        else
+            break;
+
+        const qint64 tiles =
+            (qint64)((fullImageSize.width() - 1) / next.width() + 1) *
+            ((fullImageSize.height() - 1) / next.height() + 1);
+        if (qMin(tiles, cost) * next.width() * next.height() > budget)
+            break;
+
+        size = next;
+    }
+
+    return size;
+}
+
+void Core::recordFilterTime(qint64 pixels, qint64 usec)
+{
+    if ((pixels <= 0) || (usec < 0))
+        return;
+
+    m_timingCount++;
+    m_timingPixels += pixels;
+    m_timingUsec += usec;
+    m_timingPixelsSquared += (double)pixels * pixels;
+    m_timingProduct += (double)pixels * usec;
+}
+
 void Core::setTileCacheSize(int size)
 {
     m_tileCache->resizeCache(size);
 }
 
+void Core::setSaveBufferPoolSize(int size)
+{
+    m_saveBufferPool->setMaxBytes((qint64)size * 4);
+}
+
+int Core::saveBufferPoolHitCount() const
+{
+    return m_saveBufferPool->hitCount();
+}
+
+int Core::saveBufferPoolMissCount() const
+{
+    return m_saveBufferPool->missCount();
+}
+
+void Core::setTileSpillSize(qint64 bytes)
+{
+    m_tileCache->setSpill(0);
+    delete m_tileSpill;
+    m_tileSpill = 0;
+
+    if (bytes <= 0)
+        return;
+
+    QString path = m_temporaryFilePath;
+    if (path.isNull())
+        path = Strings::tempDirDefault;
+
+    m_tileSpill = new TileSpill(path, bytes);
+    m_tileCache->setSpill(m_tileSpill);
+}
+
+TileSpill *Core::tileSpill() const
+{
+    return m_tileSpill;
+}
+
+void Core::setDecodedStripCacheSize(int size)
+{
+    m_decodedStripCacheSize = size;
+}
+
+int Core::decodedStripCacheSize() const
+{
+    return m_decodedStripCacheSize;
+}
+
+void Core::setResultCacheSize(int size)
+{
+    m_resultCache->setMaxSize(size);
+}
+
+void Core::setResultCacheDirectory(const QString &path)
+{
+    m_resultCache->setDirectory(path);
+}
+
 void Core::setSaveBufferSize(int size)
 {
     m_saveBufferSize = size;
@@ -425,6 +628,16 @@ TileCache* Core::tileCache() const
     return m_tileCache;
 }
 
+SaveBufferPool* Core::saveBufferPool() const
+{
+    return m_saveBufferPool;
+}
+
+ResultCache* Core::resultCache() const
+{
+    return m_resultCache;
+}
+
 void Core::setEditHistoryPath(const QString &path)
 {
     m_editHistoryPath = path;
@@ -435,6 +648,16 @@ QString Core::editHistoryPath() const
     return m_editHistoryPath;
 }
 
+void Core::setEditHistoryPreviewsEnabled(bool enabled)
+{
+    m_editHistoryPreviewsEnabled = enabled;
+}
+
+bool Core::isEditHistoryPreviewsEnabled() const
+{
+    return m_editHistoryPreviewsEnabled;
+}
+
 void Core::setThumbnailBasePath(const QString &path)
 {
     m_thumbnailBasePath = path;
@@ -503,6 +726,128 @@ bool Core::isDBusThumbnailingEnabled() const
     return m_dBusThumbnailingEnabled;
 }
 
+void Core::setVideoThumbnailerThreadCount(int count)
+{
+#ifdef USE_AV
+    m_avThumbnailer->setWorkerCount(count);
+#else
+    Q_UNUSED(count);
+#endif
+}
+
+int Core::videoThumbnailerThreadCount() const
+{
+#ifdef USE_AV
+    return m_avThumbnailer->workerCount();
+#else
+    return 0;
+#endif
+}
+
+void Core::setViewPortPredictionEnabled(bool enabled)
+{
+    m_viewPortPredictionEnabled = enabled;
+}
+
+bool Core::isViewPortPredictionEnabled() const
+{
+    return m_viewPortPredictionEnabled;
+}
+
+void Core::setLosslessSaveEnabled(bool enabled)
+{
+    m_losslessSaveEnabled = enabled;
+}
+
+bool Core::isLosslessSaveEnabled() const
+{
+    return m_losslessSaveEnabled;
+}
+
+void Core::setScaledJpegLoadingEnabled(bool enabled)
+{
+    m_scaledJpegLoadingEnabled = enabled;
+}
+
+bool Core::isScaledJpegLoadingEnabled() const
+{
+    return m_scaledJpegLoadingEnabled;
+}
+
+void Core::setExifPreviewEnabled(bool enabled)
+{
+    m_exifPreviewEnabled = enabled;
+}
+
+bool Core::isExifPreviewEnabled() const
+{
+    return m_exifPreviewEnabled;
+}
+
+void Core::setPyramidLoadingEnabled(bool enabled)
+{
+    m_pyramidLoadingEnabled = enabled;
+}
+
+bool Core::isPyramidLoadingEnabled() const
+{
+    return m_pyramidLoadingEnabled;
+}
+
+void Core::setPrefetchHint(const QStringList &fileNames,
+                           Quill::PrefetchDirection direction)
+{
+    QStringList orderedNames = fileNames;
+    if (direction == Quill::PrefetchBackward)
+        for (int i = 0; i < orderedNames.count() / 2; i++)
+            orderedNames.swap(i, orderedNames.count() - 1 - i);
+
+    QList<QuillFile*> oldFiles = m_prefetchFiles;
+    m_prefetchFiles.clear();
+
+    foreach (const QString &fileName, orderedNames) {
+        QuillFile *prefetchFile = 0;
+        foreach (QuillFile *oldFile, oldFiles)
+            if (oldFile->fileName() == fileName) {
+                prefetchFile = oldFile;
+                oldFiles.removeOne(oldFile);
+                break;
+            }
+
+        if (!prefetchFile) {
+            prefetchFile = new QuillFile(fileName);
+            prefetchFile->setPriority(INT_MIN);
+            prefetchFile->setDisplayLevel(previewLevelCount() - 1);
+        }
+        m_prefetchFiles.append(prefetchFile);
+    }
+
+    // Files no longer hinted release their images here
+    qDeleteAll(oldFiles);
+
+    suggestNewTask();
+}
+
+bool Core::isPrefetchReference(const QuillFile *file) const
+{
+    return m_prefetchFiles.contains(const_cast<QuillFile*>(file));
+}
+
+QList<File*> Core::prefetchFileList() const
+{
+    QList<File*> files;
+
+    foreach (QuillFile *prefetchFile, m_prefetchFiles)
+        foreach (File *file, m_fileList)
+            if ((file->fileName() == prefetchFile->fileName()) &&
+                file->isPrefetchOnly()) {
+                files.append(file);
+                break;
+            }
+
+    return files;
+}
+
 void Core::insertFile(File *file)
 {
     m_fileList.append(file);
@@ -561,6 +906,75 @@ void Core::timeout()
     m_loop.exit(1);
 }
 
+void Core::processBatch(const QStringList &fileNames,
+                        const QList<QuillImageFilter*> &filters,
+                        const QString &targetDirectory)
+{
+    QSharedPointer<BatchFilters> batchFilters(new BatchFilters(filters));
+
+    // Batch files are loaded whole, never tiled
+    qint64 pixelsLimit = m_nonTiledImagePixelsLimit;
+    if (pixelsLimit == 0)
+        pixelsLimit = m_imagePixelsLimit;
+
+    QSet<QString> targetFileNames;
+
+    foreach (const QString &fileName, fileNames) {
+        QString targetFileName = fileName;
+        if (!targetDirectory.isEmpty())
+            targetFileName = targetDirectory + QDir::separator()
+                + QFileInfo(fileName).fileName();
+
+        // Files saved under the same name would overwrite each other;
+        // only the first one is processed
+        if (targetFileNames.contains(targetFileName)) {
+            emitError(QuillError(QuillError::FileOpenForWriteError,
+                                 QuillError::ImageFileErrorSource,
+                                 fileName));
+            continue;
+        }
+        targetFileNames.insert(targetFileName);
+
+        m_batchQueue.append(new BatchOperation(fileName, targetFileName,
+                                               batchFilters, m_imageSizeLimit,
+                                               pixelsLimit));
+    }
+
+    if (m_batchQueue.isEmpty())
+        emitBatchFinished();
+    else
+        suggestNewTask();
+}
+
+BatchOperation *Core::takeBatchOperation()
+{
+    if (m_batchQueue.isEmpty())
+        return 0;
+    return m_batchQueue.takeFirst();
+}
+
+bool Core::hasBatchOperations() const
+{
+    return !m_batchQueue.isEmpty();
+}
+
+void Core::queueStoredImage(const QString &fileName, const QuillImage &image)
+{
+    if (fileName.isEmpty() || image.isNull())
+        return;
+
+    // Only called while processing a finished task, which suggests
+    // the next one anyway
+    m_storedImageQueue.append(new StoredImageSave(fileName, image));
+}
+
+StoredImageSave *Core::takeStoredImageSave()
+{
+    if (m_storedImageQueue.isEmpty())
+        return 0;
+    return m_storedImageQueue.takeFirst();
+}
+
 bool Core::waitUntilFinished(int msec)
 {
     if (msec > 0)
@@ -585,6 +999,10 @@ bool Core::waitUntilFinished(int msec)
 void Core::setTemporaryFilePath(const QString &filePath)
 {
     m_temporaryFilePath = filePath;
+
+    // The spill file moves to the new path
+    if (m_tileSpill)
+        setTileSpillSize(m_tileSpill->maxBytes());
 }
 
 QString Core::temporaryFilePath() const
@@ -656,44 +1074,79 @@ void Core::activateDBusThumbnailer()
 {
     QUILL_LOG(Logger::Module_Core, QString(Q_FUNC_INFO));
 #ifdef USE_AV
-    bool running = m_avThumbnailer->isRunning();
+    bool running = m_avThumbnailer->isFull();
 #else
-    bool running = m_dBusThumbnailer->isRunning();
+    bool running = m_dBusThumbnailer->isFull();
 #endif
 
     if (running)
         return;
     for (int level=0; level<=previewLevelCount()-1; level++) {
         QString flavor = thumbnailFlavorName(level);
-        if (!flavor.isNull())
-            // using m_files instead of existingFiles() since this
-            // will potentially be called often and the existing file
-            // list creation is a slow task.
-            foreach(File* file, m_fileList){
-                if ((file->state() == File::State_ExternallySupportedFormat) &&
-                    (level <= file->displayLevel()) &&
-                    file->stack() &&
-                    file->stack()->image(level).isNull() &&
-                    !file->hasThumbnail(level) &&
+        if (flavor.isNull())
+            continue;
+
+        QStringList fileNames, mimeTypes;
+
+        // using m_files instead of existingFiles() since this
+        // will potentially be called often and the existing file
+        // list creation is a slow task.
+        foreach(File* file, m_fileList){
+            if ((file->state() == File::State_ExternallySupportedFormat) &&
+                (level <= file->displayLevel()) &&
+                file->stack() &&
+                file->stack()->image(level).isNull() &&
+                !file->hasThumbnail(level) &&
+                !file->hasThumbnailError() &&
 #ifdef USE_AV
-		    m_avThumbnailer->supports(file->fileFormat())) {
+                m_avThumbnailer->supports(file->fileFormat()) &&
+                !m_avThumbnailer->isPending(file->fileName(), flavor)) {
 #else
-                    m_dBusThumbnailer->supports(file->fileFormat())) {
+                m_dBusThumbnailer->supports(file->fileFormat()) &&
+                !m_dBusThumbnailer->isPending(file->fileName(), flavor)) {
 #endif
-                    QUILL_LOG(Logger::Module_Core, "Requesting thumbnail from D-Bus thumbnailer for "+ file->fileName() + " Mime type " + file->fileFormat() + " Flavor " + flavor);
+                QUILL_LOG(Logger::Module_Core, "Requesting thumbnail from D-Bus thumbnailer for "+ file->fileName() + " Mime type " + file->fileFormat() + " Flavor " + flavor);
 
 #ifdef USE_AV
-                    m_avThumbnailer->newThumbnailerTask(file->fileName(),
-                                                          file->fileFormat(),
-                                                          flavor);
+                // All missing flavors up to the display level are
+                // made from one decoded frame
+                QStringList flavors;
+                for (int i=level; i<=file->displayLevel(); i++)
+                    if ((i < previewLevelCount()) &&
+                        !thumbnailFlavorName(i).isNull() &&
+                        !file->hasThumbnail(i))
+                        flavors.append(thumbnailFlavorName(i));
+
+                m_avThumbnailer->newThumbnailerTask(file->fileName(),
+                                                    file->fileFormat(),
+                                                    flavors);
+                if (m_avThumbnailer->isFull())
+                    return;
 #else
-                    m_dBusThumbnailer->newThumbnailerTask(file->fileName(),
-                                                          file->fileFormat(),
+                fileNames.append(file->fileName());
+                mimeTypes.append(file->fileFormat());
+
+                if (fileNames.count() >= m_dBusThumbnailer->maxBatchSize()) {
+                    m_dBusThumbnailer->newThumbnailerTask(fileNames,
+                                                          mimeTypes,
                                                           flavor);
-#endif
-                    return;
+                    fileNames.clear();
+                    mimeTypes.clear();
+                    if (m_dBusThumbnailer->isFull())
+                        return;
                 }
+#endif
             }
+        }
+
+#ifndef USE_AV
+        if (!fileNames.isEmpty()) {
+            m_dBusThumbnailer->newThumbnailerTask(fileNames, mimeTypes,
+                                                  flavor);
+            if (m_dBusThumbnailer->isFull())
+                return;
+        }
+#endif
     }
 }
 
@@ -725,6 +1178,8 @@ void Core::processDBusThumbnailerError(const QString fileName,
 
         foreach(File* file, m_fileList)
             if(file->fileName()==fileName){
+                // Do not request it again from the thumbnailer
+                file->setThumbnailError(true);
                 file->emitError(QuillError(QuillError::FileFormatUnsupportedError,
                                            QuillError::ImageFileErrorSource,
                                            fileName));
@@ -733,6 +1188,11 @@ void Core::processDBusThumbnailerError(const QString fileName,
     }
 }
 
+void Core::processDBusThumbnailerFinished()
+{
+    suggestNewTask();
+}
+
 
 void Core::emitSaved(QString fileName)
 {
@@ -740,6 +1200,18 @@ void Core::emitSaved(QString fileName)
     QUILL_LOG(Logger::Module_Core, QString(Q_FUNC_INFO)+fileName);
 }
 
+void Core::emitBatchFileSaved(QString fileName)
+{
+    emit batchFileSaved(fileName);
+    QUILL_LOG(Logger::Module_Core, QString(Q_FUNC_INFO)+fileName);
+}
+
+void Core::emitBatchFinished()
+{
+    emit batchFinished();
+    QUILL_LOG(Logger::Module_Core, QString(Q_FUNC_INFO));
+}
+
 void Core::emitRemoved(QString fileName)
 {
     emit removed(fileName);
@@ -53,6 +53,8 @@ can only be changed if no files have been opened yet.
 #include <QObject>
 #include <QColor>
 #include <QEventLoop>
+#include <QHash>
+#include <QSet>
 
 #include "quill.h"
 #include "quillerror.h"
@@ -65,12 +67,18 @@ class Task;
 class Scheduler;
 class ThreadManager;
 class TileCache;
+class SaveBufferPool;
+class TileSpill;
+class ResultCache;
+class BatchOperation;
+class StoredImageSave;
 #ifdef USE_AV
 class AVThumbnailer;
 #else
 class DBusThumbnailer;
 #endif
 class DisplayLevel;
+class QuillFile;
 
 class Core : public QObject
 {
@@ -233,6 +241,57 @@ public:
 
     QSize defaultTileSize() const;
 
+    /*!
+      See Quill::setTileBorder().
+     */
+
+    void setTileBorder(const QString &filterName, int border);
+
+    /*!
+      The border which the filter needs around its input tiles.
+     */
+
+    int tileBorder(QuillImageFilter *filter) const;
+
+    /*!
+      See Quill::setLocalFilter().
+     */
+
+    void setLocalFilter(const QString &filterName, bool local);
+
+    /*!
+      If the filter only changes the area given by its options.
+     */
+
+    bool isLocalFilter(QuillImageFilter *filter) const;
+
+    /*!
+      See Quill::setAdaptiveTileSizeEnabled().
+     */
+
+    void setAdaptiveTileSizeEnabled(bool enabled);
+
+    /*!
+      See Quill::isAdaptiveTileSizeEnabled().
+     */
+
+    bool isAdaptiveTileSizeEnabled() const;
+
+    /*!
+      The tile size for a new image of the given size. This is the
+      default tile size, unless adaptive tile size is enabled and
+      the measured filter times show a high overhead per tile.
+     */
+
+    QSize tileSizeFor(const QSize &fullImageSize) const;
+
+    /*!
+      Records how long a filter took to produce an image with the
+      given number of pixels, in microseconds. Used by tileSizeFor().
+     */
+
+    void recordFilterTime(qint64 pixels, qint64 usec);
+
     /*!
       Sets the maximum allowed dimensions for an image. If either
       dimension of an image overflows its respective limit set here,
@@ -265,14 +324,14 @@ public:
       The default is no limit, which is represented by the value 0.
      */
 
-    void setImagePixelsLimit(int pixels);
+    void setImagePixelsLimit(qint64 pixels);
 
     /*!
       Returns the maximum number of allowed dimensions for an image. See
       setImagePixelsLimit().
     */
 
-    int imagePixelsLimit() const;
+    qint64 imagePixelsLimit() const;
 
     /*!
       Sets the maximum number of allowed pixels for image formats which
@@ -285,14 +344,14 @@ public:
       will be used (see setImagePixelsLimit() ).
      */
 
-    void setNonTiledImagePixelsLimit(int pixels);
+    void setNonTiledImagePixelsLimit(qint64 pixels);
 
     /*!
       Returns the maximum number of allowed pixels for image formats which
       do not support tiling. See setNonTilingImagePixelsLimit().
     */
 
-    int nonTiledImagePixelsLimit() const;
+    qint64 nonTiledImagePixelsLimit() const;
 
     /*!
       Sets the edit history cache size for a given level.
@@ -313,6 +372,61 @@ public:
 
     void setTileCacheSize(int size);
 
+    /*!
+      Sets the save buffer pool size, in pixels (4 bytes per pixel).
+    */
+
+    void setSaveBufferPoolSize(int size);
+
+    /*!
+      See Quill::saveBufferPoolHitCount().
+    */
+
+    int saveBufferPoolHitCount() const;
+
+    /*!
+      See Quill::saveBufferPoolMissCount().
+    */
+
+    int saveBufferPoolMissCount() const;
+
+    /*!
+      Sets the size of the tile spill in bytes, 0 to disable it.
+    */
+
+    void setTileSpillSize(qint64 bytes);
+
+    /*!
+      The tile spill, or 0 if it is disabled.
+    */
+
+    TileSpill *tileSpill() const;
+
+    /*!
+      Sets the decoded strip cache size of a file, in pixels (4 bytes
+      per pixel). 0 disables decoder sessions.
+    */
+
+    void setDecodedStripCacheSize(int size);
+
+    /*!
+      Returns the decoded strip cache size of a file, in pixels.
+    */
+
+    int decodedStripCacheSize() const;
+
+    /*!
+      Sets the result cache size, in pixels (4 bytes per pixel).
+    */
+
+    void setResultCacheSize(int size);
+
+    /*!
+      Sets the directory backing the result cache.
+    */
+
+    void setResultCacheDirectory(const QString &path);
+
     /*!
       Sets the maximum save buffer size, in pixels (4 bytes per pixel).
     */
@@ -334,6 +448,18 @@ public:
 
     QString editHistoryPath() const;
 
+    /*!
+      See Quill::setEditHistoryPreviewsEnabled().
+     */
+
+    void setEditHistoryPreviewsEnabled(bool enabled);
+
+    /*!
+      See Quill::isEditHistoryPreviewsEnabled().
+     */
+
+    bool isEditHistoryPreviewsEnabled() const;
+
     /*!
       Returns the full path where ready-made thumbnails for a given preview
       level are stored.
@@ -405,12 +531,105 @@ public:
 
     bool isDBusThumbnailingEnabled() const;
 
+    /*!
+      See Quill::setVideoThumbnailerThreadCount().
+     */
+
+    void setVideoThumbnailerThreadCount(int count);
+
+    /*!
+      See Quill::videoThumbnailerThreadCount().
+     */
+
+    int videoThumbnailerThreadCount() const;
+
     /*!
       Returns true if the given mime type is supported by D-Bus thumbnailer.
      */
 
     bool isExternallySupportedFormat(const QString &format) const;
 
+    /*!
+      See Quill::setViewPortPredictionEnabled().
+    */
+
+    void setViewPortPredictionEnabled(bool enabled);
+
+    /*!
+      See Quill::isViewPortPredictionEnabled().
+    */
+
+    bool isViewPortPredictionEnabled() const;
+
+    /*!
+      See Quill::setLosslessSaveEnabled().
+    */
+
+    void setLosslessSaveEnabled(bool enabled);
+
+    /*!
+      See Quill::isLosslessSaveEnabled().
+    */
+
+    bool isLosslessSaveEnabled() const;
+
+    /*!
+      See Quill::setScaledJpegLoadingEnabled().
+    */
+
+    void setScaledJpegLoadingEnabled(bool enabled);
+
+    /*!
+      See Quill::isScaledJpegLoadingEnabled().
+    */
+
+    bool isScaledJpegLoadingEnabled() const;
+
+    /*!
+      See Quill::setExifPreviewEnabled().
+    */
+
+    void setExifPreviewEnabled(bool enabled);
+
+    /*!
+      See Quill::isExifPreviewEnabled().
+    */
+
+    bool isExifPreviewEnabled() const;
+
+    /*!
+      See Quill::setPyramidLoadingEnabled().
+    */
+
+    void setPyramidLoadingEnabled(bool enabled);
+
+    /*!
+      See Quill::isPyramidLoadingEnabled().
+    */
+
+    bool isPyramidLoadingEnabled() const;
+
+    /*!
+      See Quill::setPrefetchHint().
+    */
+
+    void setPrefetchHint(const QStringList &fileNames,
+                         Quill::PrefetchDirection direction);
+
+    /*!
+      Returns true if the given file object has been created by Core
+      for prefetching.
+    */
+
+    bool isPrefetchReference(const QuillFile *file) const;
+
+    /*!
+      Returns the files which are only open because of a prefetch
+      hint, in the order they should be prefetched.
+    */
+
+    QList<File*> prefetchFileList() const;
+
     /*!
       To make background loading tests easier on fast machines
 
@@ -449,6 +668,18 @@ public:
 
     TileCache *tileCache() const;
 
+    /*!
+      Access to the pool of save buffers.
+     */
+
+    SaveBufferPool *saveBufferPool() const;
+
+    /*!
+      Access to the cache of results keyed by their contents.
+     */
+
+    ResultCache *resultCache() const;
+
     /*!
       Return the number of files which have at least a given display level.
     */
@@ -487,6 +718,41 @@ public:
 
     bool waitUntilFinished(int msec);
 
+    /*!
+      See Quill::processBatch()
+     */
+
+    void processBatch(const QStringList &fileNames,
+                      const QList<QuillImageFilter*> &filters,
+                      const QString &targetDirectory);
+
+    /*!
+      Removes the next file from the batch queue and returns its
+      operation, or 0 if the queue is empty.
+     */
+
+    BatchOperation *takeBatchOperation();
+
+    /*!
+      Returns true if there are files waiting in the batch queue.
+     */
+
+    bool hasBatchOperations() const;
+
+    /*!
+      Queues an image to be stored on disk by a background task.
+      @param fileName the PNG file to write
+     */
+
+    void queueStoredImage(const QString &fileName, const QuillImage &image);
+
+    /*!
+      Removes the next image from the storing queue and returns its
+      operation, or 0 if the queue is empty.
+     */
+
+    StoredImageSave *takeStoredImageSave();
+
     /*!
       Sets the temporary file path
       @param fileDir the file path
@@ -592,6 +858,16 @@ public:
     */
     void emitError(QuillError error);
 
+    /*!
+      Emits a batchFileSaved signal.
+    */
+    void emitBatchFileSaved(QString fileName);
+
+    /*!
+      Emits a batchFinished signal.
+    */
+    void emitBatchFinished();
+
     /*!
       Returns the file pointer list.
     */
@@ -603,7 +879,9 @@ private:
     Q_DISABLE_COPY(Core);
 
     /*!
-      Activates the D-Bus thumbnailer with a task if there is any.
+      Activates the D-Bus thumbnailer with a task if there is any. The
+      D-Bus thumbnailer gets requests for groups of files, as long as
+      it has room for new requests.
     */
     void activateDBusThumbnailer();
 
@@ -650,11 +928,24 @@ signals:
 
     void error(QuillError error);
 
+    /*!
+      See Quill::batchFileSaved()
+     */
+
+    void batchFileSaved(QString fileName);
+
+    /*!
+      See Quill::batchFinished()
+     */
+
+    void batchFinished();
+
 private slots:
     void processDBusThumbnailerGenerated(const QString fileName,
                                          const QString flavor);
     void processDBusThumbnailerError(const QString fileName, uint errorCode,
                                      const QString message);
+    void processDBusThumbnailerFinished();
     void timeout();
 
 private:
@@ -664,7 +955,7 @@ private:
     QList<DisplayLevel*> m_displayLevel;
 
     QSize m_imageSizeLimit;
-    int m_imagePixelsLimit, m_nonTiledImagePixelsLimit;
+    qint64 m_imagePixelsLimit, m_nonTiledImagePixelsLimit;
     QSize m_vectorGraphicsRenderingSize;
 
     QString m_editHistoryPath;
@@ -672,11 +963,29 @@ private:
     QString m_thumbnailExtension;
     bool m_thumbnailCreationEnabled;
     bool m_dBusThumbnailingEnabled;
+    bool m_viewPortPredictionEnabled;
+    bool m_losslessSaveEnabled;
+    bool m_scaledJpegLoadingEnabled;
+    bool m_exifPreviewEnabled;
+    bool m_pyramidLoadingEnabled;
+    bool m_adaptiveTileSizeEnabled;
+    bool m_editHistoryPreviewsEnabled;
 
     QSize m_defaultTileSize;
+    QHash<QString, int> m_tileBorders;
+    QSet<QString> m_localFilters;
+
+    // Sums for fitting filter times to pixel counts
+    double m_timingCount, m_timingPixels, m_timingUsec;
+    double m_timingPixelsSquared, m_timingProduct;
+
     int m_saveBufferSize;
+    int m_decodedStripCacheSize;
 
+    SaveBufferPool *m_saveBufferPool;
     TileCache *m_tileCache;
+    TileSpill *m_tileSpill;
+    ResultCache *m_resultCache;
     Scheduler *m_scheduler;
     ThreadManager *m_threadManager;
 
@@ -695,6 +1004,11 @@ private:
     QEventLoop m_loop;
     //The list for the file objects in the creation order
     QList<File*> m_fileList;
+    //The file objects created for prefetching, in prefetch order
+    QList<QuillFile*> m_prefetchFiles;
+    QList<BatchOperation*> m_batchQueue;
+    //The images waiting to be stored on disk
+    QList<StoredImageSave*> m_storedImageQueue;
 };
 
 #endif
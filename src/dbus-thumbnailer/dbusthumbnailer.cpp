@@ -6,7 +6,9 @@
 QLatin1String DBusThumbnailer::tumblerService("org.freedesktop.thumbnails.Thumbnailer1");
 QLatin1String DBusThumbnailer::tumblerCache("/org/freedesktop/thumbnails/Thumbnailer1");
 
-DBusThumbnailer::DBusThumbnailer() : m_taskInProgress(false),
+DBusThumbnailer::DBusThumbnailer() : m_service(tumblerService),
+                                     m_maxRequests(4),
+                                     m_maxBatchSize(16),
                                      m_tumbler(0)
 {
     connectDBus();
@@ -14,14 +16,19 @@ DBusThumbnailer::DBusThumbnailer() : m_taskInProgress(false),
 
 DBusThumbnailer::~DBusThumbnailer()
 {
+    qDeleteAll(m_queuedRequests);
+    qDeleteAll(m_requests);
     delete m_tumbler;
 }
 
 void DBusThumbnailer::connectDBus()
 {
     delete m_tumbler;
-    m_tumbler = new ThumbnailerGenericProxy(tumblerService, tumblerCache,
+    m_tumbler = new ThumbnailerGenericProxy(m_service, tumblerCache,
                                             QDBusConnection::sessionBus());
+    connect(m_tumbler,
+            SIGNAL(Ready(uint,const QStringList)),
+            SLOT(readyHandler(uint,const QStringList)));
     connect(m_tumbler,
             SIGNAL(Finished(uint)),
             SLOT(finishedHandler(uint)));
@@ -30,6 +37,12 @@ void DBusThumbnailer::connectDBus()
             SLOT(errorHandler(uint,const QStringList,int,const QString)));
 }
 
+void DBusThumbnailer::setService(const QString &service)
+{
+    m_service = service;
+    connectDBus();
+}
+
 bool DBusThumbnailer::supports(const QString mimeType)
 {
 
@@ -38,49 +51,158 @@ bool DBusThumbnailer::supports(const QString mimeType)
 
 bool DBusThumbnailer::isRunning()
 {
-    return m_taskInProgress;
+    return !m_queuedRequests.isEmpty() || !m_requests.isEmpty();
+}
+
+bool DBusThumbnailer::isFull()
+{
+    return m_queuedRequests.count() + m_requests.count() >= m_maxRequests;
+}
+
+bool DBusThumbnailer::isPending(const QString &filePath,
+                                const QString &flavor) const
+{
+    const QString uri = File::filePathToUri(filePath);
+
+    foreach (Request *request, m_queuedRequests)
+        if ((request->flavor == flavor) && request->filePaths.contains(uri))
+            return true;
+
+    foreach (Request *request, m_requests)
+        if ((request->flavor == flavor) && request->filePaths.contains(uri))
+            return true;
+
+    return false;
+}
+
+void DBusThumbnailer::setMaxRequests(int count)
+{
+    m_maxRequests = count;
+}
+
+int DBusThumbnailer::maxRequests() const
+{
+    return m_maxRequests;
+}
+
+void DBusThumbnailer::setMaxBatchSize(int count)
+{
+    m_maxBatchSize = count;
+}
+
+int DBusThumbnailer::maxBatchSize() const
+{
+    return m_maxBatchSize;
 }
 
 void DBusThumbnailer::newThumbnailerTask(const QString &filePath,
                                          const QString &mimeType,
                                          const QString &flavor)
+{
+    newThumbnailerTask(QStringList() << filePath,
+                       QStringList() << mimeType,
+                       flavor);
+}
+
+void DBusThumbnailer::newThumbnailerTask(const QStringList &filePaths,
+                                         const QStringList &mimeTypes,
+                                         const QString &flavor)
 {
     QUILL_LOG(Logger::Module_DBusThumbnailer, QString(Q_FUNC_INFO));
 
-    if (isRunning())
+    if (isFull() || filePaths.isEmpty())
         return;
 
-    m_taskInProgress = true;
-    m_taskFilePath = filePath;
-    m_flavor = flavor;
+    Request *request = new Request;
+    request->flavor = flavor;
 
     QStringList uris;
-    uris.append(File::filePathToUri(filePath));
-
-    QStringList mimes;
-    mimes.append(mimeType);
+    foreach (const QString &filePath, filePaths) {
+        const QString uri = File::filePathToUri(filePath);
+        uris.append(uri);
+        request->filePaths.insert(uri, filePath);
+    }
 
     if ((!m_tumbler) || (!m_tumbler->isValid()))
         connectDBus();
 
-    if (m_tumbler){
-        m_tumbler->Queue(uris, mimes, flavor, "default", 0);
-                         }
+    // The handle comes back asynchronously, so that several requests
+    // can be in flight without blocking on D-Bus round trips
+    QDBusPendingCallWatcher *watcher =
+        new QDBusPendingCallWatcher(m_tumbler->Queue(uris, mimeTypes, flavor,
+                                                     "default", 0), this);
+    m_queuedRequests.insert(watcher, request);
+    connect(watcher,
+            SIGNAL(finished(QDBusPendingCallWatcher*)),
+            SLOT(queuedHandler(QDBusPendingCallWatcher*)));
+}
+
+void DBusThumbnailer::queuedHandler(QDBusPendingCallWatcher *watcher)
+{
+    Request *request = m_queuedRequests.take(watcher);
+    QDBusPendingReply<uint> reply = *watcher;
+    watcher->deleteLater();
+
+    if (!request)
+        return;
+
+    if (!reply.isError()) {
+        m_requests.insert(reply.value(), request);
+        return;
+    }
+
+    const QStringList filePaths = request->filePaths.values();
+    delete request;
+
+    foreach (const QString &filePath, filePaths)
+        emit thumbnailError(filePath, 0, reply.error().message());
+    emit requestFinished();
+}
+
+void DBusThumbnailer::readyHandler(uint handle, const QStringList uris)
+{
+    Request *request = m_requests.value(handle);
+    if (!request)
+        return;
+
+    const QString flavor = request->flavor;
+    foreach (const QString &filePath, request->takeFilePaths(uris))
+        emit thumbnailGenerated(filePath, flavor);
 }
 
 void DBusThumbnailer::finishedHandler(uint handle)
 {
-    Q_UNUSED(handle);
-    emit thumbnailGenerated(m_taskFilePath, m_flavor);
-    m_taskInProgress = false;
+    Request *request = m_requests.take(handle);
+    if (!request)
+        return;
+
+    const QString flavor = request->flavor;
+    const QStringList filePaths = request->filePaths.values();
+    delete request;
+
+    // Files which were not reported separately; the receiver checks
+    // if the thumbnail really exists
+    foreach (const QString &filePath, filePaths)
+        emit thumbnailGenerated(filePath, flavor);
+    emit requestFinished();
 }
 
 void DBusThumbnailer::errorHandler(uint handle, const QStringList failedUris,
                                    int errorCode, const QString message)
 {
-    Q_UNUSED(handle);
-    Q_UNUSED(failedUris);
-    emit thumbnailError(m_taskFilePath, errorCode, message);
+    Request *request = m_requests.value(handle);
+    if (!request)
+        return;
 
+    foreach (const QString &filePath, request->takeFilePaths(failedUris))
+        emit thumbnailError(filePath, errorCode, message);
 }
 
+QStringList DBusThumbnailer::Request::takeFilePaths(const QStringList &uris)
+{
+    QStringList result;
+    foreach (const QString &uri, uris)
+        if (filePaths.contains(uri))
+            result.append(filePaths.take(uri));
+    return result;
+}
@@ -3,7 +3,9 @@
 
 #include <QObject>
 #include <QStringList>
+#include <QHash>
 class ThumbnailerGenericProxy;
+class QDBusPendingCallWatcher;
 
 class DBusThumbnailer : public QObject {
 Q_OBJECT
@@ -15,18 +17,81 @@ friend class ut_dbusthumbnailer;
 
     bool supports(const QString mimeType);
 
+    /*!
+      True if any request to the thumbnailer is outstanding.
+     */
+
     bool isRunning();
 
+    /*!
+      True if no new request can be sent before an outstanding one
+      has finished.
+     */
+
+    bool isFull();
+
+    /*!
+      True if the given file and flavor are part of an outstanding
+      request.
+     */
+
+    bool isPending(const QString &filePath, const QString &flavor) const;
+
+    /*!
+      Sets the maximum number of requests outstanding at the same
+      time. Default is 4.
+     */
+
+    void setMaxRequests(int count);
+
+    int maxRequests() const;
+
+    /*!
+      Sets the maximum number of files sent in one request. Default
+      is 16.
+     */
+
+    void setMaxBatchSize(int count);
+
+    int maxBatchSize() const;
+
+    /*!
+      Uses another D-Bus service instead of the Tumbler one; for
+      testing.
+     */
+
+    void setService(const QString &service);
+
     void newThumbnailerTask(const QString &filePath,
                             const QString &mimeType,
                             const QString &flavor);
 
+    /*!
+      Requests thumbnails of the same flavor for a group of files.
+      Each file gets its own thumbnailGenerated() or thumbnailError()
+      signal.
+     */
+
+    void newThumbnailerTask(const QStringList &filePaths,
+                            const QStringList &mimeTypes,
+                            const QString &flavor);
+
  signals:
     void thumbnailGenerated(const QString filePath, const QString flavor);
     void thumbnailError(const QString filePath, uint errorCode,
                         const QString message);
 
+    /*!
+      A request has finished, so a new one can be sent.
+     */
+
+    void requestFinished();
+
  private slots:
+    void queuedHandler(QDBusPendingCallWatcher *watcher);
+
+    void readyHandler(uint handle, const QStringList uris);
+
     void finishedHandler(uint handle);
 
     void errorHandler(uint handle, const QStringList failedUris,
@@ -36,11 +101,26 @@ friend class ut_dbusthumbnailer;
     void connectDBus();
 
  private:
+    class Request {
+    public:
+        QString flavor;
+        // Files not yet reported, by URI
+        QHash<QString, QString> filePaths;
+
+        QStringList takeFilePaths(const QStringList &uris);
+    };
+
     static QLatin1String tumblerService, tumblerCache;
 
-    bool m_taskInProgress;
-    QString m_taskFilePath;
-    QString m_flavor;
+    QString m_service;
+    int m_maxRequests;
+    int m_maxBatchSize;
+
+    // Requests waiting for their handle from the thumbnailer
+    QHash<QDBusPendingCallWatcher*, Request*> m_queuedRequests;
+    // Requests by their thumbnailer handle
+    QHash<uint, Request*> m_requests;
+
     ThumbnailerGenericProxy *m_tumbler;
 };
 
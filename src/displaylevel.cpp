@@ -101,7 +101,8 @@ QSize DisplayLevel::scaleBounding(const QSize &size, const QSize &boundingBox,
 {
     QSize targetSize;
 
-    int targetWidth = (boundingBox.height() * size.width()
+    // Products of image and preview sizes may not fit in an int
+    int targetWidth = ((qint64)boundingBox.height() * size.width()
                        + size.height() - 1) / size.height();
 
     if (targetWidth <= boundingBox.width() && targetWidth >= minimum.width())
@@ -109,7 +110,7 @@ QSize DisplayLevel::scaleBounding(const QSize &size, const QSize &boundingBox,
     else if (targetWidth < minimum.width())
         targetSize = QSize(minimum.width(), boundingBox.height());
     else {
-        int targetHeight = (boundingBox.width() * size.height()
+        int targetHeight = ((qint64)boundingBox.width() * size.height()
                             + size.width() - 1) / size.width();
         if (targetHeight >= minimum.height())
             targetSize = QSize(boundingBox.width(), targetHeight);
@@ -136,13 +137,13 @@ QRect DisplayLevel::targetArea(const QSize &targetSize,
         else
             return QRect(fullImageSize.width()/2-m_minimumSize.width()/2,0,m_minimumSize.width(),fullImageSize.height());
     }
-    if (targetSize.width() * fullImageSize.height() >
-        targetSize.height() * fullImageSize.width())
+    if ((qint64)targetSize.width() * fullImageSize.height() >
+        (qint64)targetSize.height() * fullImageSize.width())
         size = QSize(fullImageSize.width(),
-                     (targetSize.height() * fullImageSize.width()
+                     ((qint64)targetSize.height() * fullImageSize.width()
                       + m_size.width() - 1) / m_size.width());
     else
-        size = QSize((targetSize.width() * fullImageSize.height()
+        size = QSize(((qint64)targetSize.width() * fullImageSize.height()
                       + m_size.height() - 1) / m_size.height(),
                      fullImageSize.height());
 
@@ -0,0 +1,103 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <libexif/exif-data.h>
+#include <libexif/exif-utils.h>
+#include <QFile>
+#include <QImage>
+#include <QuillImage>
+
+#include "exifthumbnailload.h"
+#include "scaledjpegload.h"
+
+ExifThumbnailLoad::ExifThumbnailLoad(const QString &fileName) :
+    m_fileName(fileName)
+{
+}
+
+ExifThumbnailLoad::~ExifThumbnailLoad()
+{
+}
+
+QuillImage ExifThumbnailLoad::apply(const QuillImage &image)
+{
+    const QSize fullImageSize = image.fullImageSize();
+    if (fullImageSize.isEmpty() || image.targetSize().isEmpty())
+        return QuillImage();
+
+    ExifData *exifData =
+        exif_data_new_from_file(QFile::encodeName(m_fileName).constData());
+    if (!exifData)
+        return QuillImage();
+
+    QImage thumbnail;
+    if (exifData->data && (exifData->size > 0))
+        thumbnail = QImage::fromData((const uchar *) exifData->data,
+                                     exifData->size, "JPEG");
+
+    int orientation = 1;
+    ExifEntry *entry = exif_content_get_entry(exifData->ifd[EXIF_IFD_0],
+                                              EXIF_TAG_ORIENTATION);
+    if (entry && (entry->format == EXIF_FORMAT_SHORT))
+        orientation = exif_get_short(entry->data,
+                                     exif_data_get_byte_order(exifData));
+
+    exif_data_unref(exifData);
+
+    if (thumbnail.isNull())
+        return QuillImage();
+
+    thumbnail = ScaledJpegLoad::orient(thumbnail, orientation);
+
+    // Letterboxed or otherwise mismatching thumbnails are not used
+    const qreal aspectRatio =
+        (qreal)fullImageSize.width() / fullImageSize.height();
+    const qreal thumbnailAspectRatio =
+        (qreal)thumbnail.width() / thumbnail.height();
+    if (qAbs(aspectRatio - thumbnailAspectRatio) > 0.05 * aspectRatio)
+        return QuillImage();
+
+    return ScaledJpegLoad::fitToLevel(
+        thumbnail.convertToFormat(QImage::Format_RGB32), image);
+}
+
+QString ExifThumbnailLoad::name() const
+{
+    return QString("ExifThumbnailLoad");
+}
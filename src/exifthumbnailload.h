@@ -0,0 +1,77 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class ExifThumbnailLoad
+
+  \brief Reads the thumbnail embedded in the EXIF block of a JPEG
+  file, to be shown until the real preview is ready.
+
+Most camera images carry a small thumbnail of their own, which can be
+read and decoded much faster than the image itself. The embedded
+thumbnail is rotated according to the EXIF orientation of the image
+and fitted to the area and target size of the preview level given as
+input. A null image is returned if the file has no thumbnail, or if
+its aspect ratio does not match the image (e.g. letterboxed
+thumbnails).
+ */
+
+#ifndef EXIF_THUMBNAIL_LOAD_H
+#define EXIF_THUMBNAIL_LOAD_H
+
+#include <QString>
+
+#include "task.h"
+
+class ExifThumbnailLoad : public TaskOperation
+{
+public:
+    ExifThumbnailLoad(const QString &fileName);
+
+    ~ExifThumbnailLoad();
+
+    QuillImage apply(const QuillImage &image);
+
+    QString name() const;
+
+private:
+    QString m_fileName;
+};
+
+#endif // EXIF_THUMBNAIL_LOAD_H
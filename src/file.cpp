@@ -55,14 +55,20 @@
 #include "regionsofinterest.h"
 #include "logger.h"
 #include "strings.h"
+#include "jpegdecodersession.h"
 
 const int File::timestampTolerance = 1;
 
 File::File() : m_state(State_Normal),
                m_hasThumbnailError(false),
+               m_isExifPreviewRequested(false),
                m_displayLevel(-1), m_priority(QuillFile::Priority_Normal),
                m_fileName(""), m_originalFileName(""),
                m_fileFormat(""), m_targetFormat(""), m_viewPort(QRect()),
+               m_movedViewPort(QRect()), m_viewPortVelocity(QPoint()), m_isZoomingIn(false),
+               m_tileZoomLevel(0), m_previewCommandId(0),
+               m_hasCheckedHistoryPreviews(false),
+               m_hasValidHistoryPreviews(false),
                m_temporaryFile(0),m_original(false),
                m_hasReadEditHistory(false),m_fileIndexName(""),
                m_error(QuillError::NoError)
@@ -89,6 +95,7 @@ void File::removeReference(QuillFile *file)
 {
     if (m_references.contains(file)) {
         m_references.removeOne(file);
+        mergeViewPorts();
         //Trying to lower the display level to purge the cached images
         setDisplayLevel(-1);
         // Recalculate priority from remaining references
@@ -201,6 +208,17 @@ bool File::setDisplayLevel(int level)
     if (level > originalDisplayLevel)
             Core::instance()->suggestNewTask();
 
+    // Tiles prepared for a zoom can be shown right away
+    if ((m_displayLevel > originalDisplayLevel) &&
+        (m_displayLevel == Core::instance()->previewLevelCount()) &&
+        Core::instance()->isViewPortPredictionEnabled() &&
+        m_stack->command() && m_stack->command()->tileMap()) {
+        QList<QuillImage> tiles =
+            m_stack->command()->tileMap(m_tileZoomLevel)->nonEmptyTiles(viewPorts());
+        if (!tiles.isEmpty())
+            emitTiles(tiles);
+    }
+
     return true;
 }
 
@@ -226,6 +244,10 @@ void File::setDisplayLevelInternal(int level)
 
     m_displayLevel = level;
 
+    // Decoded strips are only needed for tiles
+    if (m_displayLevel < Core::instance()->previewLevelCount())
+        m_decoderSession.clear();
+
     // setup stack here
     if (m_stack->isClean() && (state() != State_NonExistent))
         m_stack->load();
@@ -250,8 +272,42 @@ int File::priority() const
     return m_priority;
 }
 
+bool File::isExifPreviewRequested() const
+{
+    return m_isExifPreviewRequested;
+}
+
+void File::setExifPreviewRequested()
+{
+    m_isExifPreviewRequested = true;
+}
+
+QSharedPointer<JpegDecoderSession> File::decoderSession(const QString &fileName)
+{
+    if (m_decoderSession.isNull() || (m_decoderSessionFileName != fileName)) {
+        m_decoderSession = QSharedPointer<JpegDecoderSession>(
+            new JpegDecoderSession(fileName,
+                                   (qint64)Core::instance()->decodedStripCacheSize() * 4));
+        m_decoderSessionFileName = fileName;
+    }
+    return m_decoderSession;
+}
+
+bool File::isPrefetchOnly() const
+{
+    if (m_references.isEmpty())
+        return false;
+
+    foreach (QuillFile *file, m_references)
+        if (!Core::instance()->isPrefetchReference(file))
+            return false;
+    return true;
+}
+
 void File::save()
 {
+    commitPreview();
+
     if ((state() == State_Normal) && isDirty())
     {
         prepareSave();
@@ -279,6 +335,8 @@ void File::runFilter(QuillImageFilter *filter)
         return;
     }
 
+    commitPreview();
+
     if (m_stack->isClean())
         m_stack->load();
     m_stack->add(filter);
@@ -287,14 +345,74 @@ void File::runFilter(QuillImageFilter *filter)
     Core::instance()->suggestNewTask();
 }
 
+void File::previewFilter(QuillImageFilter *filter)
+{
+    if (!supportsEditing()) {
+        delete filter;
+        return;
+    }
+
+    // The superseded preview is dropped. If its filter is still
+    // running, the result will be ignored.
+    if (isPreviewingFilter())
+        m_stack->undo();
+
+    if (m_stack->isClean())
+        m_stack->load();
+    m_stack->add(filter);
+    m_previewCommandId = m_stack->command()->uniqueId();
+
+    abortSave();
+    Core::instance()->suggestNewTask();
+}
+
+void File::commitPreview()
+{
+    if (!m_previewCommandId)
+        return;
+
+    m_previewCommandId = 0;
+    Core::instance()->suggestNewTask();
+}
+
+void File::cancelPreview()
+{
+    if (!isPreviewingFilter()) {
+        m_previewCommandId = 0;
+        return;
+    }
+
+    m_stack->undo();
+    m_previewCommandId = 0;
+    dropRedoHistory();
+
+    Core::instance()->suggestNewTask();
+    emitAllImages();
+}
+
+bool File::isPreviewingFilter() const
+{
+    return m_previewCommandId && m_stack && m_stack->command() &&
+        (m_stack->command()->uniqueId() == m_previewCommandId);
+}
+
+int File::filterPreviewLevel() const
+{
+    return qMin(m_displayLevel, Core::instance()->previewLevelCount() - 1);
+}
+
 void File::startSession()
 {
+    commitPreview();
+
     if (supportsEditing())
         m_stack->startSession();
 }
 
 void File::endSession()
 {
+    commitPreview();
+
     if (supportsEditing())
         m_stack->endSession();
 }
@@ -313,6 +431,8 @@ bool File::canUndo() const
 
 void File::undo()
 {
+    commitPreview();
+
     if (canUndo())
     {
         m_stack->undo();
@@ -334,6 +454,8 @@ bool File::canRedo() const
 
 void File::redo()
 {
+    commitPreview();
+
     if (canRedo())
     {
         m_stack->redo();
@@ -397,7 +519,7 @@ QList<QuillImage> File::allImageLevels(int displayLevel) const
         return m_stack->allImageLevels(displayLevel);
     else
         return m_stack->allImageLevels(displayLevel) +
-            m_stack->command()->tileMap()->nonEmptyTiles(m_viewPort);
+            m_stack->command()->tileMap(m_tileZoomLevel)->nonEmptyTiles(viewPorts());
 }
 
 QSize File::fullImageSize() const
@@ -415,26 +537,45 @@ QSize File::fullImageSize() const
     return m_stack->fullImageSize();
 }
 
-void File::setViewPort(const QRect &viewPort)
+void File::setViewPort(QuillFile *reference, const QRect &oldPort)
 {
-    const QRect oldPort = m_viewPort;
-    m_viewPort = viewPort;
+    const QRect viewPort = reference->viewPort();
+    mergeViewPorts();
+
+    // Motion tracking for viewport prediction
+    m_movedViewPort = viewPort;
+    if (oldPort.isValid() && viewPort.isValid()) {
+        m_viewPortVelocity = viewPort.center() - oldPort.center();
+        m_isZoomingIn = (qint64)viewPort.width() * viewPort.height() <
+            (qint64)oldPort.width() * oldPort.height();
+    } else {
+        m_viewPortVelocity = QPoint();
+        m_isZoomingIn = false;
+    }
+
+    if (!supportsViewing())
+        return;
 
     // New tiles will only be calculated if the display level allows it
-    if (!supportsViewing() ||
-        (m_displayLevel < Core::instance()->previewLevelCount()))
+    if (m_displayLevel < Core::instance()->previewLevelCount()) {
+        // ...except for preparing the next level for a zoom
+        if (m_isZoomingIn && Core::instance()->isViewPortPredictionEnabled())
+            Core::instance()->suggestNewTask();
         return;
+    }
 
     Core::instance()->suggestNewTask();
 
     QList<QuillImage> newTiles;
 
     if ((m_stack->command()) && (m_stack->command()->tileMap()))
-        newTiles = m_stack->command()->tileMap()->
+        newTiles = m_stack->command()->tileMap(m_tileZoomLevel)->
         newTiles(oldPort, viewPort);
 
-    if (!newTiles.isEmpty())
-        emitTiles(newTiles);
+    // Only the object which moved its viewport needs these
+    if (!newTiles.isEmpty() &&
+        (reference->displayLevel() == Core::instance()->previewLevelCount()))
+        reference->emitImageAvailable(newTiles);
 }
 
 QRect File::viewPort() const
@@ -442,6 +583,75 @@ QRect File::viewPort() const
     return m_viewPort;
 }
 
+QList<QRect> File::viewPorts() const
+{
+    QList<QuillFile*> references = m_references;
+    QList<QRect> result;
+
+    // Highest priority first, in order of reference otherwise
+    while (!references.isEmpty()) {
+        QuillFile *best = references.first();
+        foreach (QuillFile *file, references)
+            if (file->priority() > best->priority())
+                best = file;
+        references.removeOne(best);
+
+        if (best->viewPort().isValid())
+            result.append(best->viewPort());
+    }
+    return result;
+}
+
+void File::mergeViewPorts()
+{
+    m_viewPort = QRect();
+    foreach (QuillFile *file, m_references)
+        if (file->viewPort().isValid())
+            m_viewPort = m_viewPort.united(file->viewPort());
+}
+
+QRect File::predictedViewPort() const
+{
+    const QPoint step(qBound(-m_movedViewPort.width(), m_viewPortVelocity.x(),
+                             m_movedViewPort.width()),
+                      qBound(-m_movedViewPort.height(), m_viewPortVelocity.y(),
+                             m_movedViewPort.height()));
+    return m_movedViewPort.translated(step);
+}
+
+bool File::isZoomingIn() const
+{
+    return m_isZoomingIn;
+}
+
+void File::setTileZoomLevel(int level)
+{
+    level = qMax(level, 0);
+    if (level == m_tileZoomLevel)
+        return;
+
+    m_tileZoomLevel = level;
+
+    if (!supportsViewing() ||
+        (m_displayLevel < Core::instance()->previewLevelCount()))
+        return;
+
+    Core::instance()->suggestNewTask();
+
+    // Tiles of the new level which are already there
+    if (m_stack->command() && m_stack->command()->tileMap()) {
+        QList<QuillImage> tiles =
+            m_stack->command()->tileMap(m_tileZoomLevel)->nonEmptyTiles(viewPorts());
+        if (!tiles.isEmpty())
+            emitTiles(tiles);
+    }
+}
+
+int File::tileZoomLevel() const
+{
+    return m_tileZoomLevel;
+}
+
 bool File::checkImageSize(const QSize &fullImageSize)
 {
     const QSize imageSizeLimit = Core::instance()->imageSizeLimit();
@@ -453,7 +663,7 @@ bool File::checkImageSize(const QSize &fullImageSize)
         (fullImageSize.boundedTo(imageSizeLimit) != fullImageSize))
         return false;
 
-    int imagePixelsLimit = 0;
+    qint64 imagePixelsLimit = 0;
     if (!isJpeg())
         imagePixelsLimit = Core::instance()->nonTiledImagePixelsLimit();
 
@@ -461,7 +671,7 @@ bool File::checkImageSize(const QSize &fullImageSize)
         imagePixelsLimit = Core::instance()->imagePixelsLimit();
 
     if ((imagePixelsLimit > 0) &&
-        (fullImageSize.width() * fullImageSize.height() > imagePixelsLimit))
+        ((qint64)fullImageSize.width() * fullImageSize.height() > imagePixelsLimit))
         return false;
     else
         return true;
@@ -597,6 +807,129 @@ QString File::editHistoryFileName(const QString &fileName,
     return hashValueString;
 }
 
+QString File::historyPreviewPath(const QString &fileName,
+                                 const QString &editHistoryPath)
+{
+    QString hashValueString = filePathHash(fileName);
+    hashValueString.append(Strings::dotPreviews);
+    hashValueString.prepend(editHistoryPath + QDir::separator());
+
+    return hashValueString;
+}
+
+static void removeFiles(QDir dir)
+{
+    foreach (const QString &entry, dir.entryList(QDir::Files))
+        dir.remove(entry);
+}
+
+static QString previewFileName(const QString &path,
+                               QuillUndoCommand *command, int level)
+{
+    return path + QDir::separator() +
+        QString::fromLatin1(command->resultKey().toHex()) +
+        Strings::dot + QString::number(level) + Strings::dot + Strings::png;
+}
+
+QString File::historyPreviewFileName(QuillUndoCommand *command, int level)
+{
+    // Unedited files have no states stored
+    if (!Core::instance()->isEditHistoryPreviewsEnabled() ||
+        (level >= Core::instance()->previewLevelCount()) ||
+        (m_stack->count() < 2))
+        return QString();
+
+    if (!hasValidHistoryPreviews() || command->resultKey().isEmpty())
+        return QString();
+
+    return previewFileName(
+        historyPreviewPath(m_fileName, Core::instance()->editHistoryPath()),
+        command, level);
+}
+
+void File::storeHistoryPreview(QuillUndoCommand *command, int level,
+                               const QuillImage &image)
+{
+    // Unedited files do not need their states stored
+    if (!Core::instance()->isEditHistoryPreviewsEnabled() ||
+        (level >= Core::instance()->previewLevelCount()) ||
+        image.isNull() || (m_stack->count() < 2) ||
+        command->resultKey().isEmpty())
+        return;
+
+    // Removes any leftovers of another version of the file first
+    hasValidHistoryPreviews();
+
+    // Encoding is left to the background thread; once stored, the
+    // preview can be read again
+    const QString fileName = previewFileName(
+        historyPreviewPath(m_fileName, Core::instance()->editHistoryPath()),
+        command, level);
+    Core::instance()->queueStoredImage(fileName, image);
+    m_requestedStoredImages.remove(fileName);
+}
+
+bool File::requestStoredImage(const QString &fileName)
+{
+    if (m_requestedStoredImages.contains(fileName))
+        return false;
+
+    m_requestedStoredImages.insert(fileName);
+    return true;
+}
+
+bool File::hasValidHistoryPreviews()
+{
+    if (m_hasCheckedHistoryPreviews)
+        return m_hasValidHistoryPreviews;
+
+    m_hasCheckedHistoryPreviews = true;
+
+    QDir dir(historyPreviewPath(m_fileName,
+                                Core::instance()->editHistoryPath()));
+    if (!dir.exists())
+        return false;
+
+    QFile stamp(dir.filePath(Strings::previewStamp));
+    if (stamp.open(QIODevice::ReadOnly) &&
+        (QString::fromLatin1(stamp.readAll()) ==
+         QFileInfo(m_fileName).lastModified().toString(Qt::ISODate)))
+        m_hasValidHistoryPreviews = true;
+    else
+        // The file has been changed since the previews were stored
+        removeFiles(dir);
+
+    return m_hasValidHistoryPreviews;
+}
+
+void File::stampHistoryPreviews()
+{
+    if (!Core::instance()->isEditHistoryPreviewsEnabled() ||
+        (m_stack->count() < 2))
+        return;
+
+    hasValidHistoryPreviews();
+
+    const QString path =
+        historyPreviewPath(m_fileName, Core::instance()->editHistoryPath());
+    if (!QDir().mkpath(path))
+        return;
+
+    QFile stamp(QDir(path).filePath(Strings::previewStamp));
+    if (!stamp.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+    stamp.write(m_lastModified.toString(Qt::ISODate).toLatin1());
+    stamp.close();
+
+    m_hasValidHistoryPreviews = true;
+
+    for (int index=0; index<m_stack->count(); index++)
+        for (int level=0; level<Core::instance()->previewLevelCount(); level++) {
+            QuillUndoCommand *command = m_stack->command(index);
+            storeHistoryPreview(command, level, command->image(level));
+        }
+}
+
 void File::readFromEditHistory(const QString &fileName,
                                QuillError *error)
 {
@@ -680,6 +1013,13 @@ void File::writeEditHistory(const QString &history, QuillError *error)
 
 void File::emitSingleImage(QuillImage image, int level)
 {
+    // Tiles only go to the viewports which need them
+    if ((level == Core::instance()->previewLevelCount()) &&
+        !Core::instance()->defaultTileSize().isEmpty()) {
+        emitTiles(QList<QuillImage>() << image);
+        return;
+    }
+
     foreach(QuillFile *file, m_references)
         if (Core::instance()->isSubstituteLevel(level, file->displayLevel()))
             file->emitImageAvailable(image);
@@ -687,9 +1027,28 @@ void File::emitSingleImage(QuillImage image, int level)
 
 void File::emitTiles(QList<QuillImage> tiles)
 {
-    foreach(QuillFile *file, m_references)
-        if (file->displayLevel() == Core::instance()->previewLevelCount())
-            file->emitImageAvailable(tiles);
+    foreach(QuillFile *file, m_references) {
+        if (file->displayLevel() != Core::instance()->previewLevelCount())
+            continue;
+
+        // Tiles which no viewport needs (e.g. prefetched ones) go to
+        // everybody, the rest only where they are visible
+        QList<QuillImage> fileTiles;
+        foreach (const QuillImage &tile, tiles) {
+            bool isVisible = false, isVisibleHere = false;
+            foreach (QuillFile *other, m_references)
+                if (other->viewPort().intersects(tile.area())) {
+                    isVisible = true;
+                    if (other == file)
+                        isVisibleHere = true;
+                }
+            if (!isVisible || isVisibleHere || !file->viewPort().isValid())
+                fileTiles.append(tile);
+        }
+
+        if (!fileTiles.isEmpty())
+            file->emitImageAvailable(fileTiles);
+    }
 }
 
 void File::emitAllImages()
@@ -710,6 +1069,10 @@ void File::remove()
     QFile(m_originalFileName).remove();
     QFile::remove(editHistoryFileName(m_fileName,
                                       Core::instance()->editHistoryPath()));
+    const QString previewPath =
+        historyPreviewPath(m_fileName, Core::instance()->editHistoryPath());
+    removeFiles(QDir(previewPath));
+    QDir().rmdir(previewPath);
     removeThumbnails();
 
     abortSave();
@@ -966,6 +1329,7 @@ void File::concludeSave()
 
     removeThumbnails();
     refreshLastModified();
+    stampHistoryPreviews();
 
     emit saved();
     Core::instance()->emitSaved(m_fileName);
@@ -1127,6 +1491,8 @@ bool File::canRevert() const
 
 void File::revert()
 {
+    commitPreview();
+
     if (canRevert()){
         m_stack->revert();
         abortSave();
@@ -1145,6 +1511,8 @@ bool File::canRestore() const
 
 void File::restore()
 {
+    commitPreview();
+
     if(canRestore()){
         m_stack->restore();
         abortSave();
@@ -43,6 +43,8 @@
 #include <QMetaType>
 #include <QList>
 #include <QFile>
+#include <QSharedPointer>
+#include <QSet>
 #include <QuillImageFilter>
 
 #include "quill.h"
@@ -51,6 +53,7 @@
 
 class QTemporaryFile;
 class QuillMetadata;
+class JpegDecoderSession;
 
 class File : public QObject
 {
@@ -209,6 +212,36 @@ public:
 
     int priority() const;
 
+    /*!
+      Returns true if the file is only referred to by the file objects
+      Core has created for prefetching (see Quill::setPrefetchHint()).
+    */
+
+    bool isPrefetchOnly() const;
+
+    /*!
+      Returns true if a provisional preview from the embedded EXIF
+      thumbnail has already been requested for the file.
+    */
+
+    bool isExifPreviewRequested() const;
+
+    /*!
+      Returns the decoder session used for loading the tiles of the
+      file from the given source file, creating it if needed. The
+      session is dropped when the file is no longer shown at full
+      resolution.
+    */
+
+    QSharedPointer<JpegDecoderSession> decoderSession(const QString &fileName);
+
+    /*!
+      Marks the EXIF thumbnail preview as requested, so that it is only
+      tried once.
+    */
+
+    void setExifPreviewRequested();
+
     /*!
       Starts to asynchronously save any changes made to the file (if
       any). If there were any changes, the saved() signal is emitted
@@ -242,6 +275,63 @@ public:
 
     void runFilter(QuillImageFilter *filter);
 
+    /*!
+      Runs a filter as an interactive preview, replacing the previous
+      preview if there is one. See QuillFile::previewFilter().
+     */
+
+    void previewFilter(QuillImageFilter *filter);
+
+    /*!
+      Makes the current filter preview a normal edit.
+     */
+
+    void commitPreview();
+
+    /*!
+      Drops the current filter preview.
+     */
+
+    void cancelPreview();
+
+    /*!
+      If a filter preview is in progress.
+     */
+
+    bool isPreviewingFilter() const;
+
+    /*!
+      The only display level calculated during a filter preview.
+     */
+
+    int filterPreviewLevel() const;
+
+    /*!
+      Returns the file where a preview of an edit history state may
+      have been stored in an earlier session, or an empty path if
+      there can be none. The preview is read by a background task. See
+      Quill::setEditHistoryPreviewsEnabled().
+     */
+
+    QString historyPreviewFileName(QuillUndoCommand *command, int level);
+
+    /*!
+      Queues a preview of an edit history state to be stored by a
+      background task, if the file has been edited and stored previews
+      are enabled.
+     */
+
+    void storeHistoryPreview(QuillUndoCommand *command, int level,
+                             const QuillImage &image);
+
+    /*!
+      Marks an image stored on disk as requested for this file, so
+      that a missing image is only searched for once. Returns false if
+      the image has already been requested.
+     */
+
+    bool requestStoredImage(const QString &fileName);
+
     /*!
       Starts an undo session. When an undo session is in progress,
       no undo/redo outside the session is permitted. A closed
@@ -346,21 +436,56 @@ public:
     QSize fullImageSize() const;
 
     /*!
-      Sets the viewport area (in full-image coordinates), only
-      takes effect if tiling is in use. Only tiles within the viewport
-      will be processed and returned. The default is no viewport
-      (e.g. no tiles will be returned).
+      Called by a referring QuillFile object after its viewport has
+      changed (see QuillFile::setViewPort()).
+      @param reference the QuillFile object
+      @param oldPort the previous viewport of the object
     */
 
-    void setViewPort(const QRect &viewPort);
+    void setViewPort(QuillFile *reference, const QRect &oldPort);
 
     /*!
-      Returns the viewport in full-image coordinates. Only tiles
-      within the viewport will be processed and returned.
+      Returns the union of the viewports of all referring QuillFile
+      objects, in full-image coordinates. Only tiles within the
+      viewport will be processed.
      */
 
     QRect viewPort() const;
 
+    /*!
+      Returns the viewports of all referring QuillFile objects, the
+      ones of the highest priority first.
+     */
+
+    QList<QRect> viewPorts() const;
+
+    /*!
+      Returns the viewport which was moved last, moved one more step
+      in the same direction, by at most its own size. Used for
+      prefetching tiles when viewport prediction is enabled.
+     */
+
+    QRect predictedViewPort() const;
+
+    /*!
+      Returns true if the last viewport change made the viewport
+      smaller, i.e. the user is zooming in.
+     */
+
+    bool isZoomingIn() const;
+
+    /*!
+      See QuillFile::setTileZoomLevel().
+     */
+
+    void setTileZoomLevel(int level);
+
+    /*!
+      See QuillFile::tileZoomLevel().
+     */
+
+    int tileZoomLevel() const;
+
     /*!
       Check if an image size passes the maximum image size constraints.
      */
@@ -601,7 +726,9 @@ public:
 
     /*!
       A set of new tiles is available, instructs all referring QuillFile
-      objects with a high enough display level to emit a signal.
+      objects with a high enough display level to emit a signal. Tiles
+      inside any viewport are only sent to the objects whose viewports
+      contain them.
      */
 
     void emitTiles(QList<QuillImage> tiles);
@@ -678,6 +805,11 @@ public:
      */
     void touchThumbnail(int level);
 
+    /*!
+      If the file is a JPEG file
+     */
+    bool isJpeg() const;
+
      /*!
       If the file is a SVG file
      */
@@ -706,13 +838,33 @@ signals:
     void error(QuillError error);
 
 private:
-    bool isJpeg() const;
-
     void prepareSave();
 
     static QString editHistoryFileName(const QString &fileName,
                                        const QString &editHistoryDirectory);
 
+    /*!
+      The directory of the stored previews of the edit history
+      states, next to the edit history.
+     */
+
+    static QString historyPreviewPath(const QString &fileName,
+                                      const QString &editHistoryDirectory);
+
+    /*!
+      Checks once per session that the stored previews belong to the
+      current version of the file, and removes them otherwise.
+     */
+
+    bool hasValidHistoryPreviews();
+
+    /*!
+      Marks the stored previews as belonging to the saved file, and
+      queues the previews which are currently cached to be stored.
+     */
+
+    void stampHistoryPreviews();
+
     /*!
       Writes the edit history.
      */
@@ -732,6 +884,12 @@ private:
       */
     void setDisplayLevelInternal(int level);
 
+    /*!
+      Recalculates the union of the viewports of all referring
+      QuillFile objects.
+      */
+    void mergeViewPorts();
+
 private:
 
     static const int timestampTolerance;
@@ -750,10 +908,14 @@ private:
     State m_state;
 
     bool m_hasThumbnailError;
+    bool m_isExifPreviewRequested;
     QDateTime m_lastModified;
 
     QuillUndoStack *m_stack;
 
+    QSharedPointer<JpegDecoderSession> m_decoderSession;
+    QString m_decoderSessionFileName;
+
     int m_displayLevel;
     int m_priority;
     QMap<int, ThumbnailExistenceState> m_hasThumbnail; //! Caches information of thumbnail existence in the file system. Absent values are interpreted as Thumbnail_UnknownExists.
@@ -765,6 +927,19 @@ private:
     QString m_fileNameHash;
 
     QRect m_viewPort;
+    QRect m_movedViewPort;
+    QPoint m_viewPortVelocity;
+    bool m_isZoomingIn;
+    int m_tileZoomLevel;
+
+    //the command of the filter preview, 0 if there is none
+    int m_previewCommandId;
+
+    //if the stored history previews have been checked, and the result
+    bool m_hasCheckedHistoryPreviews;
+    bool m_hasValidHistoryPreviews;
+    //the images stored on disk which have been requested
+    QSet<QString> m_requestedStoredImages;
 
     QTemporaryFile *m_temporaryFile;
     //one flag for the original file
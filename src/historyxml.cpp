@@ -160,6 +160,14 @@ QByteArray HistoryXml::encode(QList<File *> files)
         return result;
     }
 
+QByteArray HistoryXml::encodeFilter(QuillImageFilter *filter)
+{
+    QByteArray result;
+    QXmlStreamWriter writer(&result);
+    writeFilter(filter, &writer);
+    return result;
+}
+
 void HistoryXml::writeFilter(QuillImageFilter *filter, QXmlStreamWriter *writer)
 {
     writer->writeStartElement(Strings::xmlNamespace,
@@ -75,6 +75,12 @@ public:
     static bool decodeOne(const QByteArray & array,File* file);
     static bool decode(const QByteArray & array,File* file);
 
+    /*!
+      Serializes a single filter with all its options, in the same
+      format as in edit histories.
+     */
+    static QByteArray encodeFilter(QuillImageFilter *filter);
+
 private:
     static void writeFilter(QuillImageFilter *filter, QXmlStreamWriter *writer);
     static bool writeComplexType(const QVariant &variant, QXmlStreamWriter *writer);
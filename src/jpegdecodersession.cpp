@@ -0,0 +1,280 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <QFile>
+#include <QFileInfo>
+#include <QuillMetadata>
+
+#include "jpegdecodersession.h"
+
+JpegDecoderSession::JpegDecoderSession(const QString &fileName,
+                                       qint64 maxBytes) :
+    m_fileName(fileName), m_orientation(-1), m_input(0),
+    m_isDecoding(false), m_isUnsupported(false), m_nextStrip(0),
+    m_bytes(0), m_maxBytes(maxBytes), m_startCount(0)
+{
+}
+
+JpegDecoderSession::~JpegDecoderSession()
+{
+    finish();
+}
+
+QImage JpegDecoderSession::read(const QRect &area, bool ignoreExifOrientation)
+{
+    if (area.isEmpty())
+        return QImage();
+
+    // A changed file invalidates everything decoded so far
+
+    const QDateTime lastModified = QFileInfo(m_fileName).lastModified();
+    if (lastModified != m_lastModified) {
+        reset();
+        m_lastModified = lastModified;
+    }
+
+    if (m_isUnsupported)
+        return QImage();
+
+    if (!ignoreExifOrientation) {
+        if (m_orientation == -1) {
+            QuillMetadata metadata(m_fileName, QuillMetadata::ExifFormat);
+            m_orientation =
+                metadata.entry(QuillMetadata::Tag_Orientation).toInt();
+        }
+        // Tile areas are in rotated coordinates, left to the load filter
+        if (m_orientation > 1)
+            return QImage();
+    }
+
+    // Declared before setjmp() so that an error does not skip its
+    // destructor.
+    QImage result;
+
+    if (setjmp(m_errorManager.setjmpBuffer)) {
+        finish();
+        m_isUnsupported = true;
+        return QImage();
+    }
+
+    if (m_imageSize.isEmpty() && !start()) {
+        m_isUnsupported = true;
+        return QImage();
+    }
+
+    if (!QRect(QPoint(0, 0), m_imageSize).contains(area))
+        return QImage();
+
+    const int firstStrip = area.top() / StripHeight;
+    const int lastStrip = area.bottom() / StripHeight;
+
+    for (int strip=firstStrip; strip<=lastStrip; strip++) {
+        if (m_strips.contains(strip))
+            continue;
+
+        // The decoder has already passed the strip, restart from the top
+        if (!m_isDecoding || (m_nextStrip > strip)) {
+            finish();
+            if (!start()) {
+                m_isUnsupported = true;
+                return QImage();
+            }
+        }
+
+        while (m_nextStrip <= strip)
+            decodeStrip(firstStrip, lastStrip);
+    }
+
+    for (int strip=firstStrip; strip<=lastStrip; strip++) {
+        m_recentStrips.removeOne(strip);
+        m_recentStrips.append(strip);
+    }
+
+    result = QImage(area.size(), QImage::Format_RGB32);
+
+    for (int strip=firstStrip; strip<=lastStrip; strip++) {
+        const QImage stripImage = m_strips.value(strip);
+        const int top = qMax(area.top(), strip * StripHeight);
+        const int bottom = qMin(area.bottom(), (strip + 1) * StripHeight - 1);
+
+        for (int y=top; y<=bottom; y++)
+            memcpy(result.scanLine(y - area.top()),
+                   stripImage.scanLine(y - strip * StripHeight) +
+                   area.left() * sizeof(QRgb),
+                   area.width() * sizeof(QRgb));
+    }
+
+    return result;
+}
+
+qint64 JpegDecoderSession::bytes() const
+{
+    return m_bytes;
+}
+
+int JpegDecoderSession::startCount() const
+{
+    return m_startCount;
+}
+
+bool JpegDecoderSession::start()
+{
+    m_input = fopen(QFile::encodeName(m_fileName).constData(), "rb");
+    if (!m_input)
+        return false;
+
+    m_info.err = m_errorManager.init();
+    jpeg_create_decompress(&m_info);
+    m_isDecoding = true;
+
+    jpeg_stdio_src(&m_info, m_input);
+    jpeg_read_header(&m_info, TRUE);
+
+    // Progressive files need the whole image in memory anyway, and
+    // other color spaces are left to the load filter
+    if (m_info.progressive_mode ||
+        ((m_info.jpeg_color_space != JCS_GRAYSCALE) &&
+         (m_info.jpeg_color_space != JCS_YCbCr) &&
+         (m_info.jpeg_color_space != JCS_RGB))) {
+        finish();
+        return false;
+    }
+
+    m_info.out_color_space =
+        (m_info.jpeg_color_space == JCS_GRAYSCALE) ? JCS_GRAYSCALE : JCS_RGB;
+
+    jpeg_start_decompress(&m_info);
+
+    const QSize imageSize(m_info.output_width, m_info.output_height);
+    if (!m_imageSize.isEmpty() && (imageSize != m_imageSize)) {
+        finish();
+        return false;
+    }
+
+    m_imageSize = imageSize;
+    m_row.resize(m_info.output_width * m_info.output_components);
+    m_nextStrip = 0;
+    m_startCount++;
+
+    return true;
+}
+
+void JpegDecoderSession::finish()
+{
+    if (m_isDecoding) {
+        jpeg_destroy_decompress(&m_info);
+        m_isDecoding = false;
+    }
+    if (m_input) {
+        fclose(m_input);
+        m_input = 0;
+    }
+    m_strip = QImage();
+}
+
+void JpegDecoderSession::reset()
+{
+    finish();
+    m_strips.clear();
+    m_recentStrips.clear();
+    m_bytes = 0;
+    m_imageSize = QSize();
+    m_orientation = -1;
+    m_isUnsupported = false;
+    m_nextStrip = 0;
+}
+
+void JpegDecoderSession::decodeStrip(int firstWanted, int lastWanted)
+{
+    const int height =
+        qMin(StripHeight, m_imageSize.height() - m_nextStrip * StripHeight);
+
+    // Strips above the wanted ones are only decoded to get past them
+    const bool isWanted = (m_nextStrip >= firstWanted) &&
+        (m_nextStrip <= lastWanted) && !m_strips.contains(m_nextStrip);
+
+    if (isWanted)
+        m_strip = QImage(m_imageSize.width(), height, QImage::Format_RGB32);
+
+    for (int y=0; y<height; y++) {
+        JSAMPROW rowPointer = m_row.data();
+        jpeg_read_scanlines(&m_info, &rowPointer, 1);
+
+        if (!isWanted)
+            continue;
+
+        QRgb *target = (QRgb*) m_strip.scanLine(y);
+        const JSAMPLE *sample = m_row.constData();
+        if (m_info.output_components == 1)
+            for (int x=0; x<m_imageSize.width(); x++, sample++)
+                target[x] = qRgb(sample[0], sample[0], sample[0]);
+        else
+            for (int x=0; x<m_imageSize.width(); x++, sample+=3)
+                target[x] = qRgb(sample[0], sample[1], sample[2]);
+    }
+
+    if (isWanted) {
+        m_strips.insert(m_nextStrip, m_strip);
+        m_recentStrips.append(m_nextStrip);
+        m_bytes += (qint64)m_strip.bytesPerLine() * m_strip.height();
+        m_strip = QImage();
+        shrink(firstWanted, lastWanted);
+    }
+
+    m_nextStrip++;
+
+    // Nothing left to decode
+    if (m_nextStrip * StripHeight >= m_imageSize.height())
+        finish();
+}
+
+void JpegDecoderSession::shrink(int firstWanted, int lastWanted)
+{
+    int i = 0;
+    while ((m_bytes > m_maxBytes) && (i < m_recentStrips.count())) {
+        const int strip = m_recentStrips.at(i);
+        if ((strip >= firstWanted) && (strip <= lastWanted)) {
+            i++;
+            continue;
+        }
+        const QImage image = m_strips.take(strip);
+        m_bytes -= (qint64)image.bytesPerLine() * image.height();
+        m_recentStrips.removeAt(i);
+    }
+}
@@ -0,0 +1,173 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class JpegDecoderSession
+
+  \brief Keeps a JPEG decoder and a cache of decoded strips of a file
+  between tile loads.
+
+Baseline JPEG data can only be decoded from the top down, so loading
+each tile of a large image separately means decoding most of the file
+again for every tile. A session keeps the decoder open at the row where
+it stopped, and the decoded rows of the image as full-width strips, so
+that all the tiles of a row of tiles, and the tiles below it, cost
+about one decode of the file together.
+
+The memory used for the strips is limited; the least recently used
+strips are dropped first. Decoding starts again from the top of the
+file if strips above the current decoder position are needed again.
+
+Only baseline JPEG files without an EXIF orientation are handled;
+read() returns a null image for others, and the caller should fall back
+to the load filter. A session is only used by one thread at a time.
+ */
+
+#ifndef JPEG_DECODER_SESSION_H
+#define JPEG_DECODER_SESSION_H
+
+#include <QString>
+#include <QImage>
+#include <QDateTime>
+#include <QMap>
+#include <QList>
+#include <QVector>
+
+#include "jpegerrormanager.h"
+
+class JpegDecoderSession
+{
+public:
+
+    /*!
+      @param fileName the file to decode
+      @param maxBytes the maximum amount of decoded pixel data kept
+     */
+
+    JpegDecoderSession(const QString &fileName, qint64 maxBytes);
+
+    ~JpegDecoderSession();
+
+    /*!
+      Returns the given area of the full image, or a null image if the
+      file cannot be decoded by a session.
+
+      @param ignoreExifOrientation if the EXIF orientation of the file
+      is not to be taken into account.
+     */
+
+    QImage read(const QRect &area, bool ignoreExifOrientation);
+
+    /*!
+      The amount of decoded pixel data currently kept.
+     */
+
+    qint64 bytes() const;
+
+    /*!
+      The number of times decoding has been started from the top of
+      the file.
+     */
+
+    int startCount() const;
+
+private:
+    Q_DISABLE_COPY(JpegDecoderSession)
+
+    /*!
+      Opens the file and starts decoding it. Must be called after
+      setjmp().
+     */
+
+    bool start();
+
+    /*!
+      Stops decoding and closes the file.
+     */
+
+    void finish();
+
+    /*!
+      Drops all decoding state and cached strips.
+     */
+
+    void reset();
+
+    /*!
+      Decodes the next strip. The strip is only stored if it is
+      within the given range. Must be called after setjmp().
+     */
+
+    void decodeStrip(int firstWanted, int lastWanted);
+
+    /*!
+      Drops least recently used strips outside the given range until
+      the cache fits in its limit.
+     */
+
+    void shrink(int firstWanted, int lastWanted);
+
+    /*!
+      Strip height in rows.
+     */
+
+    static const int StripHeight = 64;
+
+    QString m_fileName;
+    QDateTime m_lastModified;
+    int m_orientation;
+
+    FILE *m_input;
+    struct jpeg_decompress_struct m_info;
+    JpegErrorManager m_errorManager;
+    bool m_isDecoding;
+    bool m_isUnsupported;
+    int m_nextStrip;
+    QSize m_imageSize;
+
+    QMap<int, QImage> m_strips;
+    QList<int> m_recentStrips;
+    QVector<JSAMPLE> m_row;
+    QImage m_strip;
+    qint64 m_bytes;
+    qint64 m_maxBytes;
+    int m_startCount;
+};
+
+#endif // JPEG_DECODER_SESSION_H
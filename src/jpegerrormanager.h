@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class JpegErrorManager
+
+  \brief A libjpeg error manager which returns control to the caller
+  instead of exiting the application.
+
+Call setjmp() on setjmpBuffer before any libjpeg call which may fail;
+libjpeg errors will then return there with a non-zero value. Any
+objects with destructors which are used after setjmp() must be
+declared before it.
+ */
+
+#ifndef JPEG_ERROR_MANAGER_H
+#define JPEG_ERROR_MANAGER_H
+
+#include <stdio.h>
+#include <setjmp.h>
+extern "C" {
+#include <jpeglib.h>
+}
+
+struct JpegErrorManager
+{
+    struct jpeg_error_mgr pub;
+    jmp_buf setjmpBuffer;
+
+    /*!
+      Initializes the manager, to be used as the err field of
+      libjpeg compress or decompress structures.
+     */
+
+    struct jpeg_error_mgr *init()
+    {
+        jpeg_std_error(&pub);
+        pub.error_exit = errorExit;
+        pub.output_message = outputMessage;
+        return &pub;
+    }
+
+    static void errorExit(j_common_ptr info)
+    {
+        JpegErrorManager *manager = (JpegErrorManager*) info->err;
+        longjmp(manager->setjmpBuffer, 1);
+    }
+
+    static void outputMessage(j_common_ptr)
+    {
+    }
+};
+
+#endif // JPEG_ERROR_MANAGER_H
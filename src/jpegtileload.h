@@ -0,0 +1,84 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class JpegTileLoad
+
+  \brief Loads a tile of a JPEG file through the decoder session of
+  the file.
+
+The operation is given the load filter of the file. If the session
+cannot decode the tile, the filter is run instead so that errors are
+reported exactly as with a normal load.
+ */
+
+#ifndef JPEG_TILE_LOAD_H
+#define JPEG_TILE_LOAD_H
+
+#include <QSharedPointer>
+
+#include "task.h"
+
+class QuillImageFilter;
+class JpegDecoderSession;
+
+class JpegTileLoad : public TaskOperation
+{
+public:
+
+    /*!
+      @param loadFilter the load filter of the file
+      @param session the decoder session of the file
+     */
+
+    JpegTileLoad(QuillImageFilter *loadFilter,
+                 QSharedPointer<JpegDecoderSession> session);
+
+    ~JpegTileLoad();
+
+    QuillImage apply(const QuillImage &image);
+
+    QString name() const;
+
+private:
+    QuillImageFilter *m_filter;
+    QSharedPointer<JpegDecoderSession> m_session;
+};
+
+#endif // JPEG_TILE_LOAD_H
@@ -0,0 +1,107 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <QPainter>
+#include <QuillImageFilter>
+#include <math.h>
+
+#include "localfilterapply.h"
+
+LocalFilterApply::LocalFilterApply(QuillImageFilter *filter,
+                                   const QRect &area) :
+    m_filter(filter), m_area(area)
+{
+}
+
+LocalFilterApply::~LocalFilterApply()
+{
+}
+
+QuillImage LocalFilterApply::apply(const QuillImage &image)
+{
+    QRect area = image.area();
+    if (area.isEmpty())
+        area = QRect(QPoint(0, 0), image.fullImageSize());
+
+    if (image.isNull() || area.isEmpty())
+        return m_filter->apply(image);
+
+    const QRect dirtyArea = m_area.intersected(area);
+
+    // Nothing of this image is changed by the filter
+    if (dirtyArea.isEmpty())
+        return image;
+
+    // The dirty area in pixels, rounded outwards
+    const qreal scaleX = (qreal)image.width() / area.width();
+    const qreal scaleY = (qreal)image.height() / area.height();
+
+    const QRect pixels =
+        QRect(QPoint(floor((dirtyArea.left() - area.left()) * scaleX),
+                     floor((dirtyArea.top() - area.top()) * scaleY)),
+              QPoint(ceil((dirtyArea.right() + 1 - area.left()) * scaleX) - 1,
+                     ceil((dirtyArea.bottom() + 1 - area.top()) * scaleY) - 1)).
+        intersected(image.rect());
+
+    if (pixels.isEmpty() || (pixels == image.rect()))
+        return m_filter->apply(image);
+
+    QuillImage part(image, image.copy(pixels));
+    part.setArea(QRect(area.left() + qRound(pixels.left() / scaleX),
+                       area.top() + qRound(pixels.top() / scaleY),
+                       qRound(pixels.width() / scaleX),
+                       qRound(pixels.height() / scaleY)));
+
+    const QuillImage filteredPart = m_filter->apply(part);
+    if (filteredPart.isNull())
+        return QuillImage();
+
+    QImage result = image.convertToFormat(filteredPart.format());
+    QPainter painter(&result);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(pixels.topLeft(), filteredPart);
+    painter.end();
+
+    return QuillImage(image, result);
+}
+
+QString LocalFilterApply::name() const
+{
+    return QString("LocalFilterApply");
+}
@@ -0,0 +1,83 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class LocalFilterApply
+
+  \brief Runs a filter which only changes a known area of the image
+  (see RegionsOfInterest::affectedArea()).
+
+Only the part of the input which covers the affected area is given to
+the filter; the rest of the result is copied from the input as it is.
+Inputs which do not meet the affected area at all, like most tiles,
+are not filtered.
+ */
+
+#ifndef LOCAL_FILTER_APPLY_H
+#define LOCAL_FILTER_APPLY_H
+
+#include <QRect>
+
+#include "task.h"
+
+class QuillImageFilter;
+
+class LocalFilterApply : public TaskOperation
+{
+public:
+
+    /*!
+      @param filter the filter of the command
+      @param area the affected area, in full image coordinates
+     */
+
+    LocalFilterApply(QuillImageFilter *filter, const QRect &area);
+
+    ~LocalFilterApply();
+
+    QuillImage apply(const QuillImage &image);
+
+    QString name() const;
+
+private:
+    QuillImageFilter *m_filter;
+    QRect m_area;
+};
+
+#endif // LOCAL_FILTER_APPLY_H
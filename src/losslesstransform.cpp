@@ -0,0 +1,487 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <string.h>
+#include <QFile>
+#include <QVector>
+#include <QuillImageFilter>
+#include <QuillMetadata>
+
+#include "losslesstransform.h"
+#include "quillundostack.h"
+#include "quillundocommand.h"
+#include "file.h"
+#include "jpegerrormanager.h"
+
+static int blocks(int pixels, int blockSize)
+{
+    return (pixels + blockSize - 1) / blockSize;
+}
+
+static int roundUp(int value, int divisor)
+{
+    return blocks(value, divisor) * divisor;
+}
+
+// Mirrors an 8x8 block of DCT coefficients horizontally: the odd
+// horizontal frequencies change their sign.
+
+static void flipBlock(JCOEF *block)
+{
+    for (int v=0; v<DCTSIZE; v++)
+        for (int u=1; u<DCTSIZE; u+=2)
+            block[v*DCTSIZE+u] = -block[v*DCTSIZE+u];
+}
+
+static void transposeBlock(JCOEF *block)
+{
+    for (int v=0; v<DCTSIZE; v++)
+        for (int u=v+1; u<DCTSIZE; u++) {
+            JCOEF coefficient = block[v*DCTSIZE+u];
+            block[v*DCTSIZE+u] = block[u*DCTSIZE+v];
+            block[u*DCTSIZE+v] = coefficient;
+        }
+}
+
+// A clockwise quarter turn is a transpose followed by a horizontal flip.
+
+static void transformBlock(JCOEF *block, int rotation, bool flip)
+{
+    if (flip)
+        flipBlock(block);
+    for (int i=0; i<rotation; i++) {
+        transposeBlock(block);
+        flipBlock(block);
+    }
+}
+
+LosslessTransform::LosslessTransform(const QString &sourceFileName,
+                                     const QString &targetFileName,
+                                     const QByteArray &rawExifData) :
+    m_sourceFileName(sourceFileName), m_targetFileName(targetFileName),
+    m_rawExifData(rawExifData), m_sourceSize(QSize()), m_mcuSize(QSize()),
+    m_rotation(0), m_flip(false), m_crop(QRect()), m_hasSucceeded(false)
+{
+}
+
+LosslessTransform::~LosslessTransform()
+{
+}
+
+LosslessTransform *LosslessTransform::fromStack(QuillUndoStack *stack,
+                                                const QString &targetFileName,
+                                                const QByteArray &rawExifData)
+{
+    int savedIndex = stack->savedIndex();
+    int index = stack->index();
+
+    if (savedIndex >= index)
+        return 0;
+
+    // The file which corresponds to the last saved state
+    QString sourceFileName;
+    if (savedIndex == 0)
+        sourceFileName = stack->command(0)->filter()->
+            option(QuillImageFilter::FileName).toString();
+    else
+        sourceFileName = stack->file()->fileName();
+
+    LosslessTransform *transform =
+        new LosslessTransform(sourceFileName, targetFileName, rawExifData);
+
+    bool isPossible = transform->readSource() &&
+        (transform->fullImageSize() ==
+         stack->command(savedIndex)->fullImageSize());
+
+    for (int i=savedIndex+1; isPossible && (i<index); i++)
+        isPossible = transform->addFilter(stack->command(i)->filter());
+
+    if (isPossible)
+        isPossible = transform->isExact() &&
+            (transform->fullImageSize() == stack->command()->fullImageSize());
+
+    if (!isPossible) {
+        delete transform;
+        return 0;
+    }
+    return transform;
+}
+
+bool LosslessTransform::readSource()
+{
+    FILE *input = fopen(QFile::encodeName(m_sourceFileName).constData(), "rb");
+    if (!input)
+        return false;
+
+    struct jpeg_decompress_struct source;
+    JpegErrorManager errorManager;
+    source.err = errorManager.init();
+    jpeg_create_decompress(&source);
+
+    if (setjmp(errorManager.setjmpBuffer)) {
+        jpeg_destroy_decompress(&source);
+        fclose(input);
+        return false;
+    }
+
+    jpeg_stdio_src(&source, input);
+    jpeg_read_header(&source, TRUE);
+
+#if JPEG_LIB_VERSION >= 70
+    // Scaled DCT sizes cannot be handled by block rearrangement
+    if (source.block_size != DCTSIZE)
+        longjmp(errorManager.setjmpBuffer, 1);
+#endif
+
+    m_sourceSize = QSize(source.image_width, source.image_height);
+    m_mcuSize = QSize(source.max_h_samp_factor * DCTSIZE,
+                      source.max_v_samp_factor * DCTSIZE);
+
+    jpeg_destroy_decompress(&source);
+    fclose(input);
+
+    // Loading applies the EXIF orientation, so the transform starts from it
+    QuillMetadata metadata(m_sourceFileName, QuillMetadata::ExifFormat);
+    switch (metadata.entry(QuillMetadata::Tag_Orientation).toInt()) {
+    case 2: m_rotation = 0; m_flip = true; break;
+    case 3: m_rotation = 2; m_flip = false; break;
+    case 4: m_rotation = 2; m_flip = true; break;
+    case 5: m_rotation = 3; m_flip = true; break;
+    case 6: m_rotation = 1; m_flip = false; break;
+    case 7: m_rotation = 1; m_flip = true; break;
+    case 8: m_rotation = 3; m_flip = false; break;
+    default: m_rotation = 0; m_flip = false; break;
+    }
+
+    m_crop = QRect(QPoint(0, 0), transformedSize());
+    return true;
+}
+
+bool LosslessTransform::addFilter(QuillImageFilter *filter)
+{
+    if (!filter)
+        return false;
+
+    if (filter->name() == QuillImageFilter::Name_Crop) {
+        QRect area = filter->option(QuillImageFilter::CropRectangle).toRect();
+        area = area.translated(m_crop.topLeft()) & m_crop;
+        if (area.isEmpty())
+            return false;
+        m_crop = area;
+        return true;
+    }
+
+    if ((filter->name() != QuillImageFilter::Name_Rotate) &&
+        (filter->name() != QuillImageFilter::Name_Flip))
+        return false;
+
+    // Find out the geometry of the filter by tracking the corners of
+    // a non-square image; anything else than quarter turns and flips
+    // will not match.
+
+    const QSize size(4, 2);
+    const QPoint corners[3] = { QPoint(0, 0),
+                                QPoint(size.width() - 1, 0),
+                                QPoint(0, size.height() - 1) };
+
+    for (int rotation=0; rotation<4; rotation++)
+        for (int flip=0; flip<2; flip++) {
+            bool matches =
+                (filter->newFullImageSize(size) == rotatedSize(rotation, size));
+            for (int i=0; matches && (i<3); i++)
+                matches = (filter->newArea(size, QRect(corners[i], QSize(1, 1))) ==
+                           QRect(mapPoint(rotation, flip, corners[i], size),
+                                 QSize(1, 1)));
+
+            if (matches) {
+                m_crop = mapRect(rotation, flip, m_crop, transformedSize());
+                m_rotation = (rotation + (flip ? 4 - m_rotation : m_rotation)) % 4;
+                m_flip = (m_flip != (bool)flip);
+                return true;
+            }
+        }
+
+    return false;
+}
+
+QSize LosslessTransform::fullImageSize() const
+{
+    return m_crop.size();
+}
+
+bool LosslessTransform::isExact() const
+{
+    if (m_sourceSize.isEmpty() || m_mcuSize.isEmpty() || m_crop.isEmpty())
+        return false;
+
+    // Partial blocks at the right and bottom edges of the source
+    // cannot be moved, so the mirrored edges must be whole MCUs
+
+    const QPoint origin = mapPoint(m_rotation, m_flip, QPoint(0, 0), m_sourceSize);
+    const QPoint right = mapPoint(m_rotation, m_flip,
+                                  QPoint(m_sourceSize.width() - 1, 0), m_sourceSize);
+    const QPoint bottom = mapPoint(m_rotation, m_flip,
+                                   QPoint(0, m_sourceSize.height() - 1), m_sourceSize);
+
+    const bool isXMirrored = (right.x() < origin.x()) || (right.y() < origin.y());
+    const bool isYMirrored = (bottom.x() < origin.x()) || (bottom.y() < origin.y());
+
+    if (isXMirrored && (m_sourceSize.width() % m_mcuSize.width() != 0))
+        return false;
+    if (isYMirrored && (m_sourceSize.height() % m_mcuSize.height() != 0))
+        return false;
+
+    // The result must start at an MCU boundary
+    const QSize mcuSize = rotatedSize(m_rotation, m_mcuSize);
+    return (m_crop.x() % mcuSize.width() == 0) &&
+        (m_crop.y() % mcuSize.height() == 0);
+}
+
+QuillImage LosslessTransform::apply(const QuillImage &image)
+{
+    Q_UNUSED(image);
+    m_hasSucceeded = transformFile(QFile::encodeName(m_sourceFileName),
+                                   QFile::encodeName(m_targetFileName));
+    return QuillImage();
+}
+
+QString LosslessTransform::name() const
+{
+    return QString("LosslessTransform");
+}
+
+bool LosslessTransform::hasSucceeded() const
+{
+    return m_hasSucceeded;
+}
+
+QPoint LosslessTransform::mapPoint(int rotation, bool flip,
+                                   const QPoint &point, const QSize &size)
+{
+    QPoint result = point;
+    QSize resultSize = size;
+
+    if (flip)
+        result = QPoint(resultSize.width() - 1 - result.x(), result.y());
+
+    for (int i=0; i<rotation; i++) {
+        result = QPoint(resultSize.height() - 1 - result.y(), result.x());
+        resultSize.transpose();
+    }
+    return result;
+}
+
+QRect LosslessTransform::mapRect(int rotation, bool flip,
+                                 const QRect &rect, const QSize &size)
+{
+    return QRect(mapPoint(rotation, flip, rect.topLeft(), size),
+                 mapPoint(rotation, flip, rect.bottomRight(), size)).normalized();
+}
+
+QSize LosslessTransform::rotatedSize(int rotation, const QSize &size)
+{
+    if (rotation % 2 == 0)
+        return size;
+    else
+        return QSize(size.height(), size.width());
+}
+
+QSize LosslessTransform::transformedSize() const
+{
+    return rotatedSize(m_rotation, m_sourceSize);
+}
+
+bool LosslessTransform::transformFile(const QByteArray &sourceName,
+                                      const QByteArray &targetName)
+{
+    FILE *input = fopen(sourceName.constData(), "rb");
+    if (!input)
+        return false;
+
+    FILE *output = fopen(targetName.constData(), "wb");
+    if (!output) {
+        fclose(input);
+        return false;
+    }
+
+    // Block grids of the result and of the whole transformed image,
+    // and the offset of the crop area in the latter. Declared before
+    // setjmp() so that an error does not skip their destructors.
+    QVector<QSize> targetGrids;
+    QVector<QSize> fullGrids;
+    QVector<QPoint> offsets;
+
+    struct jpeg_decompress_struct source;
+    struct jpeg_compress_struct target;
+    JpegErrorManager errorManager;
+    source.err = errorManager.init();
+    target.err = &errorManager.pub;
+    jpeg_create_decompress(&source);
+    jpeg_create_compress(&target);
+
+    if (setjmp(errorManager.setjmpBuffer)) {
+        jpeg_destroy_compress(&target);
+        jpeg_destroy_decompress(&source);
+        fclose(output);
+        fclose(input);
+        return false;
+    }
+
+    jpeg_stdio_src(&source, input);
+    jpeg_read_header(&source, TRUE);
+
+    // The file has changed after the transform was planned
+    if ((QSize(source.image_width, source.image_height) != m_sourceSize) ||
+        (source.max_h_samp_factor * DCTSIZE != m_mcuSize.width()) ||
+        (source.max_v_samp_factor * DCTSIZE != m_mcuSize.height()))
+        longjmp(errorManager.setjmpBuffer, 1);
+
+    const bool isTransposed = (m_rotation % 2 == 1);
+    const QSize fullSize = transformedSize();
+    const QSize mcuSize = rotatedSize(m_rotation, m_mcuSize);
+    const int componentCount = source.num_components;
+
+    targetGrids.resize(componentCount);
+    fullGrids.resize(componentCount);
+    offsets.resize(componentCount);
+
+    jvirt_barray_ptr *targetArrays = (jvirt_barray_ptr *)
+        (*source.mem->alloc_small)((j_common_ptr) &source, JPOOL_IMAGE,
+                                   sizeof(jvirt_barray_ptr) * componentCount);
+
+    for (int i=0; i<componentCount; i++) {
+        jpeg_component_info *component = source.comp_info + i;
+        const int horizontal = isTransposed ?
+            component->v_samp_factor : component->h_samp_factor;
+        const int vertical = isTransposed ?
+            component->h_samp_factor : component->v_samp_factor;
+        // Pixels per block of this component
+        const QSize blockSize(mcuSize.width() / horizontal,
+                              mcuSize.height() / vertical);
+
+        targetGrids[i] =
+            QSize(roundUp(blocks(m_crop.width(), blockSize.width()), horizontal),
+                  roundUp(blocks(m_crop.height(), blockSize.height()), vertical));
+        fullGrids[i] = QSize(blocks(fullSize.width(), blockSize.width()),
+                             blocks(fullSize.height(), blockSize.height()));
+        offsets[i] = QPoint(m_crop.x() / blockSize.width(),
+                            m_crop.y() / blockSize.height());
+
+        targetArrays[i] = (*source.mem->request_virt_barray)
+            ((j_common_ptr) &source, JPOOL_IMAGE, FALSE,
+             targetGrids[i].width(), targetGrids[i].height(), vertical);
+    }
+
+    jvirt_barray_ptr *sourceArrays = jpeg_read_coefficients(&source);
+
+    jpeg_copy_critical_parameters(&source, &target);
+    target.image_width = m_crop.width();
+    target.image_height = m_crop.height();
+    target.optimize_coding = TRUE;
+
+    if (isTransposed) {
+        for (int i=0; i<componentCount; i++) {
+            jpeg_component_info *component = target.comp_info + i;
+            int factor = component->h_samp_factor;
+            component->h_samp_factor = component->v_samp_factor;
+            component->v_samp_factor = factor;
+        }
+        for (int i=0; i<NUM_QUANT_TBLS; i++) {
+            JQUANT_TBL *table = target.quant_tbl_ptrs[i];
+            if (!table)
+                continue;
+            for (int v=0; v<DCTSIZE; v++)
+                for (int u=v+1; u<DCTSIZE; u++) {
+                    UINT16 value = table->quantval[v*DCTSIZE+u];
+                    table->quantval[v*DCTSIZE+u] = table->quantval[u*DCTSIZE+v];
+                    table->quantval[u*DCTSIZE+v] = value;
+                }
+        }
+    }
+
+    // Each result block comes from the source block which the inverse
+    // transform maps it to
+
+    const int inverseRotation = m_flip ? m_rotation : (4 - m_rotation) % 4;
+
+    for (int i=0; i<componentCount; i++) {
+        jpeg_component_info *component = source.comp_info + i;
+        const int lastColumn = component->width_in_blocks - 1;
+        const int lastRow = component->height_in_blocks - 1;
+
+        for (int y=0; y<targetGrids[i].height(); y++) {
+            JBLOCKARRAY targetRow = (*source.mem->access_virt_barray)
+                ((j_common_ptr) &source, targetArrays[i], y, 1, TRUE);
+
+            for (int x=0; x<targetGrids[i].width(); x++) {
+                QPoint block = mapPoint(inverseRotation, m_flip,
+                                        QPoint(x, y) + offsets[i],
+                                        fullGrids[i]);
+                block.setX(qBound(0, block.x(), lastColumn));
+                block.setY(qBound(0, block.y(), lastRow));
+
+                JBLOCKARRAY sourceRow = (*source.mem->access_virt_barray)
+                    ((j_common_ptr) &source, sourceArrays[i], block.y(), 1, FALSE);
+
+                memcpy(targetRow[0][x], sourceRow[0][block.x()], sizeof(JBLOCK));
+                transformBlock(targetRow[0][x], m_rotation, m_flip);
+            }
+        }
+    }
+
+    jpeg_stdio_dest(&target, output);
+    if (!m_rawExifData.isEmpty())
+        target.write_JFIF_header = FALSE;
+    jpeg_write_coefficients(&target, targetArrays);
+
+    // Same raw EXIF block as given to the save filter
+    if (!m_rawExifData.isEmpty() && (m_rawExifData.size() <= 65533))
+        jpeg_write_marker(&target, JPEG_APP0 + 1,
+                          (const JOCTET *) m_rawExifData.constData(),
+                          m_rawExifData.size());
+
+    jpeg_finish_compress(&target);
+    jpeg_destroy_compress(&target);
+    jpeg_finish_decompress(&source);
+    jpeg_destroy_decompress(&source);
+
+    fclose(output);
+    fclose(input);
+    return true;
+}
@@ -0,0 +1,197 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class LosslessTransform
+
+  \brief Saves a JPEG image which has only been rotated, flipped or
+  cropped by transforming its DCT coefficients directly.
+
+A save normally decodes the full image, runs the edit history on it
+and encodes the result again. If all edits since the last save are
+rotations by multiples of 90 degrees, flips or crops, the same result
+can be reached by rearranging the 8x8 DCT blocks of the original file,
+which is much faster and does not lose any quality.
+
+This only works when all the edges which are mirrored, and the top
+left corner of the crop area, fall on MCU boundaries of the
+file. fromStack() returns 0 if this is not the case, and the save
+proceeds normally.
+
+The EXIF orientation of the original file is included in the
+transform, so the result always has orientation 1. The same raw EXIF
+block which the save filter would write is written into the result.
+ */
+
+#ifndef LOSSLESS_TRANSFORM_H
+#define LOSSLESS_TRANSFORM_H
+
+#include <QString>
+#include <QSize>
+#include <QRect>
+#include <QByteArray>
+
+#include "task.h"
+
+class QuillImageFilter;
+class QuillUndoStack;
+
+class LosslessTransform : public TaskOperation
+{
+public:
+
+    /*!
+      Creates an identity transform for the given file.
+
+      @param sourceFileName the JPEG file to read
+      @param targetFileName the JPEG file to write
+      @param rawExifData the EXIF block to write into the result,
+      including the "Exif" header
+     */
+
+    LosslessTransform(const QString &sourceFileName,
+                      const QString &targetFileName,
+                      const QByteArray &rawExifData);
+
+    ~LosslessTransform();
+
+    /*!
+      Creates a transform corresponding to the commands of the stack
+      which have not yet been saved, or returns 0 if they cannot be
+      done losslessly.
+     */
+
+    static LosslessTransform *fromStack(QuillUndoStack *stack,
+                                        const QString &targetFileName,
+                                        const QByteArray &rawExifData);
+
+    /*!
+      Reads the size and block structure of the source file and the
+      EXIF orientation to start from. Returns false if the source is
+      not a JPEG file which can be transformed.
+     */
+
+    bool readSource();
+
+    /*!
+      Adds a filter to the transform. Returns false if the filter is
+      not a rotation, flip or crop.
+     */
+
+    bool addFilter(QuillImageFilter *filter);
+
+    /*!
+      The full image size after the transform.
+     */
+
+    QSize fullImageSize() const;
+
+    /*!
+      Returns true if the transform gives the exact same result as
+      running the filters on the decoded image.
+     */
+
+    bool isExact() const;
+
+    /*!
+      Writes the target file. The input image is ignored, and a null
+      image is always returned; see hasSucceeded().
+     */
+
+    QuillImage apply(const QuillImage &image);
+
+    QString name() const;
+
+    /*!
+      Returns true if apply() has written the target file successfully.
+     */
+
+    bool hasSucceeded() const;
+
+private:
+
+    /*!
+      Maps a point of an image of the given size through the
+      transform, without the crop.
+     */
+
+    static QPoint mapPoint(int rotation, bool flip,
+                           const QPoint &point, const QSize &size);
+
+    /*!
+      Maps a rectangle similarly.
+     */
+
+    static QRect mapRect(int rotation, bool flip,
+                         const QRect &rect, const QSize &size);
+
+    /*!
+      The image size after rotating it.
+     */
+
+    static QSize rotatedSize(int rotation, const QSize &size);
+
+    /*!
+      The size of the image with rotation and flip but no crop.
+     */
+
+    QSize transformedSize() const;
+
+    bool transformFile(const QByteArray &sourceName,
+                       const QByteArray &targetName);
+
+    QString m_sourceFileName;
+    QString m_targetFileName;
+    QByteArray m_rawExifData;
+
+    // Source image dimensions
+    QSize m_sourceSize;
+    QSize m_mcuSize;
+
+    // Quarter turns clockwise, applied after an optional horizontal flip
+    int m_rotation;
+    bool m_flip;
+
+    // Visible area, in the coordinates of the rotated and flipped image
+    QRect m_crop;
+
+    bool m_hasSucceeded;
+};
+
+#endif // LOSSLESS_TRANSFORM_H
@@ -0,0 +1,99 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class PyramidLoad
+
+  \brief Loads several preview levels of an image from a single
+  decode.
+
+The image is decoded once, at the size given by the input image,
+which must cover the whole image and be big enough for all levels.
+Each level is then cropped and scaled from the decoded image to its
+own area and target size. The highest level is returned from apply(),
+the others are available from lowerLevels().
+
+The operation is given the load filter of the file, so that a failed
+load is reported exactly as with a normal load.
+ */
+
+#ifndef PYRAMID_LOAD_H
+#define PYRAMID_LOAD_H
+
+#include <QList>
+
+#include "task.h"
+
+class QuillImageFilter;
+
+class PyramidLoad : public TaskOperation
+{
+public:
+
+    /*!
+      @param loadFilter the load filter of the file
+      @param levels the full image size, target size, area and
+      display level (z) of each level to create, lowest first
+      @param scaleDenominator if above 1, the image is decoded
+      with ScaledJpegLoad at this scale
+     */
+
+    PyramidLoad(QuillImageFilter *loadFilter, const QList<QuillImage> &levels,
+                int scaleDenominator);
+
+    ~PyramidLoad();
+
+    QuillImage apply(const QuillImage &image);
+
+    QString name() const;
+
+    /*!
+      All levels except the highest one, after a successful apply().
+     */
+
+    QList<QuillImage> lowerLevels() const;
+
+private:
+    QuillImageFilter *m_filter;
+    QList<QuillImage> m_levels;
+    int m_scaleDenominator;
+    QList<QuillImage> m_lowerLevels;
+};
+
+#endif // PYRAMID_LOAD_H
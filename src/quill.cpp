@@ -43,10 +43,13 @@
 #include <QByteArray>
 #include <QColor>
 #include <QDir>
+#include <QFileInfo>
 #include <QuillImageFilter>
 #include "quill.h"
 #include "core.h"
 #include "logger.h"
+#include "file.h"
+#include "strings.h"
 
 Quill* Quill:: g_instance = 0;
 
@@ -70,12 +73,78 @@ void Quill::setDefaultTileSize(const QSize &defaultTileSize)
     QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::qsizeToString(defaultTileSize));
     }
 
+void Quill::setTileBorder(const QString &filterName, int border)
+{
+    Core::instance()->setTileBorder(filterName, border);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+filterName+Logger::intToString(border));
+}
+
+void Quill::setLocalFilter(const QString &filterName, bool local)
+{
+    Core::instance()->setLocalFilter(filterName, local);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+filterName+Logger::boolToString(local));
+}
+
+void Quill::setAdaptiveTileSizeEnabled(bool enabled)
+{
+    Core::instance()->setAdaptiveTileSizeEnabled(enabled);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::boolToString(enabled));
+}
+
+bool Quill::isAdaptiveTileSizeEnabled()
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
+    return Core::instance()->isAdaptiveTileSizeEnabled();
+}
+
 void Quill::setTileCacheSize(int size)
 {
     Core::instance()->setTileCacheSize(size);
     QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::intToString(size));
 }
 
+void Quill::setSaveBufferPoolSize(int size)
+{
+    Core::instance()->setSaveBufferPoolSize(size);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::intToString(size));
+}
+
+int Quill::saveBufferPoolHitCount()
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
+    return Core::instance()->saveBufferPoolHitCount();
+}
+
+int Quill::saveBufferPoolMissCount()
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
+    return Core::instance()->saveBufferPoolMissCount();
+}
+
+void Quill::setTileSpillSize(qint64 bytes)
+{
+    Core::instance()->setTileSpillSize(bytes);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+QString::number(bytes));
+}
+
+void Quill::setDecodedStripCacheSize(int size)
+{
+    Core::instance()->setDecodedStripCacheSize(size);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::intToString(size));
+}
+
+void Quill::setResultCacheSize(int size)
+{
+    Core::instance()->setResultCacheSize(size);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::intToString(size));
+}
+
+void Quill::setResultCacheDirectory(const QString &path)
+{
+    Core::instance()->setResultCacheDirectory(path);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+path);
+}
+
 void Quill::setSaveBufferSize(int size)
 {
     Core::instance()->setSaveBufferSize(size);
@@ -142,25 +211,35 @@ QSize Quill::imageSizeLimit()
     return Core::instance()->imageSizeLimit();
 }
 
-void Quill::setImagePixelsLimit(int pixels)
+void Quill::setImagePixelsLimit(qint64 pixels)
 {
     Core::instance()->setImagePixelsLimit(pixels);
-    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::intToString(pixels));
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+QString::number(pixels));
+}
+
+void Quill::setImagePixelsLimit(int pixels)
+{
+    setImagePixelsLimit(qint64(pixels));
 }
 
-int Quill::imagePixelsLimit()
+qint64 Quill::imagePixelsLimit()
 {
     QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
     return Core::instance()->imagePixelsLimit();
 }
 
-void Quill::setNonTiledImagePixelsLimit(int pixels)
+void Quill::setNonTiledImagePixelsLimit(qint64 pixels)
 {
     Core::instance()->setNonTiledImagePixelsLimit(pixels);
-    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::intToString(pixels));
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+QString::number(pixels));
+}
+
+void Quill::setNonTiledImagePixelsLimit(int pixels)
+{
+    setNonTiledImagePixelsLimit(qint64(pixels));
 }
 
-int Quill::nonTiledImagePixelsLimit()
+qint64 Quill::nonTiledImagePixelsLimit()
 {
     QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
     return Core::instance()->nonTiledImagePixelsLimit();
@@ -172,6 +251,18 @@ void Quill::setEditHistoryPath(const QString &path)
     QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+path);
 }
 
+void Quill::setEditHistoryPreviewsEnabled(bool enabled)
+{
+    Core::instance()->setEditHistoryPreviewsEnabled(enabled);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::boolToString(enabled));
+}
+
+bool Quill::isEditHistoryPreviewsEnabled()
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
+    return Core::instance()->isEditHistoryPreviewsEnabled();
+}
+
 void Quill::setThumbnailBasePath(const QString &path)
 {
     Core::instance()->setThumbnailBasePath(path);
@@ -190,6 +281,44 @@ void Quill::setThumbnailExtension(const QString &extension)
     QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+extension);
 }
 
+QString Quill::thumbnailFileName(const QString &fileName, int level)
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+fileName+Logger::intToString(level));
+    const QString path = Core::instance()->thumbnailPath(level);
+    if (path.isEmpty())
+        return QString();
+
+    return path + QDir::separator() + File::filePathHash(fileName) +
+        Strings::dot + Core::instance()->thumbnailExtension();
+}
+
+bool Quill::hasValidThumbnail(const QString &fileName, int level)
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+fileName+Logger::intToString(level));
+    const QString thumbnail = thumbnailFileName(fileName, level);
+    if (thumbnail.isEmpty())
+        return false;
+
+    const QFileInfo info(thumbnail);
+    return info.exists() &&
+        File::isMatchingTimestamp(info.lastModified(),
+                                  QFileInfo(fileName).lastModified());
+}
+
+QSize Quill::targetSizeForLevel(int level, const QSize &fullImageSize)
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::intToString(level)+Logger::qsizeToString(fullImageSize));
+    return Core::instance()->targetSizeForLevel(level, fullImageSize);
+}
+
+QRect Quill::targetAreaForLevel(int level, const QSize &fullImageSize)
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::intToString(level)+Logger::qsizeToString(fullImageSize));
+    return Core::instance()->targetAreaForLevel(
+        level, Core::instance()->targetSizeForLevel(level, fullImageSize),
+        fullImageSize);
+}
+
 void Quill::setThumbnailCreationEnabled(bool enabled)
 {
     Core::instance()->setThumbnailCreationEnabled(enabled);
@@ -214,6 +343,85 @@ bool Quill::isDBusThumbnailingEnabled()
     return Core::instance()->isDBusThumbnailingEnabled();
 }
 
+void Quill::setVideoThumbnailerThreadCount(int count)
+{
+    Core::instance()->setVideoThumbnailerThreadCount(count);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::intToString(count));
+}
+
+int Quill::videoThumbnailerThreadCount()
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
+    return Core::instance()->videoThumbnailerThreadCount();
+}
+
+void Quill::setViewPortPredictionEnabled(bool enabled)
+{
+    Core::instance()->setViewPortPredictionEnabled(enabled);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::boolToString(enabled));
+}
+
+bool Quill::isViewPortPredictionEnabled()
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
+    return Core::instance()->isViewPortPredictionEnabled();
+}
+
+void Quill::setLosslessSaveEnabled(bool enabled)
+{
+    Core::instance()->setLosslessSaveEnabled(enabled);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::boolToString(enabled));
+}
+
+bool Quill::isLosslessSaveEnabled()
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
+    return Core::instance()->isLosslessSaveEnabled();
+}
+
+void Quill::setScaledJpegLoadingEnabled(bool enabled)
+{
+    Core::instance()->setScaledJpegLoadingEnabled(enabled);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::boolToString(enabled));
+}
+
+bool Quill::isScaledJpegLoadingEnabled()
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
+    return Core::instance()->isScaledJpegLoadingEnabled();
+}
+
+void Quill::setExifPreviewEnabled(bool enabled)
+{
+    Core::instance()->setExifPreviewEnabled(enabled);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::boolToString(enabled));
+}
+
+bool Quill::isExifPreviewEnabled()
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
+    return Core::instance()->isExifPreviewEnabled();
+}
+
+void Quill::setPyramidLoadingEnabled(bool enabled)
+{
+    Core::instance()->setPyramidLoadingEnabled(enabled);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+Logger::boolToString(enabled));
+}
+
+bool Quill::isPyramidLoadingEnabled()
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
+    return Core::instance()->isPyramidLoadingEnabled();
+}
+
+void Quill::setPrefetchHint(const QStringList &fileNames,
+                            PrefetchDirection direction)
+{
+    Core::instance()->setPrefetchHint(fileNames, direction);
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+fileNames.join(" ")+Logger::intToString(direction));
+}
+
 void Quill::setBackgroundRenderingColor(const QColor &color)
 {
     Core::instance()->setBackgroundRenderingColor(color);
@@ -280,6 +488,14 @@ bool Quill::waitUntilFinished(int msec)
     return Core::instance()->waitUntilFinished(msec);
 }
 
+void Quill::processBatch(const QStringList &fileNames,
+                         const QList<QuillImageFilter*> &filters,
+                         const QString &targetDirectory)
+{
+    QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO)+targetDirectory);
+    Core::instance()->processBatch(fileNames, filters, targetDirectory);
+}
+
 void Quill::releaseAndWait()
 {
     Core::instance()->releaseAndWait();
@@ -299,6 +515,12 @@ Quill* Quill::instance()
         g_instance->connect(Core::instance(),
                             SIGNAL(error(QuillError)),
                             SIGNAL(error(QuillError)));
+        g_instance->connect(Core::instance(),
+                            SIGNAL(batchFileSaved(QString)),
+                            SIGNAL(batchFileSaved(QString)));
+        g_instance->connect(Core::instance(),
+                            SIGNAL(batchFinished()),
+                            SIGNAL(batchFinished()));
     }
     QUILL_LOG(Logger::Module_Quill, QString(Q_FUNC_INFO));
     return g_instance;
@@ -161,6 +161,16 @@ public:
         ThreadingTest
     } ThreadingMode;
 
+    /*!
+      The direction in which the user is browsing, see setPrefetchHint().
+    */
+
+    typedef enum _PrefetchDirection
+    {
+        PrefetchForward,
+        PrefetchBackward
+    } PrefetchDirection;
+
     static QSize defaultViewPortSize;
     static int defaultCacheSize;
 
@@ -276,6 +286,62 @@ public:
 
     static void setDefaultTileSize(const QSize &size);
 
+    /*!
+      Declares how many pixels around each output pixel a filter
+      reads, for filters like sharpening or blurring. When tiling, the
+      input tiles of such a filter are extended by this border from
+      the neighbouring tiles, which are calculated first if needed,
+      so that the filter can be run tile by tile without seams.
+
+      @param filterName the name of the filter, see
+      QuillImageFilter::name()
+      @param border the border width in pixels, 0 to remove
+
+      By default, no filter has a border.
+     */
+
+    static void setTileBorder(const QString &filterName, int border);
+
+    /*!
+      Declares that a filter only changes the pixels within the
+      Radius of its Center option, like red eye reduction does. Edits
+      with such a filter are then only run on the affected area of
+      the previous image, instead of the whole image.
+
+      @param filterName the name of the filter, see
+      QuillImageFilter::name()
+      @param local true to declare the filter local, false to remove
+
+      By default, only the red eye detection and reduction filters
+      are local.
+     */
+
+    static void setLocalFilter(const QString &filterName, bool local);
+
+    /*!
+      Lets Quill choose the tile size of each image when it is
+      loaded, instead of always using the default tile size. The
+      default tile size is then the smallest tile size, and it is
+      grown for images whose filters have been measured to spend a
+      large part of their time on per-tile overhead. Small images
+      may get tiles as large as themselves; for large images, the
+      memory used by the tile cache is limited to 4 times what it
+      would be with the default tile size.
+
+      Tiling must still be enabled with setDefaultTileSize().
+
+      The default is false.
+     */
+
+    static void setAdaptiveTileSizeEnabled(bool enabled);
+
+    /*!
+      Returns true if Quill chooses the tile size of each image.
+      See setAdaptiveTileSizeEnabled().
+     */
+
+    static bool isAdaptiveTileSizeEnabled();
+
     /*!
       Sets the tile cache size (measured in tiles, not bytes!)
       The default is 20.
@@ -289,6 +355,87 @@ public:
 
     static void setSaveBufferSize(int size);
 
+    /*!
+      Sets the size of the pool which keeps the pixel buffers of
+      finished save buffers for reuse, in pixels (4 bytes per
+      pixel). The default is two default-size save buffers; 0 disables
+      pooling.
+    */
+
+    static void setSaveBufferPoolSize(int size);
+
+    /*!
+      The number of save buffers which have been reused from the pool.
+      See setSaveBufferPoolSize().
+    */
+
+    static int saveBufferPoolHitCount();
+
+    /*!
+      The number of save buffers which could not be reused from the
+      pool and needed a new allocation. See setSaveBufferPoolSize().
+    */
+
+    static int saveBufferPoolMissCount();
+
+    /*!
+      Sets the size of the scratch file which keeps tiles falling out
+      of the tile cache, in bytes. With the file, panning back to a
+      tile copies it from the file instead of loading and filtering it
+      again. The file is created under temporaryFilePath() when it is
+      first needed, and it is removed when a save has finished, like
+      the tile cache is cleared.
+
+      The default is 0, which disables the scratch file.
+    */
+
+    static void setTileSpillSize(qint64 bytes);
+
+    /*!
+      Sets the size of the cache of decoded image strips kept for each
+      JPEG file shown at full resolution, in pixels (4 bytes per
+      pixel). With the cache, the tiles of a file are cut from rows
+      decoded once, instead of decoding the file again for each
+      tile. Only baseline JPEG files without an EXIF orientation are
+      handled this way.
+
+      The default is 0, which disables the cache.
+    */
+
+    static void setDecodedStripCacheSize(int size);
+
+    /*!
+      Sets the size of the cache of preview images keyed by their
+      contents, in pixels (4 bytes per pixel). The cache is consulted
+      before any preview is calculated, so that results can be reused
+      for files with the same contents and for edit states which have
+      already been dropped from the edit history cache (see
+      setEditHistoryCacheSize()).
+
+      The contents of a file are only sampled from its size and its
+      first and last 64 kilobytes. If a file is changed in place
+      within a session without changing these, the cache may return
+      stale results for it.
+
+      The default is 0, which disables the cache unless a directory
+      is set with setResultCacheDirectory().
+    */
+
+    static void setResultCacheSize(int size);
+
+    /*!
+      Sets a directory where the images of the result cache are also
+      stored, so that they can be reused in later sessions. Stored
+      images are only reused while the original file keeps its inode
+      and modification time. Images are written and read by
+      background tasks, and written only when there is nothing else
+      to do. The directory is not cleaned up by Quill.
+
+      The default is an empty path, which disables storing.
+    */
+
+    static void setResultCacheDirectory(const QString &path);
+
     /*!
       Sets the maximum allowed dimensions for an image. If either
       dimension of an image overflows its respective limit set here,
@@ -321,6 +468,12 @@ public:
       The default is no limit, which is represented by the value 0.
      */
 
+    static void setImagePixelsLimit(qint64 pixels);
+
+    /*!
+      Kept for binary compatibility, see setImagePixelsLimit(qint64).
+     */
+
     static void setImagePixelsLimit(int pixels);
 
     /*!
@@ -328,7 +481,7 @@ public:
       setImagePixelsLimit().
     */
 
-    static int imagePixelsLimit();
+    static qint64 imagePixelsLimit();
 
     /*!
       Sets the maximum number of allowed pixels for image formats which
@@ -341,6 +494,13 @@ public:
       will be used (see setImagePixelsLimit() ).
      */
 
+    static void setNonTiledImagePixelsLimit(qint64 pixels);
+
+    /*!
+      Kept for binary compatibility, see
+      setNonTiledImagePixelsLimit(qint64).
+     */
+
     static void setNonTiledImagePixelsLimit(int pixels);
 
     /*!
@@ -348,7 +508,7 @@ public:
       do not support tiling. See setNonTilingImagePixelsLimit().
     */
 
-    static int nonTiledImagePixelsLimit();
+    static qint64 nonTiledImagePixelsLimit();
 
     /*
       Sets the path where Quill will store and retrieve edit histories.
@@ -357,6 +517,30 @@ public:
 
     static void setEditHistoryPath(const QString &path);
 
+    /*!
+      Stores small previews of each state of an edited image next to
+      its edit history, so that undo, redo and revert in the image
+      are immediate at preview levels when it is opened again in a
+      later session. Previews are only used if the file has not been
+      modified since it was last saved by Quill.
+
+      The previews are stored as PNG files each time a preview level
+      of an edited image is calculated, and for all states when the
+      image is saved. They are written and read by background tasks;
+      writing is done when there is nothing else to do.
+
+      The default is false.
+     */
+
+    static void setEditHistoryPreviewsEnabled(bool enabled);
+
+    /*!
+      Returns true if previews of edit history states are stored.
+      See setEditHistoryPreviewsEnabled().
+     */
+
+    static bool isEditHistoryPreviewsEnabled();
+
     /*!
       Sets the base path under which thumbnails are saved. This
       defaults to the freedesktop standard which is .thumbnails under
@@ -385,6 +569,39 @@ public:
 
     static void setThumbnailExtension(const QString &format);
 
+    /*!
+      The file name of the thumbnail of an image for a display level,
+      from the thumbnail base path, flavor name and extension. Returns
+      an empty string if the level has no thumbnail flavor. This lets
+      tools which create thumbnails without QuillFile store them where
+      QuillFile finds them.
+     */
+
+    static QString thumbnailFileName(const QString &fileName, int level);
+
+    /*!
+      Returns true if the thumbnail of an image for a display level
+      exists and has the same modification time as the image. Only
+      such thumbnails are used by QuillFile.
+     */
+
+    static bool hasValidThumbnail(const QString &fileName, int level);
+
+    /*!
+      The size of the image of a display level for an image of the
+      given full size. See setPreviewSize() and setMinimumPreviewSize().
+     */
+
+    static QSize targetSizeForLevel(int level, const QSize &fullImageSize);
+
+    /*!
+      The area of an image of the given full size which is shown at a
+      display level. This is the whole image, unless the level has a
+      minimum size which crops the image.
+     */
+
+    static QRect targetAreaForLevel(int level, const QSize &fullImageSize);
+
     /*!
       Enables or disables thumbnail creation. Disabling thumbnail
       creation will not abort a creation of an individual thumbnail
@@ -418,6 +635,154 @@ public:
 
     static bool isDBusThumbnailingEnabled();
 
+    /*!
+      Sets the number of threads used for creating video thumbnails
+      with the built-in video thumbnailer. Each thread keeps its own
+      thumbnailer, and several videos are thumbnailed at the same
+      time. Must be set before any video thumbnails are requested.
+      Default is 1. Has no effect when the D-Bus thumbnailer is used.
+    */
+
+    static void setVideoThumbnailerThreadCount(int count);
+
+    /*!
+      Returns the number of video thumbnailer threads, or 0 if the
+      D-Bus thumbnailer is used instead. See
+      setVideoThumbnailerThreadCount().
+    */
+
+    static int videoThumbnailerThreadCount();
+
+    /*!
+      Enables or disables viewport prediction for tiling. When
+      enabled, Quill follows the motion of the viewport between
+      QuillFile::setViewPort() calls. Once all tiles in the viewport
+      are ready, the tiles in the direction of the motion are
+      calculated as well, as long as they fit into the tile cache
+      together with the visible tiles. If the viewport is shrinking
+      (the user is zooming in), the next display level is prepared
+      around the centre of the viewport.
+
+      This option is false by default.
+    */
+
+    static void setViewPortPredictionEnabled(bool enabled);
+
+    /*!
+      Returns true if viewport prediction is enabled. See
+      setViewPortPredictionEnabled().
+    */
+
+    static bool isViewPortPredictionEnabled();
+
+    /*!
+      Enables lossless saving of JPEG files. If all changes since the
+      last save are rotations by multiples of 90 degrees, flips or
+      crops, and the file structure allows it, the image is saved by
+      rearranging its compressed data instead of decoding and encoding
+      it again. This is much faster and does not lose any quality.
+
+      Crops are only done losslessly if the top left corner of the
+      crop area falls on a 16 or 8 pixel boundary, depending on the
+      file; otherwise, and for all other changes, the image is saved
+      normally.
+
+      This option is false by default.
+    */
+
+    static void setLosslessSaveEnabled(bool enabled);
+
+    /*!
+      Returns true if lossless saving is enabled. See
+      setLosslessSaveEnabled().
+    */
+
+    static bool isLosslessSaveEnabled();
+
+    /*!
+      Enables reduced-size decoding of JPEG files for preview
+      levels. When a preview level is at most half, a quarter or an
+      eighth of the size of the full image, the file is decoded
+      directly at that scale, which takes a fraction of the time and
+      memory of decoding the full image. The result is then scaled to
+      the exact size of the preview level.
+
+      This option is false by default.
+    */
+
+    static void setScaledJpegLoadingEnabled(bool enabled);
+
+    /*!
+      Returns true if reduced-size decoding of JPEG files is
+      enabled. See setScaledJpegLoadingEnabled().
+    */
+
+    static bool isScaledJpegLoadingEnabled();
+
+    /*!
+      Enables provisional previews from embedded EXIF thumbnails. When
+      a JPEG file without a pre-generated thumbnail is opened, its
+      embedded EXIF thumbnail is read first and sent with
+      QuillFile::imageAvailable() as a preview of the lowest level,
+      before the real preview has been generated. The provisional
+      image is never cached, and the real preview replaces it when
+      it is ready.
+
+      This option is false by default.
+    */
+
+    static void setExifPreviewEnabled(bool enabled);
+
+    /*!
+      Returns true if provisional previews from embedded EXIF
+      thumbnails are enabled. See setExifPreviewEnabled().
+    */
+
+    static bool isExifPreviewEnabled();
+
+    /*!
+      Enables loading all missing preview levels of an image from a
+      single decode. The image is decoded once, at the smallest size
+      which is enough for the highest level needed, and the lower
+      levels (including cropped ones) are scaled from that in the
+      same task. All the levels are then sent together with
+      QuillFile::imageAvailable().
+
+      This option is false by default.
+    */
+
+    static void setPyramidLoadingEnabled(bool enabled);
+
+    /*!
+      Returns true if preview levels are loaded from a single
+      decode. See setPyramidLoadingEnabled().
+    */
+
+    static bool isPyramidLoadingEnabled();
+
+    /*!
+      Tells Quill which files the user is likely to view next, so
+      that their preview levels can be prepared in advance.
+
+      Quill will use any background capacity which is left idle by
+      all other files to calculate the preview levels of the hinted
+      files, up to the highest preview level. Files which have been
+      opened by the application are always handled first. Prefetched
+      images are kept until the next hint; files which are no longer
+      hinted are released immediately. Calling this with an empty
+      list releases all prefetched images, which is recommended on
+      low memory conditions.
+
+      @param fileNames The files around the current one, in the order
+      of browsing (album order).
+
+      @param direction PrefetchForward to prefetch the files in the
+      order given, PrefetchBackward to prefetch them in reverse order.
+    */
+
+    static void setPrefetchHint(const QStringList &fileNames,
+                                PrefetchDirection direction = PrefetchForward);
+
     /*!
       Sets the path where Quill will store its temporary files.
       The temporary files are currently not autocleaned in case of
@@ -516,6 +881,41 @@ public:
 
     static bool waitUntilFinished(int msec = 0);
 
+    /*!
+      Applies the same edits to a number of files, without the
+      overhead of opening them as QuillFile objects. Each file is
+      loaded, run through the filters in order and saved on the
+      background thread; no previews, thumbnails, undo history or
+      edit history are created for it. Batches are processed when
+      there is nothing else to do for the files open in Quill.
+
+      Filter generators are run as for QuillFile::runFilter(): they
+      first analyse each file, and the filter they result in does the
+      edit. Files exceeding the image size limits are not processed;
+      as they are loaded whole, the limit for non-tiled images applies
+      if it has been set.
+
+      When a file has been saved, batchFileSaved() is emitted with the
+      name of the saved file; if processing a file fails, error() is
+      emitted with the name of the file. If several files would be
+      saved under the same name, only the first one is processed and
+      error() is emitted for the others. batchFinished() is emitted
+      when no more files are queued, immediately if there is nothing
+      to process.
+
+      @param fileNames the files to process.
+
+      @param filters the filters to apply to each file. Quill takes
+      ownership of the filters.
+
+      @param targetDirectory where to save the edited files, with
+      their original names. If empty, the files are overwritten.
+     */
+
+    static void processBatch(const QStringList &fileNames,
+                             const QList<QuillImageFilter*> &filters,
+                             const QString &targetDirectory = QString());
+
     /*!
       To make background loading tests easier on fast machines
 
@@ -572,6 +972,22 @@ signals:
 
     void error(QuillError error);
 
+    /*!
+      A file of a batch has been processed and saved. See
+      processBatch().
+
+      @param filePath the path of the saved file.
+     */
+
+    void batchFileSaved(QString filePath);
+
+    /*!
+      All queued files of batches have been processed. See
+      processBatch().
+     */
+
+    void batchFinished();
+
 private:
 
     /*!
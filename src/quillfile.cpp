@@ -54,6 +54,7 @@ public:
     File *m_file;
     int m_displayLevel;
     int m_priority;
+    QRect m_viewPort;
 };
 
 QuillFile::QuillFile()
@@ -62,6 +63,7 @@ QuillFile::QuillFile()
     priv->m_file = 0;
     priv->m_displayLevel = -1;
     priv->m_priority = Priority_Normal;
+    priv->m_viewPort = QRect();
 }
 
 QuillFile::QuillFile(const QString &fileName,
@@ -72,6 +74,7 @@ QuillFile::QuillFile(const QString &fileName,
     priv = new QuillFilePrivate;
     priv->m_displayLevel = -1;
     priv->m_priority = Priority_Normal;
+    priv->m_viewPort = QRect();
 
     attach(Core::instance()->file(fileName, fileFormat));
 }
@@ -81,6 +84,7 @@ QuillFile::QuillFile(File *file)
     priv = new QuillFilePrivate;
     priv->m_displayLevel = -1;
     priv->m_priority = Priority_Normal;
+    priv->m_viewPort = QRect();
     attach(file);
 }
 
@@ -218,6 +222,36 @@ void QuillFile::runFilter(QuillImageFilter *filter)
         priv->m_file->runFilter(filter);
 }
 
+void QuillFile::previewFilter(QuillImageFilter *filter)
+{
+    QUILL_LOG(Logger::Module_QuillFile, QString(Q_FUNC_INFO));
+    if (priv->m_file)
+        priv->m_file->previewFilter(filter);
+}
+
+void QuillFile::commitPreview()
+{
+    QUILL_LOG(Logger::Module_QuillFile, QString(Q_FUNC_INFO));
+    if (priv->m_file)
+        priv->m_file->commitPreview();
+}
+
+void QuillFile::cancelPreview()
+{
+    QUILL_LOG(Logger::Module_QuillFile, QString(Q_FUNC_INFO));
+    if (priv->m_file)
+        priv->m_file->cancelPreview();
+}
+
+bool QuillFile::isPreviewingFilter() const
+{
+    QUILL_LOG(Logger::Module_QuillFile, QString(Q_FUNC_INFO));
+    if (priv->m_file)
+        return priv->m_file->isPreviewingFilter();
+    else
+        return false;
+}
+
 void QuillFile::startSession()
 {
     QUILL_LOG(Logger::Module_QuillFile, QString(Q_FUNC_INFO));
@@ -330,17 +364,34 @@ QSize QuillFile::fullImageSize() const
 void QuillFile::setViewPort(const QRect &viewPort)
 {
     QUILL_LOG(Logger::Module_QuillFile, QString(Q_FUNC_INFO));
+    // This needs to be done since the file merges the viewports of
+    // all referring QuillFile objects.
+    const QRect oldPort = priv->m_viewPort;
+    priv->m_viewPort = viewPort;
     if (priv->m_file)
-        priv->m_file->setViewPort(viewPort);
+        priv->m_file->setViewPort(this, oldPort);
 }
 
 QRect QuillFile::viewPort() const
+{
+    QUILL_LOG(Logger::Module_QuillFile, QString(Q_FUNC_INFO));
+    return priv->m_viewPort;
+}
+
+void QuillFile::setTileZoomLevel(int level)
+{
+    QUILL_LOG(Logger::Module_QuillFile, QString(Q_FUNC_INFO)+Logger::intToString(level));
+    if (priv->m_file)
+        priv->m_file->setTileZoomLevel(level);
+}
+
+int QuillFile::tileZoomLevel() const
 {
     QUILL_LOG(Logger::Module_QuillFile, QString(Q_FUNC_INFO));
     if (priv->m_file)
-        return priv->m_file->viewPort();
+        return priv->m_file->tileZoomLevel();
     else
-        return QRect();
+        return 0;
 }
 
 bool QuillFile::hasThumbnail(int level) const
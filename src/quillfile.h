@@ -243,6 +243,46 @@ public:
 
     void runFilter(QuillImageFilter *filter);
 
+    /*!
+      Runs a filter as an interactive preview, for adjustments which
+      change continuously (like a brightness slider). Each call
+      replaces the filter of the previous call instead of adding a
+      new edit, and anything not yet calculated for the replaced
+      filter is dropped.
+
+      While the preview is in progress, only the highest preview
+      level not above the display level of the file is calculated;
+      the other levels, tiles and thumbnails follow once the preview
+      is committed. The ownership of the filter is transferred to the
+      file.
+
+      The preview ends with commitPreview() or cancelPreview(). Any
+      other edit, undo, redo or save also commits the preview first.
+     */
+
+    void previewFilter(QuillImageFilter *filter);
+
+    /*!
+      Makes the filter of the current preview a normal edit, which
+      can be undone and saved. See previewFilter().
+     */
+
+    void commitPreview();
+
+    /*!
+      Drops the filter of the current preview, returning to the state
+      before previewFilter() was first called. See previewFilter().
+     */
+
+    void cancelPreview();
+
+    /*!
+      If an interactive filter preview is in progress. See
+      previewFilter().
+     */
+
+    bool isPreviewingFilter() const;
+
     /*!
       Starts an undo session. When an undo session is in progress,
       no undo/redo outside the session is permitted. A closed
@@ -356,17 +396,44 @@ public:
       takes effect if tiling is in use. Only tiles within the viewport
       will be processed and returned. The default is no viewport
       (e.g. no tiles will be returned).
+
+      Each QuillFile object referring to the same file has its own
+      viewport (for example, a main view and a navigator). Tiles for
+      all of them are calculated, those of higher priority objects
+      first (see setPriority()). A tile inside some viewports is only
+      sent to the objects with those viewports.
     */
 
     void setViewPort(const QRect &viewPort);
 
     /*!
-      Returns the viewport in full-image coordinates. Only tiles
-      within the viewport will be processed and returned.
+      Returns the viewport of this object in full-image coordinates.
+      Only tiles within the viewport will be processed and returned.
      */
 
     QRect viewPort() const;
 
+    /*!
+      Sets the resolution of the tiles, only takes effect if tiling
+      is in use. At zoom level 0 (the default), tiles are at full
+      resolution; at level 1 they are scaled to half, at level 2 to a
+      quarter and so on. Tiles keep their ids and areas (in
+      full-image coordinates) at all zoom levels, so a view can
+      request only as many pixels as it is going to show.
+
+      Reduced tiles are scaled from the tiles of the next finer level
+      if those are available, otherwise they are loaded directly at
+      the reduced resolution.
+    */
+
+    void setTileZoomLevel(int level);
+
+    /*!
+      Returns the zoom level of the tiles. See setTileZoomLevel().
+     */
+
+    int tileZoomLevel() const;
+
     /*!
       If a related thumbnail has been cached to the file system.
      */
@@ -40,6 +40,7 @@
 #include <QImage>
 #include <QuillImage>
 #include <QuillImageFilter>
+#include <QuillImageFilterGenerator>
 
 #include "quill.h"
 #include "quillfile.h"
@@ -47,6 +48,7 @@
 #include "quillundocommand.h"
 #include "imagecache.h"
 #include "tilemap.h"
+#include "resultcache.h"
 #include "core.h"
 
 int QuillUndoCommand::m_nextId = 1;
@@ -54,7 +56,7 @@ int QuillUndoCommand::m_nextId = 1;
 QuillUndoCommand::QuillUndoCommand(QuillUndoStack *parent) :
     QtUndoCommand(), m_filter(0), m_stack(parent),
     m_index(0), m_belongsToSession(0), m_sessionId(0),
-    m_fullImageSize(QSize()), m_tileMap(0)
+    m_fullImageSize(QSize()), m_affectedArea(QRect()), m_tileMap(0)
 {
     // Guarantees that the id will always be unique (at least to maxint)
     m_id = m_nextId;
@@ -86,6 +88,7 @@ QuillUndoCommand::~QuillUndoCommand()
     // The tile map becomes property of the command
 
     delete m_tileMap;
+    qDeleteAll(m_zoomTileMaps);
 }
 
 QuillImageFilter* QuillUndoCommand::filter() const
@@ -96,6 +99,8 @@ QuillImageFilter* QuillUndoCommand::filter() const
 void QuillUndoCommand::setFilter(QuillImageFilter* filter)
 {
     m_filter = filter;
+    m_resultKey = QByteArray();
+    m_fileStamp = QByteArray();
 }
 
 void QuillUndoCommand::redo()
@@ -240,6 +245,47 @@ QSize QuillUndoCommand::fullImageSize() const
     return m_fullImageSize;
 }
 
+void QuillUndoCommand::setAffectedArea(const QRect &area)
+{
+    m_affectedArea = area;
+}
+
+QRect QuillUndoCommand::affectedArea() const
+{
+    return m_affectedArea;
+}
+
+QByteArray QuillUndoCommand::resultKey()
+{
+    if (!m_resultKey.isEmpty() || !m_filter ||
+        dynamic_cast<QuillImageFilterGenerator*>(m_filter))
+        return m_resultKey;
+
+    QByteArray inputKey;
+    if (m_filter->role() == QuillImageFilter::Role_Load)
+        inputKey = ResultCache::fileKey(
+            m_filter->option(QuillImageFilter::FileName).toString());
+    else if (prev())
+        inputKey = prev()->resultKey();
+
+    m_resultKey = ResultCache::filterKey(inputKey, m_filter);
+    return m_resultKey;
+}
+
+QByteArray QuillUndoCommand::fileStamp()
+{
+    if (!m_fileStamp.isEmpty() || !m_filter)
+        return m_fileStamp;
+
+    if (m_filter->role() == QuillImageFilter::Role_Load)
+        m_fileStamp = ResultCache::fileStamp(
+            m_filter->option(QuillImageFilter::FileName).toString());
+    else if (prev())
+        m_fileStamp = prev()->fileStamp();
+
+    return m_fileStamp;
+}
+
 void QuillUndoCommand::setSessionId(int id)
 {
     m_belongsToSession = true;
@@ -268,7 +314,7 @@ void QuillUndoCommand::createTileMap()
 
     if (m_filter->role() == QuillImageFilter::Role_Load)
         m_tileMap = new TileMap(m_fullImageSize,
-                                Core::instance()->defaultTileSize(),
+                                Core::instance()->tileSizeFor(m_fullImageSize),
                                 Core::instance()->tileCache());
     else {
         if (!prev()->tileMap())
@@ -291,3 +337,25 @@ TileMap *QuillUndoCommand::tileMap()
 
     return m_tileMap;
 }
+
+TileMap *QuillUndoCommand::tileMap(int zoomLevel)
+{
+    if (zoomLevel <= 0)
+        return tileMap();
+
+    TileMap *map = m_zoomTileMaps.value(zoomLevel);
+    if (map || !m_filter)
+        return map;
+
+    // Reduced tiles must keep the tile ids of the full resolution map
+    if (m_filter->role() == QuillImageFilter::Role_Load)
+        map = new TileMap(m_fullImageSize,
+                          tileMap()->tileSize(),
+                          Core::instance()->tileCache(),
+                          zoomLevel);
+    else
+        map = new TileMap(prev()->tileMap(zoomLevel), m_filter);
+
+    m_zoomTileMaps.insert(zoomLevel, map);
+    return map;
+}
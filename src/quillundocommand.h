@@ -52,6 +52,8 @@ tiles (in TileCache, accessible via tileMap()).
 
 #include <QtUndoCommand>
 #include <QuillImageFilter>
+#include <QMap>
+#include <QByteArray>
 
 class QuillUndoStack;
 class QString;
@@ -160,6 +162,31 @@ public:
      */
     QSize fullImageSize() const;
 
+    /*!
+      Setting the area changed by the filter of the command, see
+      RegionsOfInterest::affectedArea()
+     */
+    void setAffectedArea(const QRect &area);
+
+    /*!
+      The area of the previous image changed by the filter of the
+      command. An empty rectangle means the whole image.
+     */
+    QRect affectedArea() const;
+
+    /*!
+      The key of the result of this command in ResultCache, or an
+      empty key if it cannot be known (for example, for a filter
+      generator which has not been run yet).
+     */
+    QByteArray resultKey();
+
+    /*!
+      The stamp of the file loaded by the first command of the stack,
+      see ResultCache::fileStamp().
+     */
+    QByteArray fileStamp();
+
     /*!
       Gets the resolution level of the best image available in the command.
      */
@@ -226,6 +253,13 @@ public:
 
     TileMap *tileMap();
 
+    /*!
+      Gets the tile map of the given zoom level for the command,
+      creating it if needed. Zoom level 0 is the same as tileMap().
+     */
+
+    TileMap *tileMap(int zoomLevel);
+
 private:
     int m_id;
     QuillImageFilter* m_filter;
@@ -252,12 +286,36 @@ private:
 
     QSize m_fullImageSize;
 
+    /*!
+      The area changed by the filter of this command.
+     */
+
+    QRect m_affectedArea;
+
+    /*!
+      The result cache key, calculated on first use.
+     */
+
+    QByteArray m_resultKey;
+
+    /*!
+      The file stamp, calculated on first use.
+     */
+
+    QByteArray m_fileStamp;
+
     /*!
       The tile map for this command.
      */
 
     TileMap *m_tileMap;
 
+    /*!
+      Tile maps of reduced resolution, by zoom level.
+     */
+
+    QMap<int, TileMap*> m_zoomTileMaps;
+
     /*!
       Guarantees the uniqueness of a command in a multi-threaded system.
       0 is used to denote an invalid Id.
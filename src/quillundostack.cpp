@@ -52,14 +52,17 @@
 #include "core.h"
 #include "tilemap.h"
 #include "savemap.h"
+#include "losslesstransform.h"
 #include "tilecache.h"
 #include "logger.h"
 #include "displaylevel.h"
+#include "regionsofinterest.h"
 
 QuillUndoStack::QuillUndoStack(File *file) :
     m_stack(new QtUndoStack()), m_file(file), m_isSessionRecording(false),
     m_recordingSessionId(0), m_nextSessionId(1), m_savedIndex(0),
-    m_saveCommand(0), m_loadCommand(0), m_saveMap(0),m_revertIndex(0)
+    m_saveCommand(0), m_loadCommand(0), m_saveMap(0),
+    m_losslessTransform(0), m_revertIndex(0)
 {
 }
 
@@ -69,6 +72,7 @@ QuillUndoStack::~QuillUndoStack()
     delete m_stack;
     delete m_saveCommand;
     delete m_saveMap;
+    delete m_losslessTransform;
 }
 
 File* QuillUndoStack::file()
@@ -202,6 +206,11 @@ void QuillUndoStack::add(QuillImageFilter *filter)
          (filter->role() != QuillImageFilter::Role_Load)) &&
         (count() != 1))
         calculateFullImageSize(cmd);
+
+    // Local filters only need to be run on a part of the image
+    if ((filter->role() != QuillImageFilter::Role_Load) && cmd->prev())
+        cmd->setAffectedArea(RegionsOfInterest::affectedArea(
+            filter, cmd->prev()->fullImageSize()));
     setRevertIndex(0);
 }
 
@@ -442,11 +451,18 @@ void QuillUndoStack::prepareSave(const QString &fileName,
     m_saveCommand =0;
     delete m_saveMap;
     m_saveMap = 0;
+    delete m_losslessTransform;
+    m_losslessTransform = 0;
+
+    if (Core::instance()->isLosslessSaveEnabled() && m_file->isJpeg())
+        m_losslessTransform =
+            LosslessTransform::fromStack(this, fileName, rawExifDump);
 
     if (!Core::instance()->defaultTileSize().isEmpty())
         m_saveMap = new SaveMap(command()->fullImageSize(),
                                 Core::instance()->saveBufferSize(),
-                                command()->tileMap());
+                                command()->tileMap(),
+                                Core::instance()->saveBufferPool());
 
     QuillImageFilter *saveFilter =
         QuillImageFilterFactory::createImageFilter(QuillImageFilter::Role_Save);
@@ -500,6 +516,9 @@ void QuillUndoStack::cleanupAfterSave()
 
     delete m_saveMap;
     m_saveMap = 0;
+
+    delete m_losslessTransform;
+    m_losslessTransform = 0;
 }
 
 QuillUndoCommand *QuillUndoStack::saveCommand()
@@ -512,6 +531,17 @@ SaveMap *QuillUndoStack::saveMap()
     return m_saveMap;
 }
 
+LosslessTransform *QuillUndoStack::losslessTransform() const
+{
+    return m_losslessTransform;
+}
+
+void QuillUndoStack::cancelLosslessTransform()
+{
+    delete m_losslessTransform;
+    m_losslessTransform = 0;
+}
+
 void QuillUndoStack::setRevertIndex(int index)
 {
     m_revertIndex = index;
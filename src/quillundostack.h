@@ -66,6 +66,7 @@ class File;
 class QuillUndoCommand;
 class QuillImageFilter;
 class SaveMap;
+class LosslessTransform;
 class QuillImageFilterGenerator;
 class QtUndoStack;
 class Logger;
@@ -298,6 +299,20 @@ public:
      */
 
     SaveMap *saveMap();
+
+    /*!
+      Returns the lossless transform which replaces the normal save,
+      or 0 if the save cannot be done losslessly.
+     */
+
+    LosslessTransform *losslessTransform() const;
+
+    /*!
+      Gives up the lossless transform, so that the save proceeds
+      normally.
+     */
+
+    void cancelLosslessTransform();
     /*!
       Sets the index of the stack command that is currently used before reverting.
     */
@@ -345,6 +360,7 @@ private:
     QuillUndoCommand *m_saveCommand;
     QuillUndoCommand *m_loadCommand;
     SaveMap *m_saveMap;
+    LosslessTransform *m_losslessTransform;
     int m_revertIndex;
 };
 
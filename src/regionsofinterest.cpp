@@ -1,5 +1,6 @@
 #include "quillundocommand.h"
 #include "regionsofinterest.h"
+#include "core.h"
 
 QuillMetadataRegionList RegionsOfInterest::applyFilterToRegions(QuillImageFilter *filter,
                                                                QuillMetadataRegionList regions)
@@ -37,3 +38,35 @@ QuillMetadataRegionList
 
     return regions;
 }
+
+QRect RegionsOfInterest::affectedArea(QuillImageFilter *filter,
+                                      const QSize &fullImageSize)
+{
+    if (!filter || fullImageSize.isEmpty() ||
+        !Core::instance()->isLocalFilter(filter) ||
+        (filter->role() == QuillImageFilter::Role_Load) ||
+        (filter->role() == QuillImageFilter::Role_Save))
+        return QRect();
+
+    // Filters which move pixels around always change the whole image
+    const QRect fullArea = QRect(QPoint(0, 0), fullImageSize);
+    if ((filter->newFullImageSize(fullImageSize) != fullImageSize) ||
+        (filter->newArea(fullImageSize, fullArea) != fullArea))
+        return QRect();
+
+    const QVariant center = filter->option(QuillImageFilter::Center);
+    const int radius = filter->option(QuillImageFilter::Radius).toInt();
+    if (!center.isValid() || (radius <= 0))
+        return QRect();
+
+    const QPoint point = center.toPoint();
+    const QRect area =
+        QRect(point - QPoint(radius, radius),
+              QSize(2 * radius + 1, 2 * radius + 1)).intersected(fullArea);
+
+    // No gain in knowing the area
+    if (area == fullArea)
+        return QRect();
+
+    return area;
+}
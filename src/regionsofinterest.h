@@ -26,6 +26,16 @@ class RegionsOfInterest {
 
     static QuillMetadataRegionList applyStackToRegions(QuillUndoStack *stack,
                                                        QuillMetadataRegionList regions);
+
+    /*!
+      The area which a local filter (like red eye reduction) changes,
+      from its Center and Radius options. An empty rectangle is
+      returned if the whole image may change, or if the filter has
+      not been declared local with Quill::setLocalFilter().
+    */
+
+    static QRect affectedArea(QuillImageFilter *filter,
+                              const QSize &fullImageSize);
 };
 
 #endif // REGIONS_OF_INTEREST_H
@@ -0,0 +1,206 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QuillImageFilter>
+
+#include "resultcache.h"
+#include "historyxml.h"
+
+#include <sys/stat.h>
+
+// The amount of data read from both ends of a file for its key
+static const qint64 fileKeySampleSize = 65536;
+
+ResultCache::ResultCache(int maxSize) :
+    m_images(maxSize), m_hitCount(0), m_missCount(0)
+{
+}
+
+ResultCache::~ResultCache()
+{
+}
+
+void ResultCache::setMaxSize(int maxSize)
+{
+    m_images.setMaxCost(maxSize);
+}
+
+int ResultCache::maxSize() const
+{
+    return m_images.maxCost();
+}
+
+void ResultCache::setDirectory(const QString &path)
+{
+    m_directory = path;
+    if (!m_directory.isEmpty())
+        QDir().mkpath(m_directory);
+}
+
+QString ResultCache::directory() const
+{
+    return m_directory;
+}
+
+bool ResultCache::isEnabled() const
+{
+    return (m_images.maxCost() > 0) || !m_directory.isEmpty();
+}
+
+void ResultCache::insert(const QByteArray &key, const QuillImage &image)
+{
+    if (key.isEmpty() || image.isNull())
+        return;
+
+    const int cost = image.width() * image.height();
+    if (cost <= m_images.maxCost())
+        m_images.insert(key, new QuillImage(image), cost);
+}
+
+QuillImage ResultCache::image(const QByteArray &key)
+{
+    if (key.isEmpty())
+        return QuillImage();
+
+    QuillImage *image = m_images.object(key);
+    if (image) {
+        m_hitCount++;
+        return *image;
+    }
+
+    m_missCount++;
+    return QuillImage();
+}
+
+int ResultCache::hitCount() const
+{
+    return m_hitCount;
+}
+
+int ResultCache::missCount() const
+{
+    return m_missCount;
+}
+
+void ResultCache::clear()
+{
+    m_images.clear();
+}
+
+QByteArray ResultCache::fileKey(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    const qint64 size = file.size();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(QByteArray::number(size));
+    hash.addData(file.read(fileKeySampleSize));
+    if (size > 2 * fileKeySampleSize) {
+        file.seek(size - fileKeySampleSize);
+        hash.addData(file.read(fileKeySampleSize));
+    }
+    else
+        hash.addData(file.readAll());
+
+    return hash.result();
+}
+
+QByteArray ResultCache::fileStamp(const QString &fileName)
+{
+    struct stat info;
+    if (::stat(QFile::encodeName(fileName).constData(), &info) != 0)
+        return QByteArray();
+
+    return QByteArray::number(qulonglong(info.st_ino)) + ' ' +
+        QByteArray::number(qlonglong(info.st_mtime));
+}
+
+QByteArray ResultCache::filterKey(const QByteArray &inputKey,
+                                  QuillImageFilter *filter)
+{
+    if (inputKey.isEmpty() || !filter)
+        return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(inputKey);
+
+    // The file name of a load filter does not change the result
+    if (filter->role() == QuillImageFilter::Role_Load) {
+        hash.addData(filter->name().toUtf8());
+        hash.addData(filter->option(QuillImageFilter::IgnoreExifOrientation).
+                     toBool() ? "1" : "0");
+    }
+    else
+        hash.addData(HistoryXml::encodeFilter(filter));
+
+    return hash.result();
+}
+
+QByteArray ResultCache::levelKey(const QByteArray &resultKey,
+                                 const QSize &targetSize, const QRect &area)
+{
+    if (resultKey.isEmpty())
+        return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(resultKey);
+    hash.addData(QString("%1x%2 %3,%4 %5x%6").
+                 arg(targetSize.width()).arg(targetSize.height()).
+                 arg(area.x()).arg(area.y()).
+                 arg(area.width()).arg(area.height()).toLatin1());
+    return hash.result();
+}
+
+QString ResultCache::filePath(const QByteArray &key,
+                              const QByteArray &stamp) const
+{
+    if (m_directory.isEmpty() || key.isEmpty() || stamp.isEmpty())
+        return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(key);
+    hash.addData(stamp);
+    return m_directory + QDir::separator() + hash.result().toHex() + ".png";
+}
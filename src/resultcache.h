@@ -0,0 +1,202 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class ResultCache
+
+  \brief A cache of preview images, keyed by their content instead of
+  by file and command.
+
+The key of a preview image is built from the contents of the original
+file, the name and options of each filter on the way (as written to
+edit histories), and the size and area of the display level. This way,
+results can be reused between two files with the same contents, after
+an undo/redo has been evicted from ImageCache, or when the same
+filters are run again in a later session.
+
+The cache has an upper size limit in pixels; the least recently used
+images are dropped first. Optionally, the cache is backed by a
+directory where each image is kept as a PNG file, which is not limited
+in size. As the content key only samples the file, images on disk are
+also keyed by the inode and modification time of the original file, so
+that they are not reused after the file has been changed in place.
+Images in memory are not, so that they can be shared between copies of
+the same file.
+
+The cache itself only keeps the images in memory. Reading and writing
+the files on disk, see filePath(), is left to background tasks of the
+Scheduler.
+ */
+
+#ifndef __QUILL_RESULT_CACHE_H__
+#define __QUILL_RESULT_CACHE_H__
+
+#include <QCache>
+#include <QByteArray>
+#include <QString>
+#include <QuillImage>
+
+class QuillImageFilter;
+
+class ResultCache
+{
+public:
+
+    /*!
+      Creates a result cache.
+      @param maxSize the maximum amount of pixels kept in memory.
+     */
+
+    ResultCache(int maxSize);
+
+    ~ResultCache();
+
+    /*!
+      Changes the maximum amount of pixels kept in memory.
+     */
+
+    void setMaxSize(int maxSize);
+
+    /*!
+      The maximum amount of pixels kept in memory.
+     */
+
+    int maxSize() const;
+
+    /*!
+      Sets the directory where the images are stored on disk. An
+      empty path disables the disk cache.
+     */
+
+    void setDirectory(const QString &path);
+
+    /*!
+      The directory where the images are stored on disk.
+     */
+
+    QString directory() const;
+
+    /*!
+      If the cache is used at all.
+     */
+
+    bool isEnabled() const;
+
+    /*!
+      Keeps an image in memory.
+      @param key the key of the image, see levelKey()
+     */
+
+    void insert(const QByteArray &key, const QuillImage &image);
+
+    /*!
+      Returns the image kept in memory with the given key, or a null
+      image if there is none.
+      @param key the key of the image, see levelKey()
+     */
+
+    QuillImage image(const QByteArray &key);
+
+    /*!
+      The PNG file where the image with the given key is stored on
+      disk, or an empty path if the disk cache is disabled.
+      @param key the key of the image, see levelKey()
+      @param stamp the stamp of the original file, see fileStamp()
+     */
+
+    QString filePath(const QByteArray &key, const QByteArray &stamp) const;
+
+    /*!
+      The number of image() calls which found an image.
+     */
+
+    int hitCount() const;
+
+    /*!
+      The number of image() calls which did not find an image.
+     */
+
+    int missCount() const;
+
+    /*!
+      Drops all images kept in memory. Does not touch the disk cache
+      or reset the statistics.
+     */
+
+    void clear();
+
+    /*!
+      A key for the contents of a file, built from its size and the
+      contents of its beginning and end. Returns an empty key if the
+      file cannot be read.
+     */
+
+    static QByteArray fileKey(const QString &fileName);
+
+    /*!
+      A stamp for the version of a file, built from its inode and
+      modification time. Returns an empty stamp if the file does not
+      exist.
+     */
+
+    static QByteArray fileStamp(const QString &fileName);
+
+    /*!
+      A key for the result of running a filter on the input with the
+      given key.
+     */
+
+    static QByteArray filterKey(const QByteArray &inputKey,
+                                QuillImageFilter *filter);
+
+    /*!
+      A key for one display level of the result with the given key.
+     */
+
+    static QByteArray levelKey(const QByteArray &resultKey,
+                               const QSize &targetSize, const QRect &area);
+
+private:
+    QCache<QByteArray, QuillImage> m_images;
+    QString m_directory;
+    int m_hitCount;
+    int m_missCount;
+};
+
+#endif //__QUILL_RESULT_CACHE_H__
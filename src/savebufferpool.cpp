@@ -0,0 +1,122 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include "savebufferpool.h"
+
+SaveBufferPool::SaveBufferPool(qint64 maxBytes) :
+    m_bytes(0), m_maxBytes(maxBytes), m_hitCount(0), m_missCount(0)
+{
+}
+
+SaveBufferPool::~SaveBufferPool()
+{
+}
+
+QImage SaveBufferPool::acquire(const QSize &size, QImage::Format format)
+{
+    for (int i=0; i<m_images.count(); i++) {
+        const QImage &image = m_images.at(i);
+        if ((image.size() == size) && (image.format() == format) &&
+            image.isDetached()) {
+            QImage result = m_images.takeAt(i);
+            m_bytes -= bytes(result);
+            m_hitCount++;
+            return result;
+        }
+    }
+
+    m_missCount++;
+    return QImage(size, format);
+}
+
+void SaveBufferPool::release(const QImage &image)
+{
+    if (image.isNull() || (bytes(image) > m_maxBytes))
+        return;
+
+    shrink(m_maxBytes - bytes(image));
+
+    m_images.append(image);
+    m_bytes += bytes(image);
+}
+
+void SaveBufferPool::setMaxBytes(qint64 maxBytes)
+{
+    m_maxBytes = maxBytes;
+    shrink(maxBytes);
+}
+
+qint64 SaveBufferPool::maxBytes() const
+{
+    return m_maxBytes;
+}
+
+qint64 SaveBufferPool::bytes() const
+{
+    return m_bytes;
+}
+
+int SaveBufferPool::hitCount() const
+{
+    return m_hitCount;
+}
+
+int SaveBufferPool::missCount() const
+{
+    return m_missCount;
+}
+
+void SaveBufferPool::clear()
+{
+    m_images.clear();
+    m_bytes = 0;
+}
+
+qint64 SaveBufferPool::bytes(const QImage &image)
+{
+    return (qint64)image.bytesPerLine() * image.height();
+}
+
+void SaveBufferPool::shrink(qint64 maxBytes)
+{
+    while (!m_images.isEmpty() && (m_bytes > maxBytes)) {
+        m_bytes -= bytes(m_images.first());
+        m_images.removeFirst();
+    }
+}
@@ -0,0 +1,138 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class SaveBufferPool
+
+  \brief A pool of pixel buffers for save buffers.
+
+The buffers used for tiled saving are uniformly sized, so instead of
+letting their memory be freed and allocated again, SaveBufferPool keeps
+released buffers around to be reused for the next buffer of the same
+size and format.
+
+A buffer may be released while it is still shared, for example while
+the image filter of a save task still refers to it. Such a buffer will
+only be handed out again once the pool holds the last reference to it.
+
+The pool has an upper size limit in bytes; when the limit is reached,
+the oldest buffers are freed first.
+ */
+
+#ifndef __QUILL_SAVE_BUFFER_POOL_H__
+#define __QUILL_SAVE_BUFFER_POOL_H__
+
+#include <QImage>
+#include <QList>
+
+class SaveBufferPool
+{
+public:
+
+    /*!
+      Creates a save buffer pool.
+      @param maxBytes the maximum amount of pixel data kept in the pool.
+     */
+
+    SaveBufferPool(qint64 maxBytes);
+
+    ~SaveBufferPool();
+
+    /*!
+      Returns a buffer of the given size and format, either from the pool
+      or newly allocated. The contents of the buffer are undefined.
+     */
+
+    QImage acquire(const QSize &size, QImage::Format format);
+
+    /*!
+      Returns a buffer to the pool.
+     */
+
+    void release(const QImage &image);
+
+    /*!
+      Changes the maximum amount of pixel data kept in the pool.
+     */
+
+    void setMaxBytes(qint64 maxBytes);
+
+    /*!
+      The maximum amount of pixel data kept in the pool.
+     */
+
+    qint64 maxBytes() const;
+
+    /*!
+      The amount of pixel data currently kept in the pool.
+     */
+
+    qint64 bytes() const;
+
+    /*!
+      The number of acquire() calls served from the pool.
+     */
+
+    int hitCount() const;
+
+    /*!
+      The number of acquire() calls which needed a new allocation.
+     */
+
+    int missCount() const;
+
+    /*!
+      Frees all buffers in the pool. Does not reset the statistics.
+     */
+
+    void clear();
+
+private:
+    static qint64 bytes(const QImage &image);
+
+    void shrink(qint64 maxBytes);
+
+    QList<QImage> m_images;
+    qint64 m_bytes;
+    qint64 m_maxBytes;
+    int m_hitCount;
+    int m_missCount;
+};
+
+#endif //__QUILL_SAVE_BUFFER_POOL_H__
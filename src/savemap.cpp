@@ -38,23 +38,22 @@
 ****************************************************************************/
 
 #include <QuillImage>
-#include <QuillImageFilter>
-#include <QuillImageFilterFactory>
 #include <QCache>
 
 #include "tilemap.h"
 #include "savemap.h"
+#include "savebufferpool.h"
 
-SaveMap::SaveMap(const QSize &fullImageSize, int bufferSize, TileMap *tileMap) :
+SaveMap::SaveMap(const QSize &fullImageSize, qint64 bufferSize, TileMap *tileMap,
+                 SaveBufferPool *pool) :
     m_fullImageSize(fullImageSize),
-    m_bufferHeight(bufferSize / fullImageSize.width()),
+    m_bufferHeight(qBound((qint64)1, bufferSize / fullImageSize.width(),
+                          (qint64)qMax(fullImageSize.height(), 1))),
     m_bufferId(0),
-    m_buffer(QuillImage())
+    m_buffer(QuillImage()),
+    m_pool(pool)
 {
-    if (m_bufferHeight == 0)
-        m_bufferHeight = 1;
-
-    m_buffer.setArea(bufferArea(0));
+    m_buffer = newBuffer(bufferArea(0));
 
     for (int i=0; i<fullImageSize.height(); i+=m_bufferHeight)
     {
@@ -66,6 +65,8 @@ SaveMap::SaveMap(const QSize &fullImageSize, int bufferSize, TileMap *tileMap) :
 
 SaveMap::~SaveMap()
 {
+    if (m_pool)
+        m_pool->release(m_buffer);
 }
 
 int SaveMap::processNext(TileMap *tileMap)
@@ -85,25 +86,38 @@ int SaveMap::prioritize()
     return m_tileRows.at(0).at(0);
 }
 
-QuillImageFilter *SaveMap::addToBuffer(int index)
+bool SaveMap::addToBuffer(int index, const QuillImage &tile)
 {
-    if (!m_tileRows.at(0).contains(index))
-        return 0;
+    if (m_tileRows.isEmpty() || !m_tileRows.at(0).contains(index))
+        return false;
 
     m_tileRows[0].removeOne(index);
 
-    QuillImageFilter *filter =
-        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Role_Overlay);
+    const QRect bufferArea = m_buffer.area();
+    const QRect area = tile.area() &
+        QRect(tile.area().topLeft(), tile.size()) & bufferArea;
+    if (area.isEmpty())
+        return true;
+
+    // Keep transparency if the image has it
+    if (tile.hasAlphaChannel() && !m_buffer.hasAlphaChannel())
+        m_buffer = QuillImage(m_buffer,
+                              m_buffer.convertToFormat(QImage::Format_ARGB32));
+
+    const QImage source = (tile.format() == m_buffer.format()) ?
+        QImage(tile) : tile.convertToFormat(m_buffer.format());
 
-    filter->setOption(QuillImageFilter::CropRectangle,
-                      QVariant(m_buffer.area()));
-    filter->setOption(QuillImageFilter::Background,
-                      QVariant(QImage(m_buffer)));
+    const int bytesPerPixel = m_buffer.depth() / 8;
+    const int left = area.left() - bufferArea.left();
+    const int sourceLeft = area.left() - tile.area().left();
 
-    // So that implicit sharing does not copy the buffer
-    m_buffer = QImage();
+    for (int y=area.top(); y<=area.bottom(); y++)
+        memcpy(m_buffer.scanLine(y - bufferArea.top()) + left * bytesPerPixel,
+               source.scanLine(y - tile.area().top()) +
+               sourceLeft * bytesPerPixel,
+               area.width() * bytesPerPixel);
 
-    return filter;
+    return true;
 }
 
 QuillImage SaveMap::buffer() const
@@ -111,18 +125,15 @@ QuillImage SaveMap::buffer() const
     return m_buffer;
 }
 
-void SaveMap::setBuffer(const QuillImage &buffer)
-{
-    m_buffer = buffer;
-}
-
 void SaveMap::nextBuffer()
 {
     m_tileRows.removeAt(0);
     m_bufferId++;
-    m_buffer = QuillImage();
-    m_buffer.setArea(bufferArea(m_bufferId));
-    m_buffer.setFullImageSize(m_fullImageSize);
+    if (m_pool) {
+        m_pool->release(m_buffer);
+        m_buffer = QuillImage();
+    }
+    m_buffer = newBuffer(bufferArea(m_bufferId));
 }
 
 bool SaveMap::isBufferComplete() const
@@ -147,6 +158,18 @@ QRect SaveMap::bufferArea(int bufferId) const
     return QRect(0, top, m_fullImageSize.width(), bottom - top);
 }
 
+QuillImage SaveMap::newBuffer(const QRect &area) const
+{
+    QuillImage buffer;
+    if (m_pool && !area.isEmpty())
+        buffer = m_pool->acquire(area.size(), QImage::Format_RGB32);
+    else if (!area.isEmpty())
+        buffer = QImage(area.size(), QImage::Format_RGB32);
+    buffer.setFullImageSize(m_fullImageSize);
+    buffer.setArea(area);
+    return buffer;
+}
+
 int SaveMap::bufferCount() const
 {
     return (m_fullImageSize.height() - 1) / m_bufferHeight + 1;
@@ -44,9 +44,10 @@
   saving.
 
 Each QuillFile in progress of saving has a SaveMap, which has a save
-buffer. Individual tiles are inserted into the save buffer using a
-special QuillImageFilter called Overlay. When the save buffer is full,
-its contents are moved to the image writer for further processing.
+buffer. Individual tiles are copied into the save buffer as soon as
+they are ready. When the save buffer is full, its contents are moved to
+the image writer for further processing, and the buffer is reused for
+the next rows of the image.
  */
 
 #ifndef __QUILL_SAVE_MAP_H_
@@ -59,15 +60,22 @@ its contents are moved to the image writer for further processing.
 
 class QuillImage;
 class TileMap;
+class SaveBufferPool;
 
 class SaveMap
 {
 public:
     /*!
       Creates a save map.
+
+      @param bufferSize the size of the save buffer in pixels, rounded
+      to whole rows of the image
+      @param pool if given, save buffers are taken from and returned
+      to this pool.
     */
 
-    SaveMap(const QSize &fullImageSize, int bufferHeight, TileMap *tileMap);
+    SaveMap(const QSize &fullImageSize, qint64 bufferSize, TileMap *tileMap,
+            SaveBufferPool *pool = 0);
 
     ~SaveMap();
 
@@ -84,12 +92,11 @@ public:
     int prioritize();
 
     /*!
-      Creates an "overlay" filter for processing the image into a buffer.
-      Execute this filter on the background thread to receive the processed
-      buffer.
+      Copies a tile into the current buffer. Returns false if the tile
+      is not waiting to be added to the current buffer.
     */
 
-    QuillImageFilter *addToBuffer(int index);
+    bool addToBuffer(int index, const QuillImage &tile);
 
     /*!
       Returns the current buffer.
@@ -97,13 +104,6 @@ public:
 
     QuillImage buffer() const;
 
-    /*!
-      Replaces the current buffer. This should be used when the background
-      thread has finished processing the buffer.
-    */
-
-    void setBuffer(const QuillImage &buffer);
-
     /*!
       Destroys the current buffer and moves internal state to the next one.
     */
@@ -131,11 +131,18 @@ public:
 private:
     QRect bufferArea(int bufferId) const;
 
+    /*!
+      A new, empty buffer for the given area.
+     */
+
+    QuillImage newBuffer(const QRect &area) const;
+
     QSize m_fullImageSize;
     int m_bufferHeight;
     int m_bufferId;
     QuillImage m_buffer;
     QList<QList<int> > m_tileRows;
+    SaveBufferPool *m_pool;
 };
 
 #endif // __QUILL_SAVE_MAP_H_
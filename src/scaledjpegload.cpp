@@ -0,0 +1,212 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <QFile>
+#include <QVector>
+#include <QTransform>
+#include <QuillImageFilter>
+#include <QuillMetadata>
+
+#include "scaledjpegload.h"
+#include "jpegerrormanager.h"
+
+ScaledJpegLoad::ScaledJpegLoad(QuillImageFilter *loadFilter,
+                               int scaleDenominator) :
+    m_filter(loadFilter), m_scaleDenominator(scaleDenominator)
+{
+}
+
+ScaledJpegLoad::~ScaledJpegLoad()
+{
+}
+
+int ScaledJpegLoad::scaleDenominator(const QRect &area,
+                                     const QSize &targetSize)
+{
+    if (area.isEmpty() || targetSize.isEmpty())
+        return 1;
+
+    for (int denominator=8; denominator>1; denominator/=2)
+        if ((area.width() >= targetSize.width() * denominator) &&
+            (area.height() >= targetSize.height() * denominator))
+            return denominator;
+
+    return 1;
+}
+
+QuillImage ScaledJpegLoad::apply(const QuillImage &image)
+{
+    const QString fileName =
+        m_filter->option(QuillImageFilter::FileName).toString();
+    const QSize fullImageSize = image.fullImageSize();
+
+    QImage decoded;
+    if (!fullImageSize.isEmpty() && !image.targetSize().isEmpty())
+        decoded = decode(QFile::encodeName(fileName));
+
+    if (decoded.isNull())
+        return m_filter->apply(image);
+
+    if (!m_filter->option(QuillImageFilter::IgnoreExifOrientation).toBool()) {
+        QuillMetadata metadata(fileName, QuillMetadata::ExifFormat);
+        decoded = orient(decoded,
+                         metadata.entry(QuillMetadata::Tag_Orientation).toInt());
+    }
+
+    return fitToLevel(decoded, image);
+}
+
+QString ScaledJpegLoad::name() const
+{
+    return QString("ScaledJpegLoad");
+}
+
+QImage ScaledJpegLoad::decode(const QByteArray &fileName) const
+{
+    FILE *input = fopen(fileName.constData(), "rb");
+    if (!input)
+        return QImage();
+
+    // Declared before setjmp() so that an error does not skip their
+    // destructors.
+    QImage image;
+    QVector<JSAMPLE> row;
+
+    struct jpeg_decompress_struct info;
+    JpegErrorManager errorManager;
+    info.err = errorManager.init();
+    jpeg_create_decompress(&info);
+
+    if (setjmp(errorManager.setjmpBuffer)) {
+        jpeg_destroy_decompress(&info);
+        fclose(input);
+        return QImage();
+    }
+
+    jpeg_stdio_src(&info, input);
+    jpeg_read_header(&info, TRUE);
+
+    // Other color spaces are left to the load filter
+    if (info.jpeg_color_space == JCS_GRAYSCALE)
+        info.out_color_space = JCS_GRAYSCALE;
+    else if ((info.jpeg_color_space == JCS_YCbCr) ||
+             (info.jpeg_color_space == JCS_RGB))
+        info.out_color_space = JCS_RGB;
+    else
+        longjmp(errorManager.setjmpBuffer, 1);
+
+    info.scale_num = 1;
+    info.scale_denom = m_scaleDenominator;
+
+    jpeg_start_decompress(&info);
+
+    image = QImage(info.output_width, info.output_height,
+                   QImage::Format_RGB32);
+    row.resize(info.output_width * info.output_components);
+
+    while (info.output_scanline < info.output_height) {
+        QRgb *target = (QRgb*) image.scanLine(info.output_scanline);
+        JSAMPROW rowPointer = row.data();
+        jpeg_read_scanlines(&info, &rowPointer, 1);
+
+        const JSAMPLE *sample = row.constData();
+        if (info.output_components == 1)
+            for (unsigned int x=0; x<info.output_width; x++, sample++)
+                target[x] = qRgb(sample[0], sample[0], sample[0]);
+        else
+            for (unsigned int x=0; x<info.output_width; x++, sample+=3)
+                target[x] = qRgb(sample[0], sample[1], sample[2]);
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    fclose(input);
+
+    return image;
+}
+
+QuillImage ScaledJpegLoad::fitToLevel(const QImage &image,
+                                      const QuillImage &level)
+{
+    const QSize fullImageSize = level.fullImageSize();
+
+    // The area of the preview level, in the coordinates of the image
+
+    QRect area = level.area();
+    if (area.isEmpty())
+        area = QRect(QPoint(0, 0), fullImageSize);
+
+    const qreal scaleX = (qreal)image.width() / fullImageSize.width();
+    const qreal scaleY = (qreal)image.height() / fullImageSize.height();
+
+    const QRect imageArea =
+        QRect(qRound(area.x() * scaleX), qRound(area.y() * scaleY),
+              qMax(1, qRound(area.width() * scaleX)),
+              qMax(1, qRound(area.height() * scaleY))) & image.rect();
+
+    QImage result = image;
+    if (imageArea != image.rect())
+        result = image.copy(imageArea);
+
+    return QuillImage(level, result.scaled(level.targetSize(),
+                                           Qt::IgnoreAspectRatio,
+                                           Qt::SmoothTransformation));
+}
+
+QImage ScaledJpegLoad::orient(const QImage &image, int orientation)
+{
+    switch (orientation) {
+    case 2:
+        return image.mirrored(true, false);
+    case 3:
+        return image.transformed(QTransform().rotate(180));
+    case 4:
+        return image.mirrored(false, true);
+    case 5:
+        return image.mirrored(true, false).transformed(QTransform().rotate(270));
+    case 6:
+        return image.transformed(QTransform().rotate(90));
+    case 7:
+        return image.mirrored(true, false).transformed(QTransform().rotate(90));
+    case 8:
+        return image.transformed(QTransform().rotate(270));
+    default:
+        return image;
+    }
+}
@@ -0,0 +1,118 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class ScaledJpegLoad
+
+  \brief Loads a preview level of a JPEG file using the reduced-size
+  decoding of libjpeg.
+
+libjpeg can decode a file at 1/2, 1/4 or 1/8 of its size for a
+fraction of the time and memory of a full decode, by only using the
+low-frequency DCT coefficients. This operation decodes at the smallest
+such scale which is still bigger than the target of the preview level,
+applies the EXIF orientation and scales the result to the exact target
+size.
+
+The operation is given the load filter of the file. If decoding fails
+for any reason, the filter is run instead so that errors are reported
+exactly as with a normal load.
+ */
+
+#ifndef SCALED_JPEG_LOAD_H
+#define SCALED_JPEG_LOAD_H
+
+#include <QImage>
+#include <QByteArray>
+
+#include "task.h"
+
+class QuillImageFilter;
+
+class ScaledJpegLoad : public TaskOperation
+{
+public:
+
+    /*!
+      @param loadFilter the load filter of the file
+      @param scaleDenominator 2, 4 or 8
+     */
+
+    ScaledJpegLoad(QuillImageFilter *loadFilter, int scaleDenominator);
+
+    ~ScaledJpegLoad();
+
+    /*!
+      The largest scale denominator which still decodes the given area
+      at least at the target size, or 1 if no scaled decode is possible.
+     */
+
+    static int scaleDenominator(const QRect &area, const QSize &targetSize);
+
+    QuillImage apply(const QuillImage &image);
+
+    QString name() const;
+
+    /*!
+      Rotates and mirrors the image according to an EXIF orientation.
+     */
+
+    static QImage orient(const QImage &image, int orientation);
+
+    /*!
+      Crops and scales a decoded version of the whole image to the
+      area and target size of the given preview level image.
+     */
+
+    static QuillImage fitToLevel(const QImage &image, const QuillImage &level);
+
+private:
+
+    /*!
+      Decodes the file at the reduced scale. Returns a null image on
+      failure.
+     */
+
+    QImage decode(const QByteArray &fileName) const;
+
+    QuillImageFilter *m_filter;
+    int m_scaleDenominator;
+};
+
+#endif // SCALED_JPEG_LOAD_H
@@ -38,6 +38,7 @@
 ****************************************************************************/
 
 #include <limits.h>
+#include <math.h>
 #include <QDir>
 #include <QuillImageFilter>
 #include <QuillImageFilterFactory>
@@ -51,7 +52,19 @@
 #include "quillundostack.h"
 #include "tilemap.h"
 #include "savemap.h"
+#include "losslesstransform.h"
+#include "scaledjpegload.h"
+#include "pyramidload.h"
+#include "exifthumbnailload.h"
+#include "jpegtileload.h"
+#include "localfilterapply.h"
+#include "borderedtileapply.h"
+#include "tiledownscale.h"
+#include "batchoperation.h"
+#include "storedimageload.h"
+#include "storedimagesave.h"
 #include "imagecache.h"
+#include "resultcache.h"
 #include "logger.h"
 #include "strings.h"
 
@@ -65,11 +78,22 @@ Scheduler::~Scheduler()
 
 Task *Scheduler::newTask()
 {
-    const QList<File*> fileList = Core::instance()->fileList();
+    const QList<File*> allFiles = Core::instance()->fileList();
     // No files means no operation
 
-    if(fileList.isEmpty())
-        return 0;
+    if(allFiles.isEmpty()) {
+        Task *task = newStoredImageSaveTask();
+        if (task)
+            return task;
+        return newBatchTask();
+    }
+
+    // Files which are only open for prefetching are handled last
+    const QList<File*> prefetchList = Core::instance()->prefetchFileList();
+    QList<File*> fileList;
+    foreach (File *file, allFiles)
+        if (!prefetchList.contains(file))
+            fileList.append(file);
 
     const int previewLevelCount = Core::instance()->previewLevelCount();
 
@@ -83,13 +107,23 @@ Task *Scheduler::newTask()
             return task;
     }
 
+    // First priority, continued (high priority files): provisional
+    // previews from embedded EXIF thumbnails
+
+    foreach (File *file, fileList)
+        if (file->priority() >= QuillFile::Priority_Normal) {
+            Task *task = newExifPreviewTask(file);
+            if (task)
+                return task;
+        }
+
     // Second priority (any): saving thumbnails
     // Saving a thumbnail is very fast compared to generating one,
     // it should be done whenever possible.
 
     if (Core::instance()->isThumbnailCreationEnabled())
 
-        foreach(File* file, fileList){
+        foreach(File* file, allFiles){
             for (int level=0; level<=previewLevelCount-1; level++) {
                 Task *task = newThumbnailSaveTask(file, level);
 
@@ -142,13 +176,16 @@ Task *Scheduler::newTask()
 
     if (prioritySaveFile) {
 
-        Task *task = newNormalTask(prioritySaveFile, previewLevelCount);
-        if (task)
-            return task;
+        // A lossless save does not need the full image
+        if (!prioritySaveFile->stack()->losslessTransform()) {
+            Task *task = newNormalTask(prioritySaveFile, previewLevelCount);
+            if (task)
+                return task;
+        }
 
         // Eighth priority (save in progress): saving image
 
-        task = newSaveTask(prioritySaveFile);
+        Task *task = newSaveTask(prioritySaveFile);
 
         if (task)
             return task;
@@ -167,7 +204,83 @@ Task *Scheduler::newTask()
             return task;
     }
 
-    return 0;
+    // Zoom prediction (highest display level): the next display level
+    // around the pinch centre, if the user is zooming in
+
+    if ((priorityFile != 0) &&
+        Core::instance()->isViewPortPredictionEnabled() &&
+        priorityFile->isZoomingIn() &&
+        (priorityFile->displayLevel() < previewLevelCount)) {
+
+        const int level = priorityFile->displayLevel() + 1;
+        if ((level < previewLevelCount) ||
+            !Core::instance()->defaultTileSize().isEmpty()) {
+            Task *task = newNormalTask(priorityFile, level);
+            if (task)
+                return task;
+        }
+    }
+
+    // Idle time (prefetch hint): pre-generated thumbnails and preview
+    // levels of the files the user is likely to view next
+
+    if (!prefetchList.isEmpty()) {
+        Task *task = newThumbnailLoadTask(prefetchList, INT_MIN);
+        if (task)
+            return task;
+
+        task = newNormalTask(prefetchList, INT_MIN);
+        if (task)
+            return task;
+    }
+
+    // Storing results on disk, when there is nothing else to do
+
+    {
+        Task *task = newStoredImageSaveTask();
+        if (task)
+            return task;
+    }
+
+    // Batch processing, when there is nothing else to do
+
+    return newBatchTask();
+}
+
+Task *Scheduler::newBatchTask()
+{
+    BatchOperation *operation = Core::instance()->takeBatchOperation();
+    if (!operation)
+        return 0;
+
+    Task *task = new Task();
+    task->setOperation(operation);
+    return task;
+}
+
+Task *Scheduler::newStoredImageSaveTask()
+{
+    StoredImageSave *operation = Core::instance()->takeStoredImageSave();
+    if (!operation)
+        return 0;
+
+    Task *task = new Task();
+    task->setOperation(operation);
+    return task;
+}
+
+Task *Scheduler::newStoredImageLoadTask(File *file, QuillUndoCommand *command,
+                                        int level, const QString &fileName)
+{
+    // A missing image is not searched for again
+    if (fileName.isEmpty() || !file->requestStoredImage(fileName))
+        return 0;
+
+    Task *task = new Task();
+    task->setCommandId(command->uniqueId());
+    task->setDisplayLevel(level);
+    task->setOperation(new StoredImageLoad(fileName));
+    return task;
 }
 
 
@@ -189,23 +302,70 @@ QuillUndoCommand *Scheduler::getTask(QuillUndoStack *stack, int level) const
     return stack->command(index + 1);
 }
 
+QByteArray Scheduler::resultKey(QuillUndoCommand *command, int level) const
+{
+    // Tiles are not cached
+    if (level >= Core::instance()->previewLevelCount())
+        return QByteArray();
+
+    const QSize fullSize = command->fullImageSize();
+    const QSize targetSize =
+        Core::instance()->targetSizeForLevel(level, fullSize);
+
+    return ResultCache::levelKey(command->resultKey(), targetSize,
+                                 Core::instance()->targetAreaForLevel(level, targetSize,
+                                                                      fullSize));
+}
+
+void Scheduler::storeResult(File *file, QuillUndoCommand *command,
+                            int level, const QuillImage &image)
+{
+    ResultCache *resultCache = Core::instance()->resultCache();
+    if (resultCache->isEnabled()) {
+        const QByteArray key = resultKey(command, level);
+        resultCache->insert(key, image);
+        Core::instance()->queueStoredImage(
+            resultCache->filePath(key, command->fileStamp()), image);
+    }
+
+    file->storeHistoryPreview(command, level, image);
+}
+
+bool Scheduler::useStoredImage(File *file, QuillUndoCommand *command,
+                               int level, QuillImage image)
+{
+    const QSize fullSize = command->fullImageSize();
+    if (image.isNull() || fullSize.isEmpty())
+        return false;
+
+    const QSize targetSize =
+        Core::instance()->targetSizeForLevel(level, fullSize);
+    image.setFullImageSize(fullSize);
+    image.setArea(Core::instance()->targetAreaForLevel(level, targetSize,
+                                                       fullSize));
+    image.setZ(level);
+    command->setImage(level, image);
+    if (file->stack()->command() == command)
+        file->emitSingleImage(image, level);
+    return true;
+}
+
 Task *Scheduler::newTilingTask(File *file)
 {
     QuillUndoStack *stack = file->stack();
     int tileIndex;
+    int zoom = 0;
 
     if (stack->saveCommand())
     {
+        fillSaveBuffer(stack);
+
         // If we can run the actual save filter
         if (stack->saveMap()->isBufferComplete())
             return 0;
 
-        // If we already have tiles to push to the save buffer
-        if (stack->saveMap()->processNext(stack->command()->tileMap()) != -1)
-            return 0;
-        else
-            // Ask save map about which tile to fetch.
-            tileIndex = stack->saveMap()->prioritize();
+        // Ask save map about which tile to fetch.
+        tileIndex = stack->saveMap()->prioritize();
     }
     else
     {
@@ -214,25 +374,127 @@ Task *Scheduler::newTilingTask(File *file)
         // Currently, this may prioritize some of the less relevant
         // tiles in favor of more relevant ones.
 
-        if (stack->command()->tileMap()->
-            nonEmptyTiles(file->viewPort()).count() >=
-            stack->command()->tileMap()->cacheCost())
+        zoom = file->tileZoomLevel();
+        TileMap *tileMap = stack->command()->tileMap(zoom);
+
+        // Distant viewports are counted separately, not by the area
+        // between them
+        const QList<QRect> viewPorts = file->viewPorts();
+        if (tileMap->nonEmptyTiles(viewPorts).count() >=
+            tileMap->cacheCost())
             return 0;
 
-        tileIndex = stack->command()->tileMap()->
-            prioritize(file->viewPort());
+        // Viewports of higher priority references first
+        tileIndex = -1;
+        foreach (const QRect &viewPort, viewPorts) {
+            tileIndex = tileMap->prioritize(viewPort);
+            if (tileIndex != -1)
+                break;
+        }
+
+        // With the viewport complete, continue to the tiles the
+        // viewport is moving towards, as long as they all fit in the
+        // cache together with the visible ones.
+        if ((tileIndex == -1) &&
+            Core::instance()->isViewPortPredictionEnabled()) {
+            const QRect predicted = file->predictedViewPort();
+            QList<QRect> areas = viewPorts;
+            areas.append(predicted);
+            if (predicted.isValid() && !viewPorts.contains(predicted) &&
+                (tileMap->findArea(areas).count() <= tileMap->cacheCost()))
+                tileIndex = tileMap->prioritize(predicted);
+        }
     }
 
     // We have all the tiles we want already
     if (tileIndex == -1)
         return 0;
 
+    int index = tileCommandIndex(stack, stack->index() - 1, tileIndex, zoom);
+
+    // Filters with a border need the neighbouring tiles of their
+    // predecessor, so any missing ones are calculated first
+    if (zoom == 0) {
+        int missing;
+        while ((missing = missingBorderTile(stack->command(index),
+                                            tileIndex)) != -1) {
+            tileIndex = missing;
+            index = tileCommandIndex(stack, index - 1, tileIndex, zoom);
+        }
+    }
+
+    QuillUndoCommand *command = stack->command(index);
+    const int border = (zoom == 0) ? tileBorder(command, tileIndex) : 0;
+    QuillImage prevImage;
+
+    // A reduced tile is cheapest to get from the finer tile, if known
+    QuillImage finerImage;
+    if (zoom > 0)
+        finerImage = command->tileMap(zoom - 1)->tile(tileIndex);
+
+    if (!finerImage.isNull())
+        prevImage = finerImage;
+    else if (command->filter()->role() == QuillImageFilter::Role_Load)
+        prevImage = command->tileMap(zoom)->tile(tileIndex);
+    else if (border > 0) {
+        TileMap *prevMap = command->prev()->tileMap(zoom);
+        prevImage = prevMap->assemble(prevMap->borderArea(tileIndex, border));
+    }
+    else
+        prevImage = command->prev()->tileMap(zoom)->tile(tileIndex);
+
+    Task *task = new Task();
+    task->setCommandId(command->uniqueId());
+    task->setDisplayLevel(Core::instance()->previewLevelCount());
+    task->setTileId(tileIndex);
+    task->setZoomLevel(zoom);
+    task->setFilter(command->filter());
+    task->setInputImage(prevImage);
+
+    if (!finerImage.isNull())
+        task->setOperation(new TileDownscale(command->tileMap(zoom)->
+                                             tile(tileIndex)));
+    // The border is cut away after the filter
+    else if (border > 0)
+        task->setOperation(new BorderedTileApply(command->filter(),
+                                                 command->tileMap(zoom)->
+                                                 tile(tileIndex)));
+    // Tiles outside the area of a local filter are copied as they are
+    else if ((command->filter()->role() != QuillImageFilter::Role_Load) &&
+             !command->affectedArea().isEmpty() &&
+             !dynamic_cast<QuillImageFilterGenerator*>(command->filter()))
+        task->setOperation(new LocalFilterApply(command->filter(),
+                                                command->affectedArea()));
+    // Tiles of the same file share one decoder session
+    else if ((zoom == 0) &&
+             (command->filter()->role() == QuillImageFilter::Role_Load) &&
+             (Core::instance()->decodedStripCacheSize() > 0) &&
+             file->isJpeg())
+        task->setOperation(new JpegTileLoad(
+            command->filter(),
+            file->decoderSession(command->filter()->
+                                 option(QuillImageFilter::FileName).toString())));
+
+    return task;
+}
+
+int Scheduler::tileCommandIndex(QuillUndoStack *stack, int last,
+                                int tileIndex, int zoom) const
+{
     int index;
 
-    for (index=stack->index()-1; index>=0; index--)
+    for (index=last; index>=0; index--)
     {
-        if (!stack->command(index)->tileMap()->tile(tileIndex).isNull())
+        if (!stack->command(index)->tileMap(zoom)->tile(tileIndex).isNull())
+            break;
+
+        // Reduced tiles can be scaled down from finer ones
+        if ((zoom > 0) &&
+            !stack->command(index)->tileMap(zoom - 1)->tile(tileIndex).isNull())
+        {
+            index--;
             break;
+        }
 
         // Load filters can be re-executed
         if (stack->command(index)->filter()->role() == QuillImageFilter::Role_Load)
@@ -243,22 +505,55 @@ Task *Scheduler::newTilingTask(File *file)
     }
 
     // ...and start working with the next one
-    QuillUndoCommand *command = stack->command(index + 1);
-    QuillImage prevImage;
+    return index + 1;
+}
 
-    if (command->filter()->role() == QuillImageFilter::Role_Load)
-        prevImage = command->tileMap()->tile(tileIndex);
-    else
-        prevImage = command->prev()->tileMap()->tile(tileIndex);
+int Scheduler::tileBorder(QuillUndoCommand *command, int tileIndex) const
+{
+    if ((command->filter()->role() == QuillImageFilter::Role_Load) ||
+        !command->prev())
+        return 0;
 
-    Task *task = new Task();
-    task->setCommandId(command->uniqueId());
-    task->setDisplayLevel(Core::instance()->previewLevelCount());
-    task->setTileId(tileIndex);
-    task->setFilter(command->filter());
-    task->setInputImage(prevImage);
+    const int border = Core::instance()->tileBorder(command->filter());
+    if (border <= 0)
+        return 0;
 
-    return task;
+    // The input tiles around the visible ones stay in the cache next
+    // to them until all of them are done
+    TileMap *map = command->stack()->command()->tileMap(0);
+    TileMap *prevMap = command->prev()->tileMap(0);
+    QList<int> visible = map->findArea(command->stack()->file()->viewPorts());
+    if (!visible.contains(tileIndex))
+        visible.append(tileIndex);
+
+    QList<QRect> borderAreas;
+    foreach (int index, visible)
+        borderAreas.append(prevMap->borderArea(index, border));
+
+    // Too small a cache: run the filter without the border instead
+    if (visible.count() + prevMap->findArea(borderAreas).count() >
+        prevMap->cacheCost()) {
+        QUILL_LOG(Logger::Module_Scheduler,
+                  "Tile cache too small for the border of " +
+                  command->filter()->name());
+        return 0;
+    }
+
+    return border;
+}
+
+int Scheduler::missingBorderTile(QuillUndoCommand *command,
+                                 int tileIndex)
+{
+    const int border = tileBorder(command, tileIndex);
+    if (border <= 0)
+        return -1;
+
+    // Calculating this tile must not replace the input of its
+    // neighbours
+    TileMap *prevMap = command->prev()->tileMap(0);
+    prevMap->keepTilesApart();
+    return prevMap->prioritize(prevMap->borderArea(tileIndex, border));
 }
 
 Task *Scheduler::newTilingSaveTask(File *file)
@@ -267,6 +562,9 @@ Task *Scheduler::newTilingSaveTask(File *file)
     //Make sure the m_saveMap is not null pointer from stack.
     if(!stack->saveMap())
         return 0;
+
+    fillSaveBuffer(stack);
+
     if (stack->saveMap()->isBufferComplete())
     {
         Task *task = new Task();
@@ -277,32 +575,17 @@ Task *Scheduler::newTilingSaveTask(File *file)
         return task;
     }
     else
-        return newTilingOverlayTask(file);
+        return 0;
 }
 
-Task *Scheduler::newTilingOverlayTask(File *file)
+void Scheduler::fillSaveBuffer(QuillUndoStack *stack)
 {
-    QuillUndoStack *stack = file->stack();
-    int tileId = stack->saveMap()->processNext(stack->command()->tileMap());
-
-    if(tileId < 0)
-        return 0;
-    // Should never happen.
-    if (stack->command()->tileMap()->tile(tileId).isNull())
-        return 0;
-
-    QuillImageFilter *filter = stack->saveMap()->addToBuffer(tileId);
-
-    QuillImage prevImage = stack->command()->tileMap()->tile(tileId);
-
-    Task *task = new Task();
-    task->setCommandId(stack->saveCommand()->uniqueId());
-    task->setDisplayLevel(Core::instance()->previewLevelCount());
-    task->setTileId(tileId);
-    task->setFilter(filter);
-    task->setInputImage(prevImage);
-
-    return task;
+    // Tiles are copied in place, which is cheap enough to do here
+    // instead of in the background thread
+    TileMap *tileMap = stack->command()->tileMap();
+    int tileId;
+    while ((tileId = stack->saveMap()->processNext(tileMap)) != -1)
+        stack->saveMap()->addToBuffer(tileId, tileMap->tile(tileId));
 }
 
 Task *Scheduler::newThumbnailLoadTask(const QList<File*> &fileList, int minPriority)
@@ -355,6 +638,50 @@ Task *Scheduler::newThumbnailLoadTask(File *file, int level) const
     return task;
 }
 
+Task *Scheduler::newExifPreviewTask(File *file)
+{
+    if (!Core::instance()->isExifPreviewEnabled() ||
+        file->isExifPreviewRequested() ||
+        (file->displayLevel() < 0) ||
+        !file->isJpeg() ||
+        !file->exists() ||
+        file->isWaitingForData() ||
+        file->hasThumbnail(0))
+        return 0;
+
+    QuillUndoStack *stack = file->stack();
+    if (!stack || stack->isClean() || stack->hasImage(0))
+        return 0;
+
+    // The embedded thumbnail only matches the saved state of the file
+    QuillUndoCommand *command = stack->command();
+    if (command->index() != stack->savedIndex())
+        return 0;
+
+    if (command->fullImageSize().isEmpty() && file->supportsViewing())
+        stack->calculateFullImageSize(command);
+
+    const QSize fullSize = command->fullImageSize();
+    if (fullSize.isEmpty())
+        return 0;
+
+    file->setExifPreviewRequested();
+
+    const QSize targetSize = Core::instance()->targetSizeForLevel(0, fullSize);
+    QuillImage prevImage;
+    prevImage.setFullImageSize(fullSize);
+    prevImage.setTargetSize(targetSize);
+    prevImage.setArea(Core::instance()->targetAreaForLevel(0, targetSize, fullSize));
+    prevImage.setZ(0);
+
+    Task *task = new Task();
+    task->setCommandId(command->uniqueId());
+    task->setDisplayLevel(0);
+    task->setInputImage(prevImage);
+    task->setOperation(new ExifThumbnailLoad(file->fileName()));
+    return task;
+}
+
 Task *Scheduler::newThumbnailSaveTask(File *file, int level)
 {
     if (file->isOriginal() || (file->isWaitingForData()))
@@ -424,6 +751,11 @@ Task *Scheduler::newNormalTask(File *file, int level)
         // Image already exists - no need to recalculate
         return 0;
 
+    // While a filter is being previewed, only one level is kept up
+    // to date; the rest follow when the preview is committed
+    if (file->isPreviewingFilter() && (level != file->filterPreviewLevel()))
+        return 0;
+
     // For read-only images, we stop loading if we already have
     // an equivalent of the full image
     if ((file->state() == File::State_ReadOnly) &&
@@ -435,6 +767,24 @@ Task *Scheduler::newNormalTask(File *file, int level)
         (!Core::instance()->defaultTileSize().isEmpty()))
         return newTilingTask(file);
 
+    // A state of a reopened edit history may have its preview stored,
+    // then the states leading to it need not be calculated
+    if (level < Core::instance()->previewLevelCount()) {
+        const QString fileName =
+            file->historyPreviewFileName(stack->command(), level);
+        if (!fileName.isEmpty()) {
+            // Needed for checking the size of the stored preview
+            if (stack->command()->fullImageSize().isEmpty() &&
+                file->supportsViewing() && !file->isWaitingForData())
+                stack->calculateFullImageSize(stack->command());
+
+            Task *task = newStoredImageLoadTask(file, stack->command(),
+                                                level, fileName);
+            if (task)
+                return task;
+        }
+    }
+
     // The given resolution level is missing
 
     QuillUndoCommand *command = getTask(stack, level);
@@ -510,11 +860,111 @@ Task *Scheduler::newNormalTask(File *file, int level)
     if (command->fullImageSize().isEmpty())
         return 0;
 
+    // The same result may have been calculated before, even for
+    // another file. Then continue with the next missing image.
+    ResultCache *resultCache = Core::instance()->resultCache();
+    if (resultCache->isEnabled()) {
+        const QByteArray key = resultKey(command, level);
+        if (useStoredImage(file, command, level, resultCache->image(key)))
+            return newNormalTask(file, level);
+
+        // Results of earlier sessions are read in the background
+        Task *task =
+            newStoredImageLoadTask(file, command, level,
+                                   resultCache->filePath(key,
+                                                         command->fileStamp()));
+        if (task)
+            return task;
+    }
+
+    // Preview levels of a fresh image can all be made from one decode
+    if ((prev == 0) && (level < Core::instance()->previewLevelCount()) &&
+        Core::instance()->isPyramidLoadingEnabled()) {
+        Task *task = newPyramidTask(file, command, level);
+        if (task)
+            return task;
+    }
+
     Task *task = new Task();
     task->setCommandId(command->uniqueId());
     task->setDisplayLevel(level);
     task->setFilter(command->filter());
     task->setInputImage(prevImage);
+
+    // Local filters only run on the part of the image they change
+    if (prev && !command->affectedArea().isEmpty() &&
+        !dynamic_cast<QuillImageFilterGenerator*>(command->filter()))
+        task->setOperation(new LocalFilterApply(command->filter(),
+                                                command->affectedArea()));
+
+    // Preview levels of JPEG files can be decoded at a reduced scale
+    else if ((prev == 0) && (level < Core::instance()->previewLevelCount()) &&
+        Core::instance()->isScaledJpegLoadingEnabled() && file->isJpeg()) {
+        int denominator = ScaledJpegLoad::scaleDenominator(prevImage.area(),
+                                                           prevImage.targetSize());
+        if (denominator > 1)
+            task->setOperation(new ScaledJpegLoad(command->filter(),
+                                                  denominator));
+    }
+
+    return task;
+}
+
+Task *Scheduler::newPyramidTask(File *file, QuillUndoCommand *command,
+                                int level)
+{
+    const QSize fullImageSize = command->fullImageSize();
+    const int topLevel = qMin(file->displayLevel(),
+                              Core::instance()->previewLevelCount() - 1);
+
+    QList<QuillImage> levels;
+    qreal scale = 0;
+
+    for (int l=level; l<=topLevel; l++) {
+        if (!command->image(l).isNull())
+            continue;
+
+        QSize targetSize = Core::instance()->targetSizeForLevel(l, fullImageSize);
+        QRect area = Core::instance()->targetAreaForLevel(l, targetSize, fullImageSize);
+
+        QuillImage levelImage;
+        levelImage.setFullImageSize(fullImageSize);
+        levelImage.setTargetSize(targetSize);
+        levelImage.setArea(area);
+        levelImage.setZ(l);
+        levels.append(levelImage);
+
+        scale = qMax(scale, qMax((qreal)targetSize.width() / area.width(),
+                                 (qreal)targetSize.height() / area.height()));
+    }
+
+    if (levels.count() < 2)
+        return 0;
+
+    // The whole image, at the smallest size enough for all levels
+
+    scale = qMin(scale, (qreal)1);
+
+    QuillImage input;
+    input.setFullImageSize(fullImageSize);
+    input.setTargetSize(QSize(qMax(1, (int)ceil(fullImageSize.width() * scale)),
+                              qMax(1, (int)ceil(fullImageSize.height() * scale)))
+                        .boundedTo(fullImageSize));
+    input.setArea(QRect(QPoint(0, 0), fullImageSize));
+    input.setZ(levels.last().z());
+
+    int denominator = 1;
+    if (Core::instance()->isScaledJpegLoadingEnabled() && file->isJpeg())
+        denominator = ScaledJpegLoad::scaleDenominator(input.area(),
+                                                       input.targetSize());
+
+    Task *task = new Task();
+    task->setCommandId(command->uniqueId());
+    task->setDisplayLevel(levels.last().z());
+    task->setFilter(command->filter());
+    task->setInputImage(input);
+    task->setOperation(new PyramidLoad(command->filter(), levels,
+                                       denominator));
     return task;
 }
 
@@ -522,6 +972,15 @@ Task *Scheduler::newSaveTask(File *file)
 {
     QuillUndoStack *stack = file->stack();
 
+    // Lossless save variant
+    if (stack->losslessTransform()) {
+        Task *task = new Task();
+        task->setCommandId(stack->saveCommand()->uniqueId());
+        task->setDisplayLevel(Core::instance()->previewLevelCount());
+        task->setOperation(new LosslessTransform(*stack->losslessTransform()));
+        return task;
+    }
+
     // Tiling save variant
     if (!Core::instance()->defaultTileSize().isEmpty())
         return newTilingSaveTask(file);
@@ -538,7 +997,8 @@ Task *Scheduler::newPreviewImprovementTask(File *file)
 {
     if (!file->exists() ||
         (file->state() == File::State_ExternallySupportedFormat) ||
-        (!file->stack()->fullImageSize().isValid()))
+        (!file->stack()->fullImageSize().isValid()) ||
+        file->isPreviewingFilter())
         return 0;
 
     QuillUndoStack *stack = file->stack();
@@ -648,13 +1108,60 @@ void Scheduler::processFinishedTask(Task *task, QuillImage image)
 
     QuillImageFilter *filter = task->filter();
     task->setFilter(0);
+    TaskOperation *operation = task->operation();
+    task->setOperation(0);
 
     QuillImageFilterGenerator *generator =
         dynamic_cast<QuillImageFilterGenerator*>(filter);
+    LosslessTransform *losslessTransform =
+        dynamic_cast<LosslessTransform*>(operation);
+    ExifThumbnailLoad *exifThumbnailLoad =
+        dynamic_cast<ExifThumbnailLoad*>(operation);
+    BatchOperation *batchOperation =
+        dynamic_cast<BatchOperation*>(operation);
+    PyramidLoad *pyramidLoad =
+        dynamic_cast<PyramidLoad*>(operation);
+    StoredImageLoad *storedImageLoad =
+        dynamic_cast<StoredImageLoad*>(operation);
+    StoredImageSave *storedImageSave =
+        dynamic_cast<StoredImageSave*>(operation);
+
+    // Timings of plain filter runs and full resolution tile loads,
+    // for choosing tile sizes. Other loads decode more pixels than
+    // they return, so their timings would not match the tile size.
+    const bool isTimedLoad = filter &&
+        (filter->role() == QuillImageFilter::Role_Load) &&
+        (task->displayLevel() == Core::instance()->previewLevelCount()) &&
+        (task->zoomLevel() == 0) &&
+        (!operation || dynamic_cast<JpegTileLoad*>(operation));
+    const bool isTimedFilter = filter && !operation &&
+        (filter->role() != QuillImageFilter::Role_Load) &&
+        (filter->role() != QuillImageFilter::Role_Save);
+    if (!image.isNull() && (isTimedLoad || isTimedFilter))
+        Core::instance()->recordFilterTime(
+            (qint64)image.width() * image.height(), task->elapsed());
 
     QuillError error;
 
-    if (command == 0)
+    if (batchOperation)
+    {
+        // Batch files are not related to any command
+        if (batchOperation->error().errorCode() == QuillError::NoError)
+            Core::instance()->emitBatchFileSaved(batchOperation->targetFileName());
+        else
+            Core::instance()->emitError(batchOperation->error());
+
+        if (!Core::instance()->hasBatchOperations())
+            Core::instance()->emitBatchFinished();
+    }
+    else if (storedImageSave)
+    {
+        // Stored images are not related to any command either
+        if (image.isNull())
+            QUILL_LOG(Logger::Module_Scheduler,
+                      "Storing " + storedImageSave->fileName() + " failed!");
+    }
+    else if (command == 0)
     {
         // The command has been deleted.
         // Do nothing, just delete the filter
@@ -663,12 +1170,41 @@ void Scheduler::processFinishedTask(Task *task, QuillImage image)
 
         delete filter;
     }
-    else if (filter->role() == QuillImageFilter::Role_Overlay)
+    else if (losslessTransform)
     {
-        // Save buffer overlay has finished - update the buffer.
+        if (losslessTransform->hasSucceeded()) {
+            file->concludeSave();
 
-        delete filter;
-        stack->saveMap()->setBuffer(image);
+            if (file->allowDelete())
+                fileDeletionAllowed = true;
+        }
+        else {
+            // Fall back to decoding and encoding the image
+            QUILL_LOG(Logger::Module_Scheduler, "Lossless save failed!");
+            stack->cancelLosslessTransform();
+        }
+    }
+    else if (exifThumbnailLoad)
+    {
+        // Provisional preview: only shown if the real one has not
+        // arrived yet, and never stored
+        if (!image.isNull() && !stack->hasImage(0) &&
+            (stack->command() == command))
+            file->emitSingleImage(image, 0);
+    }
+    else if (storedImageLoad)
+    {
+        // Only used if nothing else has been calculated meanwhile,
+        // and if stored with the current level configuration
+        const int level = task->displayLevel();
+        if (!image.isNull() && command->image(level).isNull() &&
+            (image.size() ==
+             Core::instance()->targetSizeForLevel(level,
+                                                  command->fullImageSize())) &&
+            useStoredImage(file, command, level, image) &&
+            Core::instance()->resultCache()->isEnabled())
+            Core::instance()->resultCache()->insert(resultKey(command, level),
+                                                    image);
     }
     else if (filter->role() == QuillImageFilter::Role_Save)
     {
@@ -731,8 +1267,11 @@ void Scheduler::processFinishedTask(Task *task, QuillImage image)
     {
         // A fragment of the full image has been calculated
 
-        command->tileMap()->setTile(task->tileId(), image);
-        imageUpdated = true;
+        command->tileMap(task->zoomLevel())->setTile(task->tileId(), image);
+
+        // Tiles of another zoom level are not shown at the moment
+        if (task->zoomLevel() == file->tileZoomLevel())
+            imageUpdated = true;
     }
     else
     {
@@ -824,7 +1363,20 @@ void Scheduler::processFinishedTask(Task *task, QuillImage image)
             // Normal case: a better version of an image has been calculated.
             command->setImage(task->displayLevel(), image);
             imageUpdated = true;
+
+            if (error.errorCode() == QuillError::NoError)
+                storeResult(file, command, task->displayLevel(), image);
         }
+
+        // The lower levels decoded together with this one
+        if (pyramidLoad)
+            foreach (const QuillImage &levelImage, pyramidLoad->lowerLevels())
+                if ((levelImage.z() <= file->displayLevel()) &&
+                    command->image(levelImage.z()).isNull()) {
+                    command->setImage(levelImage.z(), levelImage);
+                    storeResult(file, command, levelImage.z(), levelImage);
+                    imageUpdated = true;
+                }
     }
 
     // If we just got a better version of the active image, emit signal
@@ -835,9 +1387,15 @@ void Scheduler::processFinishedTask(Task *task, QuillImage image)
             current = stack->command();
 
         if (current && (current->uniqueId() == task->commandId())) {
-            file->emitSingleImage(image, task->displayLevel());
+            if (pyramidLoad)
+                file->emitAllImages();
+            else
+                file->emitSingleImage(image, task->displayLevel());
         }
     }
+    // Operations only replace the way a filter is run, the results
+    // have been processed above
+    delete operation;
     delete task;
 
     if (file) {
@@ -120,6 +120,14 @@ private:
 
     Task *newNormalTask(const QList<File*> &fileList, int minPriority);
 
+    /*!
+      Loads all missing preview levels of a command, from the given
+      level up to the display level of the file, from one
+      decode. Returns 0 if only one level is missing.
+     */
+
+    Task *newPyramidTask(File *file, QuillUndoCommand *command, int level);
+
     /*!
       Used by core to indicate that there may be a save task waiting
       for the background thread.
@@ -127,6 +135,34 @@ private:
 
     Task *newSaveTask(File *file);
 
+    /*!
+      Reads the embedded EXIF thumbnail of a file as a provisional
+      preview, if it has no preview yet.
+     */
+
+    Task *newExifPreviewTask(File *file);
+
+    /*!
+      Processes the next file of the batch queue.
+     */
+
+    Task *newBatchTask();
+
+    /*!
+      Writes the next image queued with Core::queueStoredImage().
+     */
+
+    Task *newStoredImageSaveTask();
+
+    /*!
+      Reads a preview level of a command stored on disk, see
+      useStoredImage(). Returns 0 if the image has already been
+      requested once.
+     */
+
+    Task *newStoredImageLoadTask(File *file, QuillUndoCommand *command,
+                                 int level, const QString &fileName);
+
     /*!
       Used by core to indicate that there may be a special
       improvement task (better quality preview image to be created
@@ -160,6 +196,31 @@ private:
 
     QuillUndoCommand *getTask(QuillUndoStack *stack, int level) const;
 
+    /*!
+      The key of a preview level of a command in ResultCache, or an
+      empty key if the level cannot be cached.
+     */
+
+    QByteArray resultKey(QuillUndoCommand *command, int level) const;
+
+    /*!
+      Keeps a newly calculated preview level of a command in the
+      result cache and the stored edit history previews. Images are
+      stored on disk later by background tasks.
+     */
+
+    void storeResult(File *file, QuillUndoCommand *command, int level,
+                     const QuillImage &image);
+
+    /*!
+      Uses an image calculated earlier, from the result cache or the
+      stored edit history previews, as a preview level of a command.
+      Returns false if the image or the full image size is missing.
+     */
+
+    bool useStoredImage(File *file, QuillUndoCommand *command, int level,
+                        QuillImage image);
+
     /*!
       Helper function for suggestNewTask(), used for tiling.
       Can start calculations on its own.
@@ -167,6 +228,35 @@ private:
 
     Task *newTilingTask(File *file);
 
+    /*!
+      Finds the command from which a tile can be calculated, going
+      backwards from the command at the given stack index.
+    */
+
+    int tileCommandIndex(QuillUndoStack *stack, int last,
+                         int tileIndex, int zoom) const;
+
+    /*!
+      The tile border needed by the filter of a command for the given
+      tile, or 0 if the tile can be calculated from the same tile of
+      its predecessor. This is also 0 if the visible tiles and the
+      bordered areas of the predecessor around them do not fit in the
+      tile cache together, as calculating one tile would then drop
+      another one which is still needed.
+    */
+
+    int tileBorder(QuillUndoCommand *command, int tileIndex) const;
+
+    /*!
+      Finds a tile of the predecessor of a command which is needed
+      for the border of the given tile but is not in the cache.
+      Returns -1 if all needed tiles are available. The tiles of the
+      predecessor are kept apart in the tile cache from then on, see
+      TileMap::keepTilesApart().
+    */
+
+    int missingBorderTile(QuillUndoCommand *command, int tileIndex);
+
     /*!
       Helper function for suggestSaveTask(), used for tiling.
       Can start calculations on its own.
@@ -175,11 +265,10 @@ private:
     Task *newTilingSaveTask(File *file);
 
     /*!
-      Helper function for suggestTilingSaveTask(), used for pushing
-      tiles into the save buffer. Can start calculations on its own.
+      Copies all finished tiles of the current save buffer into it.
     */
 
-    Task *newTilingOverlayTask(File *file);
+    void fillSaveBuffer(QuillUndoStack *stack);
 
     /*!
       Calculates full size, either based on the real full size or
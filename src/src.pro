@@ -21,7 +21,7 @@ include(../common.pri)
 
 CONFIG += quillimagefilter quillmetadata
 
-LIBS += -lexif -lexempi
+LIBS += -lexif -lexempi -ljpeg
 # Generate pkg-config support by default
 # Note that we HAVE TO also create prl config as QMake implementation
 # mixes both of them together.
@@ -52,14 +52,30 @@ HEADERS += quill.h \
            core.h \
            displaylevel.h \
            tilecache.h \
+           savebufferpool.h \
+           tilespill.h \
            tilemap.h \
            savemap.h \
+           losslesstransform.h \
+           scaledjpegload.h \
+           pyramidload.h \
+           jpegerrormanager.h \
+           exifthumbnailload.h \
+           jpegdecodersession.h \
+           jpegtileload.h \
+           localfilterapply.h \
+           borderedtileapply.h \
+           tiledownscale.h \
+           batchoperation.h \
+           storedimageload.h \
+           storedimagesave.h \
            task.h \
            scheduler.h \
            threadmanager.h \
            quillundocommand.h \
            quillundostack.h \
            imagecache.h \
+           resultcache.h \
            historyxml.h \
            unix_platform.h \
            logger.h \
@@ -75,14 +91,29 @@ SOURCES += quill.cpp \
            core.cpp \
            displaylevel.cpp \
            tilecache.cpp \
+           savebufferpool.cpp \
+           tilespill.cpp \
            tilemap.cpp \
            savemap.cpp \
+           losslesstransform.cpp \
+           scaledjpegload.cpp \
+           pyramidload.cpp \
+           exifthumbnailload.cpp \
+           jpegdecodersession.cpp \
+           jpegtileload.cpp \
+           localfilterapply.cpp \
+           borderedtileapply.cpp \
+           tiledownscale.cpp \
+           batchoperation.cpp \
+           storedimageload.cpp \
+           storedimagesave.cpp \
            task.cpp \
            scheduler.cpp \
            threadmanager.cpp \
            quillundocommand.cpp \
            quillundostack.cpp \
            imagecache.cpp \
+           resultcache.cpp \
            historyxml.cpp \
            unix_platform.cpp \
            avthumbnailer.cpp \
@@ -50,6 +50,7 @@ namespace Strings
 
     S(dot,                   ".");
     S(dotXml,                ".xml");
+    S(dotPreviews,           ".previews");
 
     S(gifMimeType,           "image/gif");
 
@@ -62,6 +63,7 @@ namespace Strings
     S(mp4MimeType,           "video/mp4");
 
     S(pngMimeType,           "image/png");
+    S(previewStamp,          "stamp");
     S(png,                   "png");
 
     S(slash,                 "/");
@@ -70,6 +72,7 @@ namespace Strings
 
     S(tempDirDefault,        "/tmp");
     S(tempFilePattern,       "qt_temp.XXXXXX.");
+    S(tileSpillFilePattern,  "quill_tiles.XXXXXX");
     S(thumbsBasePath,        "/.thumbnails");
     S(thumbsFail,            "/fail/quill");
     S(thumbsNormal,          "/.thumbnails/normal");
@@ -37,10 +37,15 @@
 **
 ****************************************************************************/
 
+#include <QuillImageFilter>
+
 #include "task.h"
 
 Task::Task() : m_commandId(0), m_displayLevel(0), m_tileId(0),
-               m_inputImage(QuillImage()), m_filter(0),m_fileName(QString())
+               m_zoomLevel(0),
+               m_inputImage(QuillImage()), m_filter(0),
+               m_operation(0), m_fileName(QString()),
+               m_elapsed(-1)
 {
 }
 
@@ -78,6 +83,16 @@ void Task::setTileId(int tileId)
     m_tileId = tileId;
 }
 
+int Task::zoomLevel() const
+{
+    return m_zoomLevel;
+}
+
+void Task::setZoomLevel(int zoomLevel)
+{
+    m_zoomLevel = zoomLevel;
+}
+
 QuillImage Task::inputImage() const
 {
     return m_inputImage;
@@ -98,3 +113,38 @@ void Task::setFilter(QuillImageFilter *filter)
     m_filter = filter;
 }
 
+TaskOperation *Task::operation() const
+{
+    return m_operation;
+}
+
+void Task::setOperation(TaskOperation *operation)
+{
+    m_operation = operation;
+}
+
+QuillImage Task::apply() const
+{
+    if (m_operation)
+        return m_operation->apply(m_inputImage);
+    else
+        return m_filter->apply(m_inputImage);
+}
+
+QString Task::name() const
+{
+    if (m_operation)
+        return m_operation->name();
+    else
+        return m_filter->name();
+}
+
+qint64 Task::elapsed() const
+{
+    return m_elapsed;
+}
+
+void Task::setElapsed(qint64 usec)
+{
+    m_elapsed = usec;
+}
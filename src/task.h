@@ -52,6 +52,30 @@
 
 class QuillImageFilter;
 
+/*!
+  An operation which a task can run instead of an image filter, for
+  work which does not fit the filter model (e.g. transforming a file
+  directly into another). Like filters, operations are run on the
+  background thread and must not touch any foreground data.
+ */
+
+class TaskOperation {
+ public:
+    virtual ~TaskOperation() {}
+
+    /*!
+      Runs the operation.
+     */
+
+    virtual QuillImage apply(const QuillImage &image) = 0;
+
+    /*!
+      The name of the operation, for logging.
+     */
+
+    virtual QString name() const = 0;
+};
+
 class Task {
  public:
 
@@ -96,6 +120,18 @@ class Task {
 
     void setTileId(int tileId);
 
+    /*!
+      Gets the zoom level of the tile map of the task (see TileMap).
+     */
+
+    int zoomLevel() const;
+
+    /*!
+      Sets the zoom level of the tile map of the task.
+     */
+
+    void setZoomLevel(int zoomLevel);
+
     /*!
       Gets the input image of the task.
      */
@@ -121,11 +157,52 @@ class Task {
 
     void setFilter(QuillImageFilter *filter);
 
+    /*!
+      Gets the operation of the task, if any.
+     */
+
+    TaskOperation *operation() const;
+
+    /*!
+      Sets an operation to be run instead of the filter. Like the
+      filter, the operation stays the property of the caller.
+     */
+
+    void setOperation(TaskOperation *operation);
+
+    /*!
+      Runs the operation of the task if one is set, otherwise the filter.
+     */
+
+    QuillImage apply() const;
+
+    /*!
+      The name of the operation or filter, for logging.
+     */
+
+    QString name() const;
+
+    /*!
+      Gets the time which the background thread spent running the
+      task, in microseconds, or -1 if not known.
+     */
+
+    qint64 elapsed() const;
+
+    /*!
+      Sets the time spent running the task, in microseconds.
+     */
+
+    void setElapsed(qint64 usec);
+
  private:
     int m_commandId;
     int m_displayLevel;
     int m_tileId;
+    int m_zoomLevel;
     QuillImage m_inputImage;
     QuillImageFilter *m_filter;
+    TaskOperation *m_operation;
     QString m_fileName;
+    qint64 m_elapsed;
 };
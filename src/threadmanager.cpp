@@ -80,7 +80,7 @@ bool ThreadManager::isRunning() const
 
 void ThreadManager::run(Task *task)
 {
-    QUILL_LOG(Logger::Module_ThreadManager, "Applying filter " + task->filter()->name());
+    QUILL_LOG(Logger::Module_ThreadManager, "Applying filter " + task->name());
     m_isRunning = true;
     m_task = task;
 
@@ -94,7 +94,7 @@ void ThreadManager::run(Task *task)
 // BackgroundThread emits taskDone signal to this background thread
 void ThreadManager::onTaskDone(QuillImage& image,Task* task)
 {
-    QUILL_LOG(Logger::Module_ThreadManager, "Finished applying " + m_task->filter()->name());
+    QUILL_LOG(Logger::Module_ThreadManager, "Finished applying " + m_task->name());
     m_isRunning = false;
     Core::instance()->processFinishedTask(task, image);
 
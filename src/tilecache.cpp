@@ -41,22 +41,38 @@
 #include <QCache>
 
 #include "tilecache.h"
+#include "tilespill.h"
 
 class ImageTile
 {
 public:
+    ImageTile(TileCache *owner, int tileId) :
+        m_owner(owner), m_tileId(tileId) {}
+
+    // Evicted or replaced tiles are spilled
+    ~ImageTile()
+    {
+        m_owner->evicted(m_tileId, key, image);
+    }
 
     QuillImage image;
     int key;
+
+private:
+    TileCache *m_owner;
+    int m_tileId;
 };
 
-TileCache::TileCache(int cost)
+TileCache::TileCache(int cost) :
+    m_spill(0), m_isClearing(false)
 {
     m_cache.setMaxCost(cost);
 }
 
 TileCache::~TileCache()
 {
+    m_isClearing = true;
+    m_cache.clear();
 }
 
 void TileCache::resizeCache(const int cost)
@@ -71,31 +87,93 @@ int TileCache::cacheCost() const
 
 bool TileCache::searchKey(const int key) const
 {
-    return m_cache.contains(key);
+    return m_cache.contains(qMakePair(key, 0));
+}
+
+QPair<int, int> TileCache::slot(int tileId, int tileMapId) const
+{
+    if (m_apartMaps.contains(tileMapId))
+        return qMakePair(tileId, tileMapId);
+    else
+        return qMakePair(tileId, 0);
 }
 
 void TileCache::setTile(int tileId, int tileMapId, const QuillImage &tile)
 {
-    ImageTile* imageTile = new ImageTile;
+    if (m_spill)
+        m_spill->remove(tileId, tileMapId);
+
+    const QPair<int, int> key = slot(tileId, tileMapId);
+
+    // Replacing a tile of the same map does not spill the old one
+    if (m_cache.contains(key)) {
+        ImageTile *object = m_cache.object(key);
+        if (object->key == tileMapId) {
+            object->image = tile;
+            return;
+        }
+    }
+
+    ImageTile* imageTile = new ImageTile(this, tileId);
     imageTile->image = tile;
     imageTile->key = tileMapId;
 
-    m_cache.insert(tileId, imageTile);
+    m_cache.insert(key, imageTile);
 }
 
-QuillImage TileCache::tile(int tileId, int tileMapId) const
+QuillImage TileCache::tile(int tileId, int tileMapId)
 {
-    if (searchKey(tileId)) {
-        ImageTile *object = m_cache.object(tileId);
+    const QPair<int, int> key = slot(tileId, tileMapId);
+    if (m_cache.contains(key)) {
+        ImageTile *object = m_cache.object(key);
         if (object->key == tileMapId)
             return object->image;
-        else
-            return QuillImage();
-    } else
-        return QuillImage();
+    }
+
+    if (m_spill && m_spill->contains(tileId, tileMapId)) {
+        const QuillImage image = m_spill->take(tileId, tileMapId);
+        setTile(tileId, tileMapId, image);
+        return image;
+    }
+
+    return QuillImage();
+}
+
+void TileCache::keepApart(int tileMapId)
+{
+    if (m_apartMaps.contains(tileMapId))
+        return;
+
+    m_apartMaps.insert(tileMapId);
+
+    // Moving a tile does not spill it
+    foreach (const QPair<int, int> &key, m_cache.keys())
+        if ((key.second == 0) && (m_cache.object(key)->key == tileMapId))
+            m_cache.insert(qMakePair(key.first, tileMapId), m_cache.take(key));
+}
+
+void TileCache::setSpill(TileSpill *spill)
+{
+    m_spill = spill;
+}
+
+TileSpill *TileCache::spill() const
+{
+    return m_spill;
 }
 
 void TileCache::clear()
 {
+    m_isClearing = true;
     m_cache.clear();
+    m_isClearing = false;
+
+    if (m_spill)
+        m_spill->clear();
+}
+
+void TileCache::evicted(int tileId, int tileMapId, const QuillImage &image)
+{
+    if (m_spill && !m_isClearing)
+        m_spill->store(tileId, tileMapId, image);
 }
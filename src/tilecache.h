@@ -49,21 +49,33 @@ TileCache can store a maximum of one tile by tile Id (see TileMap) at
 a time. This also means that TileCache does not support undo. Tile
 cache has an upper size limit, and any items can be removed at any time.
 
+As an exception, the tiles of maps given to keepApart() have slots of
+their own. These are the inputs of filters with a tile border (see
+Quill::setTileBorder()), whose tiles are still needed by the
+neighbouring tiles after the tile with the same id has been
+calculated.
+
 If there is a simultaneous request of more tiles than the tile cache
 has space for, tile cache will not load new tiles.
 
 Due to different cache policies, TileCache is not used to store
 preview images - instead, ImageCache is used for that.
+
+Optionally, tiles which fall out of the cache are kept in a TileSpill,
+from where they are moved back into the cache when asked for.
  */
 
 #ifndef __QUILL_TILE_CACHE_H__
 #define __QUILL_TILE_CACHE_H__
 
 #include <QCache>
+#include <QPair>
+#include <QSet>
 
 class QuillImage;
 class TileCachePrivate;
 class ImageTile;
+class TileSpill;
 
 class TileCache
 {
@@ -104,21 +116,65 @@ public:
     bool searchKey(const int key) const;
 
     /*!
-      Returns an individual tile
+      Returns an individual tile. A tile found in the spill is moved
+      back into the cache.
       @param tileId the id of the tile within its tile map
       @param tileMapId the unique id of the tile map
      */
-    QuillImage tile(int tileId, int tileMapId) const;
+    QuillImage tile(int tileId, int tileMapId);
+
+    /*!
+      Gives the tiles of a tile map slots of their own, so that they
+      are not replaced by the tiles of other maps with the same tile
+      ids. Tiles of the map which are already in the cache are kept.
+      @param tileMapId the unique id of the tile map
+     */
+
+    void keepApart(int tileMapId);
+
+    /*!
+      Sets the spill which receives the tiles falling out of the
+      cache, or 0 to disable spilling. The spill stays the property
+      of the caller.
+     */
+
+    void setSpill(TileSpill *spill);
+
+    /*!
+      The spill of the cache, if any.
+     */
+
+    TileSpill *spill() const;
 
     /*!
-      Clears the tile cache.
+      Clears the tile cache and its spill.
      */
     void clear();
 
     ~TileCache();
 
 private:
-    QCache<int, ImageTile> m_cache;
+    friend class ImageTile;
+
+    /*!
+      Called when a tile is removed from the cache for any reason.
+     */
+
+    void evicted(int tileId, int tileMapId, const QuillImage &image);
+
+    /*!
+      The cache key of a tile: the tile id, and the tile map id for
+      maps kept apart or 0 for the slot shared by all other maps.
+     */
+
+    QPair<int, int> slot(int tileId, int tileMapId) const;
+
+    QCache<QPair<int, int>, ImageTile> m_cache;
+    // The maps with slots of their own
+    QSet<int> m_apartMaps;
+    TileSpill *m_spill;
+    // Tiles removed while clearing are not spilled
+    bool m_isClearing;
 };
 
 
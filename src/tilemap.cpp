@@ -40,6 +40,7 @@
 #include <QuillImage>
 #include <QuillImageFilter>
 #include <QCache>
+#include <QPainter>
 
 #include "tilemap.h"
 #include "tilecache.h"
@@ -47,8 +48,9 @@
 int TileMap::m_nextId = 1;
 
 TileMap::TileMap(const QSize &fullImageSize, const QSize &tileSize,
-                 TileCache* tileCache) :
-    m_fullImageSize(fullImageSize), m_tiles(tileCache)
+                 TileCache* tileCache, int zoomLevel) :
+    m_fullImageSize(fullImageSize), m_tileSize(tileSize), m_tiles(tileCache),
+    m_zoomLevel(zoomLevel)
 {
     m_id = m_nextId;
     m_nextId++;
@@ -80,6 +82,7 @@ TileMap::TileMap(TileMap *previousMap, QuillImageFilter *filter)
     m_tileAreas = QVector<QRect>(tileCount);
 
     m_tiles = previousMap->tileCache();
+    m_zoomLevel = previousMap->zoomLevel();
 
     for (int t = 0; t<tileCount; t++)
         m_tileAreas[t] = filter->newArea(previousMap->fullImageSize(),
@@ -95,13 +98,31 @@ QSize TileMap::fullImageSize() const
     return m_fullImageSize;
 }
 
+int TileMap::zoomLevel() const
+{
+    return m_zoomLevel;
+}
+
+QSize TileMap::tileSize() const
+{
+    return m_tileSize;
+}
+
 QuillImage TileMap::tile(int index) const
 {
-    QuillImage image = m_tiles->tile(index, m_id);
+    QuillImage image = m_tiles->tile(cacheKey(index), m_id);
 
     if (image.isNull()) {
         image.setFullImageSize(m_fullImageSize);
         image.setArea(m_tileAreas.at(index));
+
+        // Reduced tiles are rounded up to at least one pixel
+        if (m_zoomLevel > 0) {
+            const int factor = 1 << m_zoomLevel;
+            const QSize size = m_tileAreas.at(index).size();
+            image.setTargetSize(QSize(qMax(1, (size.width() + factor - 1) / factor),
+                                      qMax(1, (size.height() + factor - 1) / factor)));
+        }
         return image;
     }
     else
@@ -110,7 +131,12 @@ QuillImage TileMap::tile(int index) const
 
 void TileMap::setTile(int index, const QuillImage &tile)
 {
-    m_tiles->setTile(index, m_id, tile);
+    m_tiles->setTile(cacheKey(index), m_id, tile);
+}
+
+void TileMap::keepTilesApart()
+{
+    m_tiles->keepApart(m_id);
 }
 
 QRect TileMap::tileArea(int index) const
@@ -123,7 +149,7 @@ int TileMap::count() const
     int result = 0;
 
     for (int index=0; index<m_tileAreas.count(); index++)
-        if (!m_tiles->tile(index, m_id).isNull())
+        if (!m_tiles->tile(cacheKey(index), m_id).isNull())
             result++;
 
     return result;
@@ -150,6 +176,52 @@ QList<int> TileMap::findArea(const QRect &area) const
     return indices;
 }
 
+QList<int> TileMap::findArea(const QList<QRect> &areas) const
+{
+    QList<int> indices;
+
+    for (int i=0; i<m_tileAreas.count(); i++)
+        if (isValid(i))
+            foreach (const QRect &area, areas)
+                if (m_tileAreas[i].intersects(area)) {
+                    indices.append(i);
+                    break;
+                }
+
+    return indices;
+}
+
+QRect TileMap::borderArea(int index, int border) const
+{
+    return m_tileAreas.at(index).adjusted(-border, -border, border, border).
+        intersected(QRect(QPoint(0, 0), m_fullImageSize));
+}
+
+QuillImage TileMap::assemble(const QRect &area) const
+{
+    QImage image;
+
+    foreach (int index, findArea(area)) {
+        const QuillImage part = tile(index);
+        if (part.isNull())
+            return QuillImage();
+
+        if (image.isNull()) {
+            image = QImage(area.size(), part.format());
+            image.fill(0);
+        }
+
+        QPainter painter(&image);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(m_tileAreas.at(index).topLeft() - area.topLeft(), part);
+    }
+
+    QuillImage result(image);
+    result.setFullImageSize(m_fullImageSize);
+    result.setArea(area);
+    return result;
+}
+
 static QPoint referencePoint;
 
 int TileMap::proximity(const QRect &rect, const QPoint &point) const
@@ -218,6 +290,18 @@ QList<QuillImage> TileMap::nonEmptyTiles(const QRect &area) const
     return images;
 }
 
+QList<QuillImage> TileMap::nonEmptyTiles(const QList<QRect> &areas) const
+{
+    QList<QuillImage> images;
+    QList<int> indices = findArea(areas);
+
+    for (int i = 0; i<indices.count(); i++)
+        if (!tile(indices[i]).isNull())
+            images.append(tile(indices[i]));
+
+    return images;
+}
+
 QList<QuillImage> TileMap::newTiles(const QRect &oldArea, const QRect &newArea) const
 {
     QList<QuillImage> images;
@@ -257,6 +341,12 @@ int TileMap::tileAreasCount() const
     return m_tileAreas.size();
 }
 
+int TileMap::cacheKey(int index) const
+{
+    // Tile ids of different zoom levels do not overlap
+    return index + m_zoomLevel * m_tileAreas.count();
+}
+
 bool TileMap::isValid(int index) const
 {
     QRect area = m_tileAreas[index];
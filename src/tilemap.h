@@ -47,9 +47,16 @@ For each image related to one state in an edit history (ie
 QuillUndoCommand) there is a tile map which contains the tile
 positions in full image coordinates. The tile is identified with its
 tile id, which stays the same from a tile map to the next one in the
-edit history. If we want to calculate a tile, we can calculate it
-completely from a predecessor with the same tile id (as there is
-currently no information transfer between different tiles).
+edit history. If we want to calculate a tile, we can usually calculate
+it completely from a predecessor with the same tile id. Filters which
+read pixels around each output pixel (see Quill::setTileBorder())
+are instead given the predecessor tile extended by a border, which
+is assembled from the neighbouring tiles with assemble().
+
+A tile map may also have a zoom level above 0, in which case its
+tiles cover the same areas with the same tile ids, but their pixels
+are scaled down by a factor of 2 for each zoom level. Tiles of
+different zoom levels are kept apart in the tile cache.
  */
 
 #ifndef __QUILL_TILE_MAP_H_
@@ -73,9 +80,12 @@ public:
 
       @param fullImageSize the size of a full image.
       @param tileSize size of an individual tile.
+      @param zoomLevel 0 for full resolution tiles, 1 for half
+      resolution and so on.
      */
 
-    TileMap(const QSize &fullImageSize, const QSize &tileSize, TileCache* tileCache);
+    TileMap(const QSize &fullImageSize, const QSize &tileSize, TileCache* tileCache,
+            int zoomLevel = 0);
 
     /*!
       Creates a tile map by applying a filter to a previous tile map.
@@ -97,6 +107,19 @@ public:
 
     QSize fullImageSize() const;
 
+    /*!
+      Returns the zoom level of the tile map; 0 for full resolution.
+     */
+
+    int zoomLevel() const;
+
+    /*!
+      Returns the tile size which the tile map was created with, or
+      QSize() if it was derived from a previous tile map.
+     */
+
+    QSize tileSize() const;
+
     /*!
       Returns an individual tile by its index.
     */
@@ -109,6 +132,13 @@ public:
 
     void setTile(int index, const QuillImage &tile);
 
+    /*!
+      Keeps the tiles of this map apart from the tiles of other maps
+      in the tile cache, see TileCache::keepApart().
+    */
+
+    void keepTilesApart();
+
     /*!
       Returns the area of a tile by index (internal use only).
     */
@@ -134,6 +164,28 @@ public:
 
     QList<int> findArea(const QRect &area) const;
 
+    /*!
+      Finds all tiles which cover parts of any of the given areas.
+      Tiles covered by several areas are only included once.
+     */
+
+    QList<int> findArea(const QList<QRect> &areas) const;
+
+    /*!
+      Returns the area of a tile extended by a border on each side,
+      limited to the full image.
+     */
+
+    QRect borderArea(int index, int border) const;
+
+    /*!
+      Assembles an image of the given area from the tiles which cover
+      it. Returns a null image if some of the tiles are not in the
+      cache. Only for full resolution tile maps.
+     */
+
+    QuillImage assemble(const QRect &area) const;
+
     /*!
       Finds the first tile in the area which is not in the cache.
       As a side-effect, raises the priority of all other tiles in the
@@ -161,6 +213,15 @@ public:
 
     QList<QuillImage> nonEmptyTiles(const QRect &area) const;
 
+    /*!
+      As in nonEmptyTiles(), but for all tiles which cover parts of
+      any of the given areas, e.g. the viewports of several
+      references to a file. Tiles covered by several areas are only
+      included once.
+    */
+
+    QList<QuillImage> nonEmptyTiles(const QList<QRect> &areas) const;
+
     /*!
       As in nonEmptyTiles(), but returned tiles may not be part of
       oldArea.
@@ -228,12 +289,21 @@ private:
 
     QList<int> sortByProximity(QList<int> indices, const QPoint &point) const;
 
+    /*!
+      The key of a tile in the tile cache.
+     */
+
+    int cacheKey(int index) const;
+
  private:
     QSize m_fullImageSize;
+    QSize m_tileSize;
     TileCache* m_tiles;
 
     QVector<QRect> m_tileAreas;
 
+    int m_zoomLevel;
+
     int m_id;
     static int m_nextId;
 };
@@ -0,0 +1,227 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <QDir>
+#include <QTemporaryFile>
+#include <QuillImage>
+
+#include "tilespill.h"
+#include "strings.h"
+#include "unix_platform.h"
+
+TileSpill::TileSpill(const QString &path, qint64 maxBytes) :
+    m_path(path), m_maxBytes(maxBytes), m_file(0), m_data(0),
+    m_failed(false), m_end(0), m_bytes(0)
+{
+}
+
+TileSpill::~TileSpill()
+{
+    delete m_file;
+}
+
+bool TileSpill::store(int tileId, int tileMapId, const QuillImage &tile)
+{
+    // Color tables are not kept
+    if (tile.isNull() || (tile.depth() <= 8) || !open())
+        return false;
+
+    const qint64 tileKey = key(tileId, tileMapId);
+    if (m_entries.contains(tileKey))
+        removeKey(tileKey);
+
+    Entry entry;
+    entry.bytesPerLine = tile.bytesPerLine();
+    entry.format = tile.format();
+    entry.size = tile.size();
+    entry.header = QuillImage(tile, QImage());
+
+    const qint64 size = entryBytes(entry);
+    entry.offset = allocate(size);
+    if (entry.offset < 0)
+        return false;
+
+    memcpy(m_data + entry.offset, tile.bits(), size);
+
+    m_entries.insert(tileKey, entry);
+    m_order.append(tileKey);
+    m_bytes += size;
+    return true;
+}
+
+bool TileSpill::contains(int tileId, int tileMapId) const
+{
+    return m_entries.contains(key(tileId, tileMapId));
+}
+
+QuillImage TileSpill::take(int tileId, int tileMapId)
+{
+    const qint64 tileKey = key(tileId, tileMapId);
+    if (!m_entries.contains(tileKey))
+        return QuillImage();
+
+    const Entry entry = m_entries.value(tileKey);
+
+    // The same size and format always give the same line length
+    QImage image(entry.size, entry.format);
+    memcpy(image.bits(), m_data + entry.offset, entryBytes(entry));
+
+    removeKey(tileKey);
+    return QuillImage(entry.header, image);
+}
+
+void TileSpill::remove(int tileId, int tileMapId)
+{
+    const qint64 tileKey = key(tileId, tileMapId);
+    if (m_entries.contains(tileKey))
+        removeKey(tileKey);
+}
+
+void TileSpill::clear()
+{
+    m_entries.clear();
+    m_order.clear();
+    m_freeSlots.clear();
+    m_end = 0;
+    m_bytes = 0;
+
+    // Give the disk space back; the file is created again when needed
+    delete m_file;
+    m_file = 0;
+    m_data = 0;
+    m_failed = false;
+}
+
+QString TileSpill::path() const
+{
+    return m_path;
+}
+
+qint64 TileSpill::maxBytes() const
+{
+    return m_maxBytes;
+}
+
+qint64 TileSpill::bytes() const
+{
+    return m_bytes;
+}
+
+int TileSpill::count() const
+{
+    return m_entries.count();
+}
+
+bool TileSpill::open()
+{
+    if (m_data)
+        return true;
+
+    // Do not try again after a failure
+    if (m_failed || (m_maxBytes <= 0))
+        return false;
+
+    m_failed = true;
+
+    if (!QDir().mkpath(m_path))
+        return false;
+
+    m_file = new QTemporaryFile(m_path + QDir::separator() +
+                                Strings::tileSpillFilePattern);
+
+    // A sparse file would only run out of disk space when a tile is
+    // copied into the map, which raises SIGBUS instead of an error
+    if (m_file->open() && FileSystem::allocate(m_file, m_maxBytes))
+        m_data = m_file->map(0, m_maxBytes);
+
+    if (!m_data) {
+        delete m_file;
+        m_file = 0;
+        return false;
+    }
+
+    m_failed = false;
+    return true;
+}
+
+qint64 TileSpill::allocate(qint64 size)
+{
+    if (size > m_maxBytes)
+        return -1;
+
+    while (true) {
+        for (int i=0; i<m_freeSlots.count(); i++)
+            if (m_freeSlots.at(i).second == size)
+                return m_freeSlots.takeAt(i).first;
+
+        if (m_end + size <= m_maxBytes) {
+            const qint64 offset = m_end;
+            m_end += size;
+            return offset;
+        }
+
+        // Only slots of other sizes are left, start from the beginning
+        if (m_order.isEmpty()) {
+            m_freeSlots.clear();
+            m_end = 0;
+        }
+        else
+            removeKey(m_order.first());
+    }
+}
+
+void TileSpill::removeKey(qint64 tileKey)
+{
+    const Entry entry = m_entries.take(tileKey);
+    m_order.removeOne(tileKey);
+
+    const qint64 size = entryBytes(entry);
+    m_bytes -= size;
+    m_freeSlots.append(qMakePair(entry.offset, size));
+}
+
+qint64 TileSpill::key(int tileId, int tileMapId)
+{
+    return ((qint64)tileMapId << 32) | (quint32)tileId;
+}
+
+qint64 TileSpill::entryBytes(const Entry &entry)
+{
+    return (qint64)entry.bytesPerLine * entry.size.height();
+}
@@ -0,0 +1,196 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+/*!
+  \class TileSpill
+
+  \brief A second tier for TileCache, which keeps evicted tiles in a
+  memory-mapped scratch file.
+
+Tiles which fall out of TileCache are copied into the spill instead
+of being lost, so that panning back to them does not need to load
+and filter them again. A tile taken back from the spill is removed
+from it, so that each tile is either in TileCache or in the spill.
+
+The scratch file is created on the first use, sized to the limit and
+mapped into memory as a whole, so that storing and taking tiles are
+plain memory copies. Tiles are mostly of the same size, so the slot
+of a removed tile is reused by the next tile of the same size; when
+the file is full, the oldest tiles are dropped first.
+ */
+
+#ifndef __QUILL_TILE_SPILL_H__
+#define __QUILL_TILE_SPILL_H__
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QuillImage>
+
+class QTemporaryFile;
+
+class TileSpill
+{
+public:
+
+    /*!
+      Creates a tile spill.
+      @param path the directory of the scratch file
+      @param maxBytes the size of the scratch file
+     */
+
+    TileSpill(const QString &path, qint64 maxBytes);
+
+    ~TileSpill();
+
+    /*!
+      Copies a tile into the spill. Returns false if the tile does not
+      fit or the scratch file could not be created.
+      @param tileId the id of the tile within its tile map
+      @param tileMapId the unique id of the tile map
+     */
+
+    bool store(int tileId, int tileMapId, const QuillImage &tile);
+
+    /*!
+      If the spill contains a tile.
+     */
+
+    bool contains(int tileId, int tileMapId) const;
+
+    /*!
+      Removes a tile from the spill and returns it, or a null image
+      if the spill does not contain it.
+     */
+
+    QuillImage take(int tileId, int tileMapId);
+
+    /*!
+      Removes a tile from the spill.
+     */
+
+    void remove(int tileId, int tileMapId);
+
+    /*!
+      Removes all tiles from the spill.
+     */
+
+    void clear();
+
+    /*!
+      The directory of the scratch file.
+     */
+
+    QString path() const;
+
+    /*!
+      The size of the scratch file.
+     */
+
+    qint64 maxBytes() const;
+
+    /*!
+      The amount of pixel data currently kept in the spill.
+     */
+
+    qint64 bytes() const;
+
+    /*!
+      The number of tiles currently kept in the spill.
+     */
+
+    int count() const;
+
+private:
+
+    class Entry
+    {
+    public:
+        qint64 offset;
+        int bytesPerLine;
+        QImage::Format format;
+        QSize size;
+        // The tile attributes without the pixels
+        QuillImage header;
+    };
+
+    /*!
+      Creates and maps the scratch file if needed. The disk space of
+      the whole file is reserved here, so that a full disk disables
+      the spill instead of crashing store().
+     */
+
+    bool open();
+
+    /*!
+      Finds a place for the given amount of bytes, dropping old tiles
+      if needed. Returns -1 if there is no place.
+     */
+
+    qint64 allocate(qint64 size);
+
+    /*!
+      Removes the entry with the given key and frees its slot.
+     */
+
+    void removeKey(qint64 key);
+
+    static qint64 key(int tileId, int tileMapId);
+
+    static qint64 entryBytes(const Entry &entry);
+
+    QString m_path;
+    qint64 m_maxBytes;
+    QTemporaryFile *m_file;
+    uchar *m_data;
+    bool m_failed;
+
+    // End of the used part of the file
+    qint64 m_end;
+    qint64 m_bytes;
+
+    QHash<qint64, Entry> m_entries;
+    // Keys of the entries, oldest first
+    QList<qint64> m_order;
+    // Slots of removed entries, as offset and size
+    QList<QPair<qint64, qint64> > m_freeSlots;
+};
+
+#endif // __QUILL_TILE_SPILL_H__
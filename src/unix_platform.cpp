@@ -41,10 +41,12 @@
 #include "quillfile.h"
 
 #include <QDir>
+#include <QFile>
 #include <QCoreApplication>
 #include <QUrl>
 
 #include <utime.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <signal.h>
 
@@ -63,6 +65,12 @@ bool FileSystem::setFileModificationDateTime(const QString &fileName,
     return (result != 0);
 }
 
+bool FileSystem::allocate(QFile *file, qint64 size)
+{
+    // Unlike ftruncate(), this does not leave holes in the file
+    return (posix_fallocate(file->handle(), 0, size) == 0);
+}
+
 bool LockFile::lockQuillFile(const QuillFile* quillFile, bool overrideOwnLock)
 {
     if (isQuillFileLocked(quillFile, overrideOwnLock)) {
@@ -49,6 +49,7 @@
  */
 
 class QuillFile;
+class QFile;
 
 class FileSystem {
 
@@ -61,6 +62,16 @@ class FileSystem {
 
     static bool setFileModificationDateTime(const QString &fileName,
                                             const QDateTime &dateTime);
+
+    /*!
+      Grows an open file to the given size and reserves its disk
+      blocks, so that writing the file through a memory map cannot
+      fail later because the disk is full.
+
+      @returns true if success, false if failed
+    */
+
+    static bool allocate(QFile *file, qint64 size);
 };
 
 class LockFile {
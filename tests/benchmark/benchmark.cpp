@@ -48,6 +48,7 @@
 #include "autofix.h"
 #include "straighten.h"
 #include "redeye.h"
+#include "viewport.h"
 #include "../../src/strings.h"
 
 void help()
@@ -62,6 +63,7 @@ void help()
     std::cout << "04 autofix        - Thumbnail response for Autofix edit\n";
     std::cout << "05 straighten     - Thumbnail responses for Straighten edit\n";
     std::cout << "06 redeye         - Thumbnail response for Red eye removal\n";
+    std::cout << "07 viewport       - Tile response for a pan and zoom trajectory, use -w and -h for the viewport size\n";
     std::cout << "\n";
     std::cout << "Options:\n";
     std::cout << "-n  number of files, default 100\n";
@@ -73,6 +75,9 @@ void help()
     std::cout << "-x  Effect centerpoint X, full-image coords (red eye removal)\n";
     std::cout << "-y  Effect centerpoint Y, full-image coords (red eye removal)\n";
     std::cout << "-t  Effect tolerance radius, full-image coords (red eye removal)\n";
+    std::cout << "-s  Number of pan steps, default 20 (viewport)\n";
+    std::cout << "-i  Milliseconds between viewports, default 0 = wait for each (viewport)\n";
+    std::cout << "-p  Recorded trajectory file, one \"x y w h\" per line (viewport)\n";
 }
 
 int c;
@@ -245,6 +250,33 @@ int main(int argc, char **argv)
         }
         redeye(fileName, n, QSize(w, h), QPoint(x, y), t);
     }
+    else if ((QString(argv[1]) == "07") || (QString(argv[1]) == "viewport")) {
+        QString fileName = argv[2];
+
+        int w = 800, h = 480, s = 20, i = 0;
+        QString p;
+        while ((c = getopt(argc, argv, "w:h:s:i:p:")) != -1) {
+            switch(c) {
+            case 'w' :
+                w = QString(optarg).toInt();
+                break;
+            case 'h' :
+                h = QString(optarg).toInt();
+                break;
+            case 's' :
+                s = QString(optarg).toInt();
+                break;
+            case 'i' :
+                i = QString(optarg).toInt();
+                break;
+            case 'p' :
+                p = QString(optarg);
+                break;
+            }
+        }
+
+        viewport(fileName, QSize(w, h), s, i, p);
+    }
 
     else
         help();
@@ -13,5 +13,5 @@ CONFIG += quillimagefilter
 include(../../common.pri)
 
 # Input
-SOURCES += benchmark.cpp batchrotate.cpp generatethumbs.cpp loadthumbs.cpp tiling.cpp autofix.cpp straighten.cpp redeye.cpp
-HEADERS += batchrotate.h generatethumbs.h generatethumbs.h tiling.h autofix.h straighten.h redeye.h
+SOURCES += benchmark.cpp batchrotate.cpp generatethumbs.cpp loadthumbs.cpp tiling.cpp autofix.cpp straighten.cpp redeye.cpp viewport.cpp
+HEADERS += batchrotate.h generatethumbs.h generatethumbs.h tiling.h autofix.h straighten.h redeye.h viewport.h
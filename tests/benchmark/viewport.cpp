@@ -0,0 +1,292 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+#include <QTime>
+#include <QHash>
+#include <iostream>
+
+#include <Quill>
+#include <QuillFile>
+#include "../../src/strings.h"
+#include "viewport.h"
+
+ViewPortRecorder::ViewPortRecorder(QEventLoop *loop) :
+    m_loop(loop), m_replaying(false)
+{
+}
+
+void ViewPortRecorder::setReplaying(bool replaying)
+{
+    m_replaying = replaying;
+}
+
+void ViewPortRecorder::setViewPort(const QRect &viewPort)
+{
+    m_viewPort = viewPort;
+    m_viewPorts.append(viewPort);
+}
+
+void ViewPortRecorder::tilesAvailable(const QuillImageList images)
+{
+    foreach (QuillImage image, images)
+        if (image.area() != QRect(QPoint(0, 0), image.fullImageSize())) {
+            m_tiles.append(image.area());
+            m_tileViewPorts.append(m_viewPorts.count() - 1);
+            m_computed.append(!m_replaying);
+        }
+    m_loop->quit();
+}
+
+bool ViewPortRecorder::isViewPortComplete(const QSize &fullImageSize,
+                                          const QSize &tileSize) const
+{
+    const QRect area = m_viewPort.intersected(QRect(QPoint(0, 0),
+                                                    fullImageSize));
+    if (area.isEmpty())
+        return true;
+
+    const int firstX = area.left() / tileSize.width();
+    const int firstY = area.top() / tileSize.height();
+    const int lastX = area.right() / tileSize.width();
+    const int lastY = area.bottom() / tileSize.height();
+
+    // Only tiles received while this viewport has been active count
+    const int current = m_viewPorts.count() - 1;
+    for (int y = firstY; y <= lastY; y++)
+        for (int x = firstX; x <= lastX; x++) {
+            const QPoint topLeft(x * tileSize.width(), y * tileSize.height());
+            bool found = false;
+            for (int i = m_tiles.count() - 1;
+                 (i >= 0) && (m_tileViewPorts.at(i) == current); i--)
+                if (m_tiles.at(i).topLeft() == topLeft) {
+                    found = true;
+                    break;
+                }
+            if (!found)
+                return false;
+        }
+    return true;
+}
+
+int ViewPortRecorder::tileCount() const
+{
+    return m_computed.count(true);
+}
+
+int ViewPortRecorder::recomputedCount() const
+{
+    QHash<QString, int> seen;
+    int recomputed = 0;
+    for (int i = 0; i < m_tiles.count(); i++) {
+        if (!m_computed.at(i))
+            continue;
+        const QRect tile = m_tiles.at(i);
+        const QString key = QString("%1,%2").arg(tile.left()).arg(tile.top());
+        if (seen.contains(key))
+            recomputed++;
+        else
+            seen.insert(key, 1);
+    }
+    return recomputed;
+}
+
+int ViewPortRecorder::wastedCount() const
+{
+    int wasted = 0;
+    for (int i = 0; i < m_tiles.count(); i++) {
+        if (!m_computed.at(i))
+            continue;
+        bool shown = false;
+        for (int j = m_tileViewPorts.at(i); j < m_viewPorts.count(); j++)
+            if (m_tiles.at(i).intersects(m_viewPorts.at(j))) {
+                shown = true;
+                break;
+            }
+        if (!shown)
+            wasted++;
+    }
+    return wasted;
+}
+
+/*!
+  A pan across the middle of the image, followed by a pinch zoom in
+  towards the center and back out again.
+ */
+
+static QList<QRect> scriptedTrajectory(const QSize &fullImageSize,
+                                       const QSize &size, int steps)
+{
+    QList<QRect> trajectory;
+    const int y = (fullImageSize.height() - size.height()) / 2;
+    const int range = qMax(fullImageSize.width() - size.width(), 0);
+
+    for (int i = 0; i < steps; i++)
+        trajectory.append(QRect(QPoint(range * i / qMax(steps - 1, 1), y),
+                                size));
+
+    const QPoint center = QRect(QPoint(0, 0), fullImageSize).center();
+    const int zoomSteps = steps / 2;
+    for (int i = 0; i < 2 * zoomSteps; i++) {
+        const int k = (i < zoomSteps) ? i + 1 : 2 * zoomSteps - i - 1;
+        qreal factor = 1.0;
+        for (int j = 0; j < k; j++)
+            factor *= 0.85;
+        QRect rect(QPoint(0, 0), size * factor);
+        rect.moveCenter(center);
+        trajectory.append(rect);
+    }
+    return trajectory;
+}
+
+/*!
+  Reads a recorded trajectory, one "x y width height" viewport per line.
+ */
+
+static QList<QRect> recordedTrajectory(const QString &fileName)
+{
+    QList<QRect> trajectory;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return trajectory;
+
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        int x, y, w, h;
+        stream >> x >> y >> w >> h;
+        if (stream.status() != QTextStream::Ok)
+            break;
+        trajectory.append(QRect(x, y, w, h));
+    }
+    return trajectory;
+}
+
+void viewport(QString fileName, QSize size, int steps, int interval,
+              QString trajectoryFileName)
+{
+    QEventLoop loop;
+    ViewPortRecorder recorder(&loop);
+    QTimer timer;
+    timer.setSingleShot(true);
+    QObject::connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+
+    const QSize tileSize(256, 256);
+
+    Quill::setPreviewSize(0, QSize(320, 200));
+    Quill::setDefaultTileSize(tileSize);
+
+    QuillFile *file = new QuillFile(fileName, Strings::jpg);
+    QObject::connect(file, SIGNAL(imageAvailable(const QuillImageList)),
+                     &recorder, SLOT(tilesAvailable(const QuillImageList)));
+    file->setDisplayLevel(1);
+
+    while (Quill::isCalculationInProgress())
+        loop.exec();
+
+    QList<QRect> trajectory;
+    if (trajectoryFileName.isEmpty())
+        trajectory = scriptedTrajectory(file->fullImageSize(), size, steps);
+    else
+        trajectory = recordedTrajectory(trajectoryFileName);
+
+    std::cout << "Following " << trajectory.count() << " viewports, "
+              << interval << " ms between viewports\n";
+
+    QTime time;
+    int completed = 0, completionTime = 0;
+
+    for (int i = 0; i < trajectory.count(); i++) {
+        const QRect viewPort = trajectory.at(i);
+        const int tilesBefore = recorder.tileCount();
+        const int recomputedBefore = recorder.recomputedCount();
+        recorder.setViewPort(viewPort);
+        time.restart();
+        recorder.setReplaying(true);
+        file->setViewPort(viewPort);
+        recorder.setReplaying(false);
+        if (interval > 0)
+            timer.start(interval);
+
+        int elapsed = -1;
+        forever {
+            if ((elapsed < 0) &&
+                recorder.isViewPortComplete(file->fullImageSize(), tileSize))
+                elapsed = time.elapsed();
+            if (interval > 0) {
+                if (!timer.isActive())
+                    break;
+            } else if ((elapsed >= 0) || !Quill::isCalculationInProgress())
+                break;
+            loop.exec();
+        }
+
+        std::cout << "Viewport " << i << " (" << viewPort.left() << ","
+                  << viewPort.top() << " " << viewPort.width() << "x"
+                  << viewPort.height() << "): ";
+        if (elapsed >= 0) {
+            std::cout << "complete in " << elapsed << " ms";
+            completed++;
+            completionTime += elapsed;
+        } else
+            std::cout << "incomplete";
+        std::cout << ", " << recorder.tileCount() - tilesBefore
+                  << " tiles computed, "
+                  << recorder.recomputedCount() - recomputedBefore
+                  << " recomputed\n";
+    }
+
+    timer.stop();
+
+    std::cout << "Viewports completed: " << completed << "/"
+              << trajectory.count() << "\n";
+    if (completed > 0)
+        std::cout << "Average time to complete viewport: "
+                  << completionTime / completed << " ms\n";
+    std::cout << "Tiles computed: " << recorder.tileCount() << "\n";
+    std::cout << "Tiles recomputed after cache eviction: "
+              << recorder.recomputedCount() << "\n";
+    std::cout << "Tiles wasted (never inside a viewport): "
+              << recorder.wastedCount() << "\n";
+
+    delete file;
+}
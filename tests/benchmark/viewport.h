@@ -0,0 +1,114 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#ifndef VIEWPORT_H
+#define VIEWPORT_H
+
+#include <QObject>
+#include <QString>
+#include <QSize>
+#include <QRect>
+#include <QList>
+#include <QuillImage>
+
+class QEventLoop;
+
+/*!
+  Records the tiles received by a file during the viewport benchmark,
+  together with the viewport which was active when each tile arrived.
+ */
+
+class ViewPortRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    ViewPortRecorder(QEventLoop *loop);
+
+    /*!
+      Sets the viewport which is used to classify the incoming tiles.
+     */
+    void setViewPort(const QRect &viewPort);
+
+    /*!
+      While set, incoming tiles are treated as tile cache hits being
+      replayed for a new viewport, not as newly computed tiles.
+     */
+    void setReplaying(bool replaying);
+
+    /*!
+      Returns true if all tiles inside the current viewport have arrived.
+     */
+    bool isViewPortComplete(const QSize &fullImageSize,
+                            const QSize &tileSize) const;
+
+    /*!
+      Number of tiles computed in total.
+     */
+    int tileCount() const;
+
+    /*!
+      Number of tiles computed more than once, meaning that they were
+      evicted from the tile cache and had to be computed again.
+     */
+    int recomputedCount() const;
+
+    /*!
+      Number of tiles which did not touch the viewport active at the
+      time of their arrival, and never touched any later viewport.
+     */
+    int wastedCount() const;
+
+public slots:
+    void tilesAvailable(const QuillImageList images);
+
+private:
+    QEventLoop *m_loop;
+    bool m_replaying;
+    QRect m_viewPort;
+    QList<QRect> m_viewPorts;
+    QList<QRect> m_tiles;
+    QList<int> m_tileViewPorts;
+    QList<bool> m_computed;
+};
+
+void viewport(QString fileName, QSize size, int steps, int interval,
+              QString trajectoryFileName);
+
+#endif
@@ -18,6 +18,8 @@ SUBDIRS += \
            ut_quill \
            ut_tilemap \
            ut_savemap \
+           ut_savebufferpool \
+           ut_tilespill \
            ut_imagecache \
            ut_command \
            ut_stack \
@@ -25,6 +27,7 @@ SUBDIRS += \
            ut_core \
            ut_file \
            ut_thumbnail \
+           ut_avthumbnailer \
            ut_tileloading \
            ut_error \
            ut_format \
@@ -33,6 +36,7 @@ SUBDIRS += \
            ut_quillmetadata \
            ut_regions \
            ut_autoclean \
+           ut_thumbgen \
            ut_filtering \
            benchmark  \
 
@@ -0,0 +1,199 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QCryptographicHash>
+#include <QUrl>
+#include <Quill>
+#include <QuillFile>
+#include "avthumbnailer.h"
+#include "ut_avthumbnailer.h"
+
+static const QString videoFile("/usr/share/libquill-tests/video/Alvin_2.mp4");
+static const QString basePath("/tmp/quill/avthumbnailer");
+
+ut_avthumbnailer::ut_avthumbnailer()
+{
+}
+
+void ut_avthumbnailer::initTestCase()
+{
+}
+
+void ut_avthumbnailer::cleanupTestCase()
+{
+}
+
+void ut_avthumbnailer::init()
+{
+    Quill::initTestingMode();
+    Quill::setPreviewLevelCount(2);
+    Quill::setPreviewSize(0, QSize(64, 64));
+    Quill::setMinimumPreviewSize(0, QSize(64, 64));
+    Quill::setPreviewSize(1, QSize(128, 128));
+    Quill::setThumbnailBasePath(basePath);
+    Quill::setThumbnailFlavorName(0, "cropped");
+    Quill::setThumbnailFlavorName(1, "large");
+    Quill::setThumbnailExtension("png");
+}
+
+void ut_avthumbnailer::cleanup()
+{
+    Quill::cleanup();
+
+    QFile::remove(thumbnailName("cropped", videoFile));
+    QFile::remove(thumbnailName("large", videoFile));
+}
+
+bool ut_avthumbnailer::waitForSignals(QSignalSpy *spy, int count)
+{
+    for (int i=0; (i<1000) && (spy->count() < count); i++)
+        QTest::qWait(10);
+    return spy->count() == count;
+}
+
+QString ut_avthumbnailer::thumbnailName(const QString &flavor,
+                                        const QString &fileName)
+{
+    const QFileInfo info(fileName);
+    const QByteArray uri =
+        QUrl::fromLocalFile(info.dir().canonicalPath() + "/" +
+                            info.fileName()).toEncoded();
+    return basePath + "/" + flavor + "/" +
+        QCryptographicHash::hash(uri, QCryptographicHash::Md5).toHex() +
+        ".png";
+}
+
+// One job per worker may wait in the queue; further requests are
+// refused until a job has finished.
+
+void ut_avthumbnailer::testQueue()
+{
+    AVThumbnailer thumbnailer;
+    QCOMPARE(thumbnailer.workerCount(), 1);
+
+    QSignalSpy generatedSpy(&thumbnailer,
+                            SIGNAL(thumbnailGenerated(const QString,
+                                                      const QString)));
+    QSignalSpy errorSpy(&thumbnailer,
+                        SIGNAL(thumbnailError(const QString, uint,
+                                              const QString)));
+    QSignalSpy finishedSpy(&thumbnailer, SIGNAL(requestFinished()));
+
+    thumbnailer.newThumbnailerTask(videoFile, "video/mp4", "cropped");
+    QVERIFY(thumbnailer.isRunning());
+    QVERIFY(thumbnailer.isPending(videoFile, "cropped"));
+    QVERIFY(!thumbnailer.isPending(videoFile, "large"));
+    QVERIFY(!thumbnailer.isFull());
+
+    thumbnailer.newThumbnailerTask("/invalid.mp4", "video/mp4", "cropped");
+    QVERIFY(thumbnailer.isPending("/invalid.mp4", "cropped"));
+    QVERIFY(thumbnailer.isFull());
+
+    thumbnailer.newThumbnailerTask("/invalid2.mp4", "video/mp4", "cropped");
+    QVERIFY(!thumbnailer.isPending("/invalid2.mp4", "cropped"));
+
+    QVERIFY(waitForSignals(&finishedSpy, 2));
+    QCOMPARE(generatedSpy.count(), 1);
+    QCOMPARE(generatedSpy.first().at(0).toString(), videoFile);
+    QCOMPARE(errorSpy.count(), 1);
+    QCOMPARE(errorSpy.first().at(0).toString(), QString("/invalid.mp4"));
+
+    QVERIFY(!thumbnailer.isRunning());
+    QVERIFY(!thumbnailer.isFull());
+    QVERIFY(!thumbnailer.isPending(videoFile, "cropped"));
+}
+
+// All flavors of a video are made in one job, each with its own size
+// and crop.
+
+void ut_avthumbnailer::testFlavors()
+{
+    AVThumbnailer thumbnailer;
+
+    QSignalSpy generatedSpy(&thumbnailer,
+                            SIGNAL(thumbnailGenerated(const QString,
+                                                      const QString)));
+    QSignalSpy finishedSpy(&thumbnailer, SIGNAL(requestFinished()));
+
+    thumbnailer.newThumbnailerTask(videoFile, "video/mp4",
+                                   QStringList() << "cropped" << "large");
+    QVERIFY(thumbnailer.isPending(videoFile, "cropped"));
+    QVERIFY(thumbnailer.isPending(videoFile, "large"));
+    QVERIFY(!thumbnailer.isFull());
+
+    QVERIFY(waitForSignals(&finishedSpy, 1));
+    QCOMPARE(generatedSpy.count(), 2);
+    QCOMPARE(generatedSpy.at(0).at(1).toString(), QString("cropped"));
+    QCOMPARE(generatedSpy.at(1).at(1).toString(), QString("large"));
+
+    QCOMPARE(QImage(thumbnailName("cropped", videoFile)).size(),
+             QSize(64, 64));
+    const QSize size = QImage(thumbnailName("large", videoFile)).size();
+    QVERIFY((size.width() == 128) || (size.height() == 128));
+    QVERIFY((size.width() <= 128) && (size.height() <= 128));
+}
+
+// Only flavors up to the display level of a file are made.
+
+void ut_avthumbnailer::testDisplayLevel()
+{
+    QuillFile *file = new QuillFile(videoFile, "video/mp4");
+    file->setDisplayLevel(0);
+
+    // The video cannot be loaded as an image
+    Quill::releaseAndWait();
+
+    for (int i=0; (i<1000) &&
+             !QFile::exists(thumbnailName("cropped", videoFile)); i++)
+        QTest::qWait(10);
+    QVERIFY(QFile::exists(thumbnailName("cropped", videoFile)));
+
+    // Let any other requests finish
+    QTest::qWait(500);
+    QVERIFY(!QFile::exists(thumbnailName("large", videoFile)));
+
+    delete file;
+}
+
+int main ( int argc, char *argv[] ){
+    QCoreApplication app( argc, argv );
+    ut_avthumbnailer test;
+    return QTest::qExec( &test, argc, argv );
+}
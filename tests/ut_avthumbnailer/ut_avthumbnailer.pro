@@ -0,0 +1,7 @@
+include(../tests.pri)
+
+TARGET = ../bin/ut_avthumbnailer
+
+# Input
+HEADERS += ut_avthumbnailer.h
+SOURCES += ut_avthumbnailer.cpp
@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <QDBusConnection>
+#include "mocktumbler.h"
+
+static const QString objectPath("/org/freedesktop/thumbnails/Thumbnailer1");
+
+MockTumbler::MockTumbler()
+{
+}
+
+MockTumbler::~MockTumbler()
+{
+    if (!m_service.isEmpty()) {
+        QDBusConnection::sessionBus().unregisterObject(objectPath);
+        QDBusConnection::sessionBus().unregisterService(m_service);
+    }
+}
+
+bool MockTumbler::registerService(const QString &service)
+{
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.registerService(service))
+        return false;
+    m_service = service;
+    return bus.registerObject(objectPath, this,
+                              QDBusConnection::ExportAllSlots |
+                              QDBusConnection::ExportAllSignals);
+}
+
+QList<QStringList> MockTumbler::queuedUris() const
+{
+    return m_queuedUris;
+}
+
+QStringList MockTumbler::queuedFlavors() const
+{
+    return m_queuedFlavors;
+}
+
+void MockTumbler::emitReady(uint handle, const QStringList &uris)
+{
+    emit Ready(handle, uris);
+}
+
+void MockTumbler::emitError(uint handle, const QStringList &failedUris,
+                            int errorCode, const QString &message)
+{
+    emit Error(handle, failedUris, errorCode, message);
+}
+
+void MockTumbler::emitFinished(uint handle)
+{
+    emit Finished(handle);
+}
+
+uint MockTumbler::Queue(const QStringList &uris,
+                        const QStringList &mime_types,
+                        const QString &flavor, const QString &scheduler,
+                        uint handle_to_unqueue)
+{
+    Q_UNUSED(mime_types);
+    Q_UNUSED(scheduler);
+    Q_UNUSED(handle_to_unqueue);
+
+    m_queuedUris.append(uris);
+    m_queuedFlavors.append(flavor);
+    return m_queuedUris.count();
+}
@@ -0,0 +1,95 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#ifndef TEST_LIBQUILL_MOCK_TUMBLER_H
+#define TEST_LIBQUILL_MOCK_TUMBLER_H
+
+#include <QObject>
+#include <QStringList>
+
+/*!
+  A stand-in for the Tumbler thumbnailing service, registered on the
+  session bus under a separate service name. Queued requests are only
+  recorded; the test decides when and how they finish.
+ */
+
+class MockTumbler : public QObject {
+Q_OBJECT
+Q_CLASSINFO("D-Bus Interface", "org.freedesktop.thumbnails.Thumbnailer1")
+
+public:
+    MockTumbler();
+    ~MockTumbler();
+
+    bool registerService(const QString &service);
+
+    /*!
+      The URIs of all requests so far; the handle of a request is its
+      index plus one.
+     */
+
+    QList<QStringList> queuedUris() const;
+
+    QStringList queuedFlavors() const;
+
+    void emitReady(uint handle, const QStringList &uris);
+
+    void emitError(uint handle, const QStringList &failedUris,
+                   int errorCode, const QString &message);
+
+    void emitFinished(uint handle);
+
+public slots:
+    uint Queue(const QStringList &uris, const QStringList &mime_types,
+               const QString &flavor, const QString &scheduler,
+               uint handle_to_unqueue);
+
+signals:
+    void Ready(uint handle, const QStringList &uris);
+    void Error(uint handle, const QStringList &failed_uris, int error_code,
+               const QString &message);
+    void Finished(uint handle);
+
+private:
+    QString m_service;
+    QList<QStringList> m_queuedUris;
+    QStringList m_queuedFlavors;
+};
+
+#endif  // TEST_LIBQUILL_MOCK_TUMBLER_H
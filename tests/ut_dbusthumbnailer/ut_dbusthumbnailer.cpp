@@ -43,6 +43,10 @@
 #include "thumbnailer_generic.h"
 #include "ut_dbusthumbnailer.h"
 #include "dbusthumbnailer.h"
+#include "mocktumbler.h"
+
+static const QString mockService("org.freedesktop.thumbnails.Thumbnailer1.QuillTest");
+static const QString videoFile("/usr/share/libquill-tests/video/Alvin_2.mp4");
 
 ut_dbusthumbnailer::ut_dbusthumbnailer()
 {
@@ -59,10 +63,21 @@ void ut_dbusthumbnailer::cleanupTestCase()
 
 void ut_dbusthumbnailer::init()
 {
+    m_tumbler = new MockTumbler;
+    QVERIFY(m_tumbler->registerService(mockService));
 }
 
 void ut_dbusthumbnailer::cleanup()
 {
+    delete m_tumbler;
+}
+
+bool ut_dbusthumbnailer::waitForRequests(DBusThumbnailer *thumbnailer,
+                                         int count)
+{
+    for (int i=0; (i<100) && (thumbnailer->m_requests.count() < count); i++)
+        QTest::qWait(10);
+    return thumbnailer->m_requests.count() == count;
 }
 
 void ut_dbusthumbnailer::testSupports()
@@ -83,35 +98,126 @@ void ut_dbusthumbnailer::testIsRunning()
 void ut_dbusthumbnailer::testSuccess()
 {
     DBusThumbnailer dbusThumbnailer;
+    dbusThumbnailer.setService(mockService);
     QSignalSpy spy(&dbusThumbnailer,SIGNAL(thumbnailGenerated(const QString,
                                                               const QString)));
+    QSignalSpy finishedSpy(&dbusThumbnailer, SIGNAL(requestFinished()));
 
-    dbusThumbnailer.newThumbnailerTask("/usr/share/libquill-tests/video/Alvin_2.mp4","video/mp4","normal");
+    dbusThumbnailer.newThumbnailerTask(videoFile,"video/mp4","normal");
+    QVERIFY(dbusThumbnailer.isRunning());
+    QVERIFY(waitForRequests(&dbusThumbnailer, 1));
+    QCOMPARE(m_tumbler->queuedFlavors(), QStringList() << "normal");
 
-    dbusThumbnailer.finishedHandler(2);
+    dbusThumbnailer.finishedHandler(1);
 
     QCOMPARE(spy.count(), 1);
     QList<QVariant> arguments = spy.first();
-    QCOMPARE(arguments.at(0).toString(),QString("/usr/share/libquill-tests/video/Alvin_2.mp4"));
+    QCOMPARE(arguments.at(0).toString(), videoFile);
     QCOMPARE(arguments.at(1).toString(),QString("normal"));
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(!dbusThumbnailer.isRunning());
 }
 
 void ut_dbusthumbnailer::testError()
 {
     DBusThumbnailer dbusThumbnailer;
+    dbusThumbnailer.setService(mockService);
     QSignalSpy spy(&dbusThumbnailer,SIGNAL(thumbnailError(const QString, uint,
                                                           const QString)));
-    dbusThumbnailer.newThumbnailerTask("invalid.mp4","invalid","normal");
+    QSignalSpy generatedSpy(&dbusThumbnailer,
+                            SIGNAL(thumbnailGenerated(const QString,
+                                                      const QString)));
+    dbusThumbnailer.newThumbnailerTask("/invalid.mp4","invalid","normal");
+    QVERIFY(waitForRequests(&dbusThumbnailer, 1));
 
-    QStringList error;
-    error << "invalid.mp4";
-    dbusThumbnailer.errorHandler(4,error,5,"this is an error");
+    dbusThumbnailer.errorHandler(1, m_tumbler->queuedUris().first(),
+                                 5, "this is an error");
 
     QCOMPARE(spy.count(), 1);
     QList<QVariant> arguments = spy.first();
-    QCOMPARE(arguments.at(0).toString(), QString("invalid.mp4"));
+    QCOMPARE(arguments.at(0).toString(), QString("/invalid.mp4"));
     QCOMPARE(arguments.at(1).toInt(), 5);
     QCOMPARE(arguments.at(2).toString(), QString("this is an error"));
+
+    // Errors are not reported again as successes
+    dbusThumbnailer.finishedHandler(1);
+    QCOMPARE(generatedSpy.count(), 0);
+    QVERIFY(!dbusThumbnailer.isRunning());
+}
+
+// Several files in one request, each reported separately over D-Bus
+
+void ut_dbusthumbnailer::testBatch()
+{
+    DBusThumbnailer dbusThumbnailer;
+    dbusThumbnailer.setService(mockService);
+    QSignalSpy generatedSpy(&dbusThumbnailer,
+                            SIGNAL(thumbnailGenerated(const QString,
+                                                      const QString)));
+    QSignalSpy errorSpy(&dbusThumbnailer,
+                        SIGNAL(thumbnailError(const QString, uint,
+                                              const QString)));
+    QSignalSpy finishedSpy(&dbusThumbnailer, SIGNAL(requestFinished()));
+
+    QStringList files;
+    files << "/a.mp4" << "/b.mp4" << "/c.mp4";
+    QStringList mimeTypes;
+    mimeTypes << "video/mp4" << "video/mp4" << "video/mp4";
+
+    dbusThumbnailer.newThumbnailerTask(files, mimeTypes, "large");
+    QVERIFY(waitForRequests(&dbusThumbnailer, 1));
+    QVERIFY(dbusThumbnailer.isPending("/b.mp4", "large"));
+    QVERIFY(!dbusThumbnailer.isPending("/b.mp4", "normal"));
+
+    QCOMPARE(m_tumbler->queuedUris().count(), 1);
+    const QStringList uris = m_tumbler->queuedUris().first();
+    QCOMPARE(uris.count(), 3);
+
+    m_tumbler->emitReady(1, QStringList() << uris[0] << uris[2]);
+    m_tumbler->emitError(1, QStringList() << uris[1], 2, "failed");
+    m_tumbler->emitFinished(1);
+
+    for (int i=0; (i<100) && (finishedSpy.count() < 1); i++)
+        QTest::qWait(10);
+
+    QCOMPARE(generatedSpy.count(), 2);
+    QCOMPARE(generatedSpy[0].at(0).toString(), QString("/a.mp4"));
+    QCOMPARE(generatedSpy[1].at(0).toString(), QString("/c.mp4"));
+    QCOMPARE(generatedSpy[1].at(1).toString(), QString("large"));
+    QCOMPARE(errorSpy.count(), 1);
+    QCOMPARE(errorSpy[0].at(0).toString(), QString("/b.mp4"));
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(!dbusThumbnailer.isPending("/b.mp4", "large"));
+    QVERIFY(!dbusThumbnailer.isRunning());
+}
+
+// Only a limited number of requests are outstanding at a time
+
+void ut_dbusthumbnailer::testWindow()
+{
+    DBusThumbnailer dbusThumbnailer;
+    dbusThumbnailer.setService(mockService);
+    dbusThumbnailer.setMaxRequests(2);
+    QCOMPARE(dbusThumbnailer.maxRequests(), 2);
+
+    dbusThumbnailer.newThumbnailerTask("/a.mp4", "video/mp4", "normal");
+    QVERIFY(!dbusThumbnailer.isFull());
+    dbusThumbnailer.newThumbnailerTask("/b.mp4", "video/mp4", "normal");
+    QVERIFY(dbusThumbnailer.isFull());
+    dbusThumbnailer.newThumbnailerTask("/c.mp4", "video/mp4", "normal");
+
+    QVERIFY(waitForRequests(&dbusThumbnailer, 2));
+    QCOMPARE(m_tumbler->queuedUris().count(), 2);
+    QVERIFY(!dbusThumbnailer.isPending("/c.mp4", "normal"));
+
+    dbusThumbnailer.finishedHandler(1);
+    QVERIFY(!dbusThumbnailer.isFull());
+    QVERIFY(dbusThumbnailer.isRunning());
+
+    dbusThumbnailer.newThumbnailerTask("/c.mp4", "video/mp4", "normal");
+    QVERIFY(dbusThumbnailer.isFull());
+    QVERIFY(waitForRequests(&dbusThumbnailer, 2));
+    QCOMPARE(m_tumbler->queuedUris().count(), 3);
 }
 
 int main ( int argc, char *argv[] ){
@@ -42,6 +42,8 @@
 
 #include <QObject>
 
+class DBusThumbnailer;
+class MockTumbler;
 
 class ut_dbusthumbnailer : public QObject {
 Q_OBJECT
@@ -58,6 +60,13 @@ private slots:
     void testIsRunning();
     void testSuccess();
     void testError();
+    void testBatch();
+    void testWindow();
+
+private:
+    bool waitForRequests(DBusThumbnailer *thumbnailer, int count);
+
+    MockTumbler *m_tumbler;
 };
 
 #endif  // TEST_LIBQUILL_DBUS_THUMBNAIL_H
@@ -4,6 +4,8 @@ TARGET = ../bin/ut_dbusthumbnailer
 QT += dbus
 # Input
 HEADERS += ut_dbusthumbnailer.h \
+           mocktumbler.h \
 
 SOURCES += ut_dbusthumbnailer.cpp \
+           mocktumbler.cpp \
 
@@ -528,6 +528,100 @@ void ut_file::testEdittingHistory()
     QVERIFY(!fileObject->hasOriginal());
 
 }
+
+void ut_file::testPreviewFilter()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    QuillImage image = Unittests::generatePaletteImage();
+    image.save(testFile.fileName(), "png");
+
+    Quill::setPreviewLevelCount(2);
+    Quill::setPreviewSize(0, QSize(4, 1));
+    Quill::setPreviewSize(1, QSize(8, 2));
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    file->setDisplayLevel(1);
+    Quill::releaseAndWait(); // level 0
+    Quill::releaseAndWait(); // level 1
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+    QuillImage processedImage = filter->apply(image);
+
+    file->previewFilter(filter);
+    QVERIFY(file->isPreviewingFilter());
+
+    // Only the highest preview level is calculated
+    Quill::releaseAndWait();
+    QVERIFY(!Quill::isCalculationInProgress());
+    QVERIFY(Unittests::compareImage(file->image(1), processedImage));
+    QVERIFY(file->image(0).isNull());
+
+    QuillImageFilter *filter2 =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter2->setOption(QuillImageFilter::Brightness, QVariant(40));
+    file->previewFilter(filter2);
+
+    QuillImageFilter *filter3 =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter3->setOption(QuillImageFilter::Brightness, QVariant(60));
+    processedImage = filter3->apply(image);
+    file->previewFilter(filter3);
+
+    Quill::releaseAndWait(); // superseded value, ignored
+    Quill::releaseAndWait();
+    QVERIFY(!Quill::isCalculationInProgress());
+    QVERIFY(Unittests::compareImage(file->image(1), processedImage));
+
+    // The other levels follow the commit
+    file->commitPreview();
+    QVERIFY(!file->isPreviewingFilter());
+    Quill::releaseAndWait();
+    QCOMPARE(file->image(0).size(), QSize(4, 1));
+
+    // The previews left only one edit behind
+    QVERIFY(file->canUndo());
+    file->undo();
+    QVERIFY(Unittests::compareImage(file->image(1), image));
+    QVERIFY(!file->canUndo());
+
+    delete file;
+}
+
+void ut_file::testCancelPreview()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    QuillImage image = Unittests::generatePaletteImage();
+    image.save(testFile.fileName(), "png");
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    file->setDisplayLevel(0);
+    Quill::releaseAndWait(); // load
+
+    QuillImage loadedImage = file->image();
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+
+    file->previewFilter(filter);
+    Quill::releaseAndWait();
+    QVERIFY(!Unittests::compareImage(file->image(), loadedImage));
+
+    file->cancelPreview();
+    QVERIFY(!file->isPreviewingFilter());
+    QVERIFY(Unittests::compareImage(file->image(), loadedImage));
+    QVERIFY(!file->canUndo());
+    QVERIFY(!file->canRedo());
+
+    delete file;
+}
+
 int main ( int argc, char *argv[] ){
     QCoreApplication app( argc, argv );
     ut_file test;
@@ -67,6 +67,8 @@ private slots:
     void testRevertRestore();
     void testDoubleRevertRestore();
     void testEdittingHistory();
+    void testPreviewFilter();
+    void testCancelPreview();
 };
 
 #endif  // TEST_LIBQUILL_FILE_H
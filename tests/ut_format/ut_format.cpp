@@ -39,6 +39,7 @@
 
 #include <QtTest/QtTest>
 #include <QFile>
+#include <QBuffer>
 #include <QImage>
 #include <QDebug>
 #include <QuillImageFilter>
@@ -173,6 +174,53 @@ void ut_format::testMultipleLimits()
     delete file;
 }
 
+// A jpeg header claiming 65000x65000 pixels, which overflows an int
+
+void ut_format::testGigapixelPixelsLimit()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    Unittests::generatePaletteImage().save(&buffer, "jpg");
+    buffer.close();
+
+    const int sof = data.indexOf("\xff\xc0");
+    QVERIFY(sof > 0);
+    data[sof + 5] = data[sof + 7] = (char)(65000 >> 8);
+    data[sof + 6] = data[sof + 8] = (char)(65000 & 0xff);
+    testFile.write(data);
+    testFile.flush();
+
+    const qint64 pixels = (qint64)65000 * 65000;
+
+    QSignalSpy spy(Quill::instance(), SIGNAL(error(QuillError)));
+
+    Quill::setImagePixelsLimit(pixels - 1);
+    QCOMPARE(Quill::imagePixelsLimit(), pixels - 1);
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::jpg);
+    file->setDisplayLevel(0);
+
+    QCOMPARE(spy.count(), 1);
+    QuillError error = spy.first().first().value<QuillError>();
+    QCOMPARE(error.errorCode(), QuillError::ImageSizeLimitError);
+    QVERIFY(!file->supportsViewing());
+    delete file;
+
+    Quill::setImagePixelsLimit(pixels);
+
+    QuillFile *file2 = new QuillFile(testFile.fileName(), Strings::jpg);
+    file2->setDisplayLevel(0);
+
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(file2->supportsViewing());
+    QCOMPARE(file2->fullImageSize(), QSize(65000, 65000));
+    delete file2;
+}
+
 void ut_format::testReadOnlyFormat()
 {
     QTemporaryFile testFile;
@@ -63,6 +63,7 @@ private slots:
     void testPixelsLimit();
     void testNonTiledPixelsLimit();
     void testMultipleLimits();
+    void testGigapixelPixelsLimit();
 
     void testReadOnlyFormat();
 };
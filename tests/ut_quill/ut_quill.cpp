@@ -42,14 +42,17 @@
 #include <QDebug>
 #include <QuillImageFilter>
 #include <QuillImageFilterFactory>
+#include <QuillImageFilterGenerator>
 #include <QSignalSpy>
 #include <unistd.h>
+#include <utime.h>
 
 #include "unittests.h"
 #include "ut_quill.h"
 #include "quillfile.h"
 #include "quillundocommand.h"
 #include "quillundostack.h"
+#include "scaledjpegload.h"
 #include "../../src/strings.h"
 #include "../../src/unix_platform.h"
 
@@ -776,6 +779,530 @@ void ut_quill::testSaveIndex()
     delete file2;
 }
 
+// Rotation and crop of a JPEG file with whole MCUs should be saved
+// without loading the full image.
+
+void ut_quill::testLosslessSave()
+{
+    QFile originalFile("/usr/share/libquill-tests/images/redeye01.JPG");
+    QVERIFY(originalFile.open(QIODevice::ReadOnly));
+
+    QTemporaryFile testFile("/tmp/XXXXXX.jpg");
+    testFile.open();
+    testFile.write(originalFile.readAll());
+    testFile.flush();
+
+    Quill::setLosslessSaveEnabled(true);
+    QVERIFY(Quill::isLosslessSaveEnabled());
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::jpeg);
+    file->setDisplayLevel(0);
+    Quill::releaseAndWait();
+
+    QuillImageFilter *rotateFilter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_Rotate);
+    rotateFilter->setOption(QuillImageFilter::Angle, QVariant(90));
+    file->runFilter(rotateFilter);
+    Quill::releaseAndWait();
+
+    QuillImageFilter *cropFilter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_Crop);
+    cropFilter->setOption(QuillImageFilter::CropRectangle,
+                          QVariant(QRect(16, 32, 160, 100)));
+    file->runFilter(cropFilter);
+    Quill::releaseAndWait();
+    Quill::releaseAndWait();
+
+    QCOMPARE(file->fullImageSize(), QSize(160, 100));
+
+    file->save();
+    QVERIFY(Quill::isSaveInProgress());
+
+    // One step only, the full image is never loaded
+    Quill::releaseAndWait();
+    QVERIFY(!Quill::isSaveInProgress());
+
+    QImage targetImage = QImage(originalFile.fileName()).
+        transformed(QTransform().rotate(90)).copy(16, 32, 160, 100);
+    QImage savedImage(testFile.fileName());
+
+    QCOMPARE(savedImage.size(), targetImage.size());
+    QVERIFY(Unittests::getPSNR(savedImage, targetImage) > 30);
+
+    delete file;
+}
+
+// Preview levels of a JPEG file should be decoded at a reduced scale
+// with the same result as scaling the full image.
+
+void ut_quill::testScaledJpegLoading()
+{
+    QString fileName("/usr/share/libquill-tests/images/redeye01.JPG");
+
+    Quill::setScaledJpegLoadingEnabled(true);
+    QVERIFY(Quill::isScaledJpegLoadingEnabled());
+    Quill::setPreviewSize(0, QSize(64, 48));
+
+    QuillFile *file = new QuillFile(fileName, Strings::jpeg);
+    file->setDisplayLevel(0);
+    Quill::releaseAndWait();
+
+    QImage targetImage = QImage(fileName).scaled(QSize(64, 48),
+                                                 Qt::IgnoreAspectRatio,
+                                                 Qt::SmoothTransformation);
+
+    QCOMPARE(file->image().size(), QSize(64, 48));
+    QVERIFY(Unittests::getPSNR(file->image().convertToFormat(QImage::Format_RGB32),
+                               targetImage.convertToFormat(QImage::Format_RGB32)) > 25);
+
+    // The preview came from the reduced-scale decode, not the filter
+    QuillImage level;
+    level.setFullImageSize(file->image().fullImageSize());
+    level.setTargetSize(file->image().targetSize());
+    level.setArea(file->image().area());
+
+    const int denominator =
+        ScaledJpegLoad::scaleDenominator(level.area(), level.targetSize());
+    QVERIFY(denominator > 1);
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Role_Load);
+    filter->setOption(QuillImageFilter::FileName, QVariant(fileName));
+
+    ScaledJpegLoad scaledLoad(filter, denominator);
+    QVERIFY(Unittests::compareImage(file->image(), scaledLoad.apply(level)));
+    QVERIFY(file->image().convertToFormat(QImage::Format_RGB32) !=
+            filter->apply(level).convertToFormat(QImage::Format_RGB32));
+
+    delete filter;
+    delete file;
+}
+
+void ut_quill::testExifPreview()
+{
+    QString fileName("/usr/share/libquill-tests/images/redeye.jpg");
+
+    Quill::setExifPreviewEnabled(true);
+    QVERIFY(Quill::isExifPreviewEnabled());
+    Quill::setPreviewSize(0, QSize(98, 82));
+
+    QuillFile *file = new QuillFile(fileName, Strings::jpeg);
+    QSignalSpy spy(file, SIGNAL(imageAvailable(const QuillImageList)));
+    file->setDisplayLevel(0);
+
+    // Provisional preview from the embedded thumbnail, not stored
+    Quill::releaseAndWait();
+    QCOMPARE(spy.count(), 1);
+    QuillImage preview = spy.first().first().value<QuillImageList>().first();
+    QCOMPARE(preview.size(), QSize(98, 82));
+    QCOMPARE(preview.z(), 0);
+    QVERIFY(file->image().isNull());
+
+    // Real preview
+    Quill::releaseAndWait();
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(file->image().size(), QSize(98, 82));
+
+    QImage targetImage = QImage(fileName).scaled(QSize(98, 82),
+                                                 Qt::IgnoreAspectRatio,
+                                                 Qt::SmoothTransformation);
+    QVERIFY(Unittests::getPSNR(preview.convertToFormat(QImage::Format_RGB32),
+                               targetImage.convertToFormat(QImage::Format_RGB32)) > 20);
+
+    delete file;
+}
+
+void ut_quill::testPyramidLoading()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    QImage image = Unittests::generatePaletteImage().scaled(QSize(64, 32));
+    image.save(testFile.fileName(), "png");
+
+    Quill::setPyramidLoadingEnabled(true);
+    QVERIFY(Quill::isPyramidLoadingEnabled());
+    Quill::setPreviewLevelCount(3);
+    Quill::setPreviewSize(0, QSize(8, 8));
+    Quill::setMinimumPreviewSize(0, QSize(8, 8));
+    Quill::setPreviewSize(1, QSize(16, 16));
+    Quill::setPreviewSize(2, QSize(32, 32));
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    QSignalSpy spy(file, SIGNAL(imageAvailable(const QuillImageList)));
+    file->setDisplayLevel(2);
+
+    // All levels from one task, sent together
+    Quill::releaseAndWait();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().first().value<QuillImageList>().count(), 3);
+
+    QCOMPARE(file->image(0).size(), QSize(8, 8));
+    QCOMPARE(file->image(1).size(), QSize(16, 8));
+    QCOMPARE(file->image(2).size(), QSize(32, 16));
+
+    QImage targetImage = image.scaled(QSize(16, 8), Qt::IgnoreAspectRatio,
+                                      Qt::SmoothTransformation);
+    QVERIFY(Unittests::getPSNR(file->image(1).convertToFormat(QImage::Format_RGB32),
+                               targetImage.convertToFormat(QImage::Format_RGB32)) > 25);
+
+    // Nothing left to load
+    Quill::releaseAndWait();
+    QCOMPARE(spy.count(), 1);
+
+    delete file;
+}
+
+void ut_quill::testResultCache()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+    QTemporaryFile testFile2;
+    testFile2.open();
+
+    QImage image = Unittests::generatePaletteImage();
+    image.save(testFile.fileName(), "png");
+    image.save(testFile2.fileName(), "png");
+
+    Quill::setResultCacheSize(1000);
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    file->setDisplayLevel(0);
+    Quill::releaseAndWait(); // load
+    const QuillImage loadedImage = file->image();
+
+    file->runFilter(filter);
+    Quill::releaseAndWait(); // filter
+    const QuillImage filteredImage = file->image();
+
+    // Same contents under another name: no calculation needed
+    QuillFile *file2 = new QuillFile(testFile2.fileName(), Strings::png);
+    QSignalSpy spy(file2, SIGNAL(imageAvailable(const QuillImageList)));
+    file2->setDisplayLevel(0);
+
+    QVERIFY(!Quill::isCalculationInProgress());
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(Unittests::compareImage(file2->image(), loadedImage));
+    QCOMPARE(file2->image().fullImageSize(), QSize(8, 2));
+
+    QuillImageFilter *filter2 =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter2->setOption(QuillImageFilter::Brightness, QVariant(20));
+    file2->runFilter(filter2);
+
+    QVERIFY(!Quill::isCalculationInProgress());
+    QCOMPARE(spy.count(), 2);
+    QVERIFY(Unittests::compareImage(file2->image(), filteredImage));
+
+    // Different options are calculated
+    QuillImageFilter *filter3 =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter3->setOption(QuillImageFilter::Brightness, QVariant(-20));
+    file2->runFilter(filter3);
+
+    QVERIFY(Quill::isCalculationInProgress());
+    Quill::releaseAndWait();
+    QCOMPARE(spy.count(), 3);
+
+    delete file2;
+    delete file;
+}
+
+void ut_quill::testResultCacheDirectory()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    QImage image = Unittests::generatePaletteImage().scaled(QSize(64, 32));
+    image.save(testFile.fileName(), "png");
+
+    QDir dir(TEMP_PATH + QDir::separator() + "resultcache");
+    QVERIFY(QDir().mkpath(dir.path()));
+    foreach (const QString &entry, dir.entryList(QDir::Files))
+        dir.remove(entry);
+
+    Quill::setResultCacheDirectory(dir.path());
+    Quill::setPyramidLoadingEnabled(true);
+    Quill::setPreviewLevelCount(3);
+    Quill::setPreviewSize(0, QSize(8, 8));
+    Quill::setMinimumPreviewSize(0, QSize(8, 8));
+    Quill::setPreviewSize(1, QSize(16, 16));
+    Quill::setPreviewSize(2, QSize(32, 32));
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    file->setDisplayLevel(2);
+    Quill::releaseAndWait(); // load
+
+    // Images are stored in the background
+    QCOMPARE(dir.entryList(QDir::Files).count(), 0);
+    while (Quill::isCalculationInProgress())
+        Quill::releaseAndWait();
+
+    // The lower levels from the same decode are stored as well
+    QCOMPARE(dir.entryList(QDir::Files).count(), 3);
+    delete file;
+
+    // Replace the stored level 2 to see that it is used
+    QImage marker(QSize(32, 16), QImage::Format_RGB32);
+    marker.fill(qRgb(255, 0, 0));
+    foreach (const QString &entry, dir.entryList(QDir::Files))
+        if (QImage(dir.filePath(entry)).size() == marker.size())
+            QVERIFY(marker.save(dir.filePath(entry), "png"));
+
+    file = new QuillFile(testFile.fileName(), Strings::png);
+    file->setDisplayLevel(2);
+    while (Quill::isCalculationInProgress())
+        Quill::releaseAndWait();
+    QVERIFY(Unittests::compareImage(file->image(2), marker));
+    QCOMPARE(file->image(2).fullImageSize(), QSize(64, 32));
+    delete file;
+
+    // The file may have been changed in place without changing its key
+    struct utimbuf times;
+    times.actime = QDateTime::currentDateTime().addSecs(-3600).toTime_t();
+    times.modtime = times.actime;
+    QCOMPARE(utime(QFile::encodeName(testFile.fileName()).constData(),
+                   &times), 0);
+
+    file = new QuillFile(testFile.fileName(), Strings::png);
+    file->setDisplayLevel(2);
+    QVERIFY(Quill::isCalculationInProgress());
+    Quill::releaseAndWait();
+    QCOMPARE(dir.entryList(QDir::Files).count(), 6);
+    delete file;
+}
+
+void ut_quill::testProcessBatch()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+    QTemporaryFile testFile2;
+    testFile2.open();
+
+    QImage image = Unittests::generatePaletteImage();
+    image.save(testFile.fileName(), "png");
+    image.save(testFile2.fileName(), "png");
+
+    const QString targetPath = TEMP_PATH + QDir::separator() + "batch";
+    QVERIFY(QDir().mkpath(targetPath));
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+    QImage targetImage = filter->apply(image);
+
+    QSignalSpy savedSpy(Quill::instance(), SIGNAL(batchFileSaved(QString)));
+    QSignalSpy finishedSpy(Quill::instance(), SIGNAL(batchFinished()));
+    QSignalSpy errorSpy(Quill::instance(), SIGNAL(error(QuillError)));
+
+    Quill::processBatch(QStringList() << testFile.fileName()
+                        << "/invalid/file.png" << testFile2.fileName(),
+                        QList<QuillImageFilter*>() << filter, targetPath);
+
+    // One task per file
+    Quill::releaseAndWait();
+    QCOMPARE(savedSpy.count(), 1);
+    Quill::releaseAndWait();
+    QCOMPARE(errorSpy.count(), 1);
+    QCOMPARE(errorSpy.first().first().value<QuillError>().errorData(),
+             QString("/invalid/file.png"));
+    QCOMPARE(finishedSpy.count(), 0);
+    Quill::releaseAndWait();
+    QCOMPARE(savedSpy.count(), 2);
+    QCOMPARE(finishedSpy.count(), 1);
+
+    foreach (const QString &fileName,
+             QStringList() << testFile.fileName() << testFile2.fileName()) {
+        const QString targetName = targetPath + QDir::separator()
+            + QFileInfo(fileName).fileName();
+        QVERIFY(Unittests::compareImage(QImage(targetName), targetImage));
+        // Source is left untouched
+        QVERIFY(Unittests::compareImage(QImage(fileName), image));
+        QFile::remove(targetName);
+    }
+
+    QDir().rmdir(targetPath);
+}
+
+// Without a target directory, the files are replaced with the results.
+
+void ut_quill::testProcessBatchInPlace()
+{
+    const QString path = TEMP_PATH + QDir::separator() + "batch_inplace";
+    QVERIFY(QDir().mkpath(path));
+    const QString fileName = path + QDir::separator() + "image.png";
+
+    QImage image = Unittests::generatePaletteImage();
+    image.save(fileName, "png");
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+    QImage targetImage = filter->apply(image);
+
+    QSignalSpy savedSpy(Quill::instance(), SIGNAL(batchFileSaved(QString)));
+
+    Quill::processBatch(QStringList() << fileName,
+                        QList<QuillImageFilter*>() << filter, QString());
+    Quill::releaseAndWait();
+
+    QCOMPARE(savedSpy.count(), 1);
+    QCOMPARE(savedSpy.first().first().toString(), fileName);
+    QVERIFY(Unittests::compareImage(QImage(fileName), targetImage));
+
+    // No temporary files are left behind
+    QCOMPARE(QDir(path).entryList(QDir::Files), QStringList() << "image.png");
+
+    QFile::remove(fileName);
+    QDir().rmdir(path);
+}
+
+// Filter generators edit with the filter they result in.
+
+void ut_quill::testProcessBatchGenerator()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    QImage image = Unittests::generatePaletteImage();
+    image.save(testFile.fileName(), "png");
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter->setOption(QuillImageFilter::Contrast, -50);
+
+    QuillImageFilter *filterGenerator =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_AutoContrast);
+    QVERIFY(dynamic_cast<QuillImageFilterGenerator*>(filterGenerator));
+
+    Quill::processBatch(QStringList() << testFile.fileName(),
+                        QList<QuillImageFilter*>() << filter << filterGenerator,
+                        QString());
+    Quill::releaseAndWait();
+
+    // The original contrast is restored, with an offset of +-1
+    QImage result(testFile.fileName());
+    QCOMPARE(result.size(), image.size());
+    for (int p=0; p<16; p++) {
+        int rgb = result.pixel(p%8, p/8);
+        int rgb2 = image.pixel(p%8, p/8);
+
+        QVERIFY(abs(qRed(rgb)-qRed(rgb2)) <= 1);
+        QVERIFY(abs(qGreen(rgb)-qGreen(rgb2)) <= 1);
+        QVERIFY(abs(qBlue(rgb)-qBlue(rgb2)) <= 1);
+    }
+}
+
+// Files over the image size limits are not loaded.
+
+void ut_quill::testProcessBatchSizeLimit()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    QImage image = Unittests::generatePaletteImage();
+    image.save(testFile.fileName(), "png");
+
+    Quill::setImagePixelsLimit(15);
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+
+    QSignalSpy savedSpy(Quill::instance(), SIGNAL(batchFileSaved(QString)));
+    QSignalSpy errorSpy(Quill::instance(), SIGNAL(error(QuillError)));
+
+    Quill::processBatch(QStringList() << testFile.fileName(),
+                        QList<QuillImageFilter*>() << filter, QString());
+    Quill::releaseAndWait();
+
+    QCOMPARE(savedSpy.count(), 0);
+    QCOMPARE(errorSpy.count(), 1);
+    QCOMPARE(errorSpy.first().first().value<QuillError>().errorCode(),
+             QuillError::ImageSizeLimitError);
+    QVERIFY(Unittests::compareImage(QImage(testFile.fileName()), image));
+}
+
+// An empty batch finishes immediately.
+
+void ut_quill::testProcessBatchEmpty()
+{
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+
+    QSignalSpy finishedSpy(Quill::instance(), SIGNAL(batchFinished()));
+
+    Quill::processBatch(QStringList(), QList<QuillImageFilter*>() << filter,
+                        QString());
+
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(!Quill::isCalculationInProgress());
+}
+
+// Files with the same name do not overwrite each other in the target
+// directory.
+
+void ut_quill::testProcessBatchSameName()
+{
+    const QString sourcePath = TEMP_PATH + QDir::separator() + "batch_source";
+    const QString sourcePath2 = TEMP_PATH + QDir::separator() + "batch_source2";
+    const QString targetPath = TEMP_PATH + QDir::separator() + "batch";
+    QVERIFY(QDir().mkpath(sourcePath));
+    QVERIFY(QDir().mkpath(sourcePath2));
+    QVERIFY(QDir().mkpath(targetPath));
+
+    const QString fileName = sourcePath + QDir::separator() + "image.png";
+    const QString fileName2 = sourcePath2 + QDir::separator() + "image.png";
+    const QString targetName = targetPath + QDir::separator() + "image.png";
+
+    QImage image = Unittests::generatePaletteImage();
+    image.save(fileName, "png");
+    image.transformed(QTransform().rotate(180)).save(fileName2, "png");
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+    QImage targetImage = filter->apply(image);
+
+    QSignalSpy savedSpy(Quill::instance(), SIGNAL(batchFileSaved(QString)));
+    QSignalSpy finishedSpy(Quill::instance(), SIGNAL(batchFinished()));
+    QSignalSpy errorSpy(Quill::instance(), SIGNAL(error(QuillError)));
+
+    Quill::processBatch(QStringList() << fileName << fileName2,
+                        QList<QuillImageFilter*>() << filter, targetPath);
+
+    // The second file is rejected right away
+    QCOMPARE(errorSpy.count(), 1);
+    QCOMPARE(errorSpy.first().first().value<QuillError>().errorData(),
+             fileName2);
+
+    Quill::releaseAndWait();
+    QCOMPARE(savedSpy.count(), 1);
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(Unittests::compareImage(QImage(targetName), targetImage));
+
+    QFile::remove(fileName);
+    QFile::remove(fileName2);
+    QFile::remove(targetName);
+    QDir().rmdir(sourcePath);
+    QDir().rmdir(sourcePath2);
+    QDir().rmdir(targetPath);
+}
+
+void ut_quill::testVideoThumbnailerThreadCount()
+{
+    QCOMPARE(Quill::videoThumbnailerThreadCount(), 1);
+    Quill::setVideoThumbnailerThreadCount(3);
+    QCOMPARE(Quill::videoThumbnailerThreadCount(), 3);
+    // At least one worker is always kept
+    Quill::setVideoThumbnailerThreadCount(0);
+    QCOMPARE(Quill::videoThumbnailerThreadCount(), 1);
+}
+
 // Test that background priority works for saving
 void ut_quill::testBackgroundPriority()
 {
@@ -874,6 +1401,55 @@ void ut_quill::testBackgroundPriority()
     delete file2;
 }
 
+void ut_quill::testPrefetchHint()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+    QTemporaryFile testFile2;
+    testFile2.open();
+
+    QImage image = Unittests::generatePaletteImage();
+    image.save(testFile.fileName(), "png");
+    image.save(testFile2.fileName(), "png");
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    QSignalSpy spy(file, SIGNAL(imageAvailable(const QuillImageList)));
+    file->setDisplayLevel(0);
+
+    Quill::setPrefetchHint(QStringList() << testFile2.fileName());
+
+    // The file opened by the application comes first
+    Quill::releaseAndWait();
+
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(!file->image(0).isNull());
+
+    // Prefetch
+    Quill::releaseAndWait();
+
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    QuillFile *file2 = new QuillFile(testFile2.fileName(), Strings::png);
+    QCOMPARE(file2->image(0).size(), QSize(4, 1));
+
+    // Releasing the hint keeps the images of the application's file
+    file2->setDisplayLevel(0);
+    Quill::setPrefetchHint(QStringList());
+    QVERIFY(!file2->image(0).isNull());
+
+    delete file2;
+
+    // Releasing the hint frees prefetched images
+    Quill::setPrefetchHint(QStringList() << testFile2.fileName());
+    Quill::releaseAndWait();
+    Quill::setPrefetchHint(QStringList());
+    file2 = new QuillFile(testFile2.fileName(), Strings::png);
+    QVERIFY(file2->image(0).isNull());
+
+    delete file;
+    delete file2;
+}
+
 // Ensure that the small picture in saved edit history case is coming
 // from the correct version (up-to-date, instead of the original, if
 // available).
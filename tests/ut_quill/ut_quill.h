@@ -68,8 +68,22 @@ private slots:
     void testMultiSave();
     void testNoSave();
     void testSaveIndex();
+    void testLosslessSave();
+    void testScaledJpegLoading();
+    void testExifPreview();
+    void testPyramidLoading();
+    void testResultCache();
+    void testResultCacheDirectory();
+    void testProcessBatch();
+    void testProcessBatchInPlace();
+    void testProcessBatchGenerator();
+    void testProcessBatchSizeLimit();
+    void testProcessBatchEmpty();
+    void testProcessBatchSameName();
+    void testVideoThumbnailerThreadCount();
 
     void testBackgroundPriority();
+    void testPrefetchHint();
 
     void testLoadSaveSmallPicture();
 
@@ -48,6 +48,7 @@
 #include "unittests.h"
 #include "../../src/strings.h"
 #include "../../src/regionsofinterest.h"
+#include "../../src/localfilterapply.h"
 
 ut_regions::ut_regions()
 {
@@ -243,6 +244,81 @@ void ut_regions::testUndo()
     QVERIFY(!resultMetadata.entry(QuillMetadata::Tag_Regions).canConvert<QuillMetadataRegionList>());
 }
 
+void ut_regions::testAffectedArea()
+{
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_RedEyeDetection);
+    filter->setOption(QuillImageFilter::Center, QVariant(QPoint(10, 20)));
+    filter->setOption(QuillImageFilter::Radius, QVariant(5));
+
+    QCOMPARE(RegionsOfInterest::affectedArea(filter, QSize(100, 100)),
+             QRect(5, 15, 11, 11));
+
+    // Clipped to the image
+    filter->setOption(QuillImageFilter::Center, QVariant(QPoint(2, 2)));
+    QCOMPARE(RegionsOfInterest::affectedArea(filter, QSize(100, 100)),
+             QRect(0, 0, 8, 8));
+
+    // Covering the whole image
+    QCOMPARE(RegionsOfInterest::affectedArea(filter, QSize(4, 4)), QRect());
+
+    // Only filters declared local have an area
+    Quill::setLocalFilter(QuillImageFilter::Name_RedEyeDetection, false);
+    QCOMPARE(RegionsOfInterest::affectedArea(filter, QSize(100, 100)), QRect());
+
+    Quill::setLocalFilter(QuillImageFilter::Name_RedEyeDetection, true);
+    QCOMPARE(RegionsOfInterest::affectedArea(filter, QSize(100, 100)),
+             QRect(0, 0, 8, 8));
+
+    delete filter;
+
+    // Filters without an area change everything
+    filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+
+    QCOMPARE(RegionsOfInterest::affectedArea(filter, QSize(100, 100)), QRect());
+
+    delete filter;
+}
+
+void ut_regions::testLocalFilterApply()
+{
+    QuillImage image = Unittests::generatePaletteImage();
+    image.setFullImageSize(QSize(8, 2));
+    image.setArea(QRect(0, 0, 8, 2));
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+
+    QuillImage reference = filter->apply(image);
+
+    LocalFilterApply operation(filter, QRect(2, 0, 2, 2));
+    QuillImage result = operation.apply(image);
+
+    QCOMPARE(result.size(), image.size());
+    QCOMPARE(result.fullImageSize(), QSize(8, 2));
+    QCOMPARE(result.area(), QRect(0, 0, 8, 2));
+
+    // Only the affected area is filtered
+    QVERIFY(Unittests::compareImage(result.copy(2, 0, 2, 2),
+                                    reference.copy(2, 0, 2, 2)));
+    QVERIFY(Unittests::compareImage(result.copy(0, 0, 2, 2),
+                                    image.copy(0, 0, 2, 2)));
+    QVERIFY(Unittests::compareImage(result.copy(4, 0, 4, 2),
+                                    image.copy(4, 0, 4, 2)));
+
+    // A tile outside the area is passed through
+    QuillImage tile(image.copy(4, 0, 4, 2));
+    tile.setFullImageSize(QSize(8, 2));
+    tile.setArea(QRect(4, 0, 4, 2));
+
+    QVERIFY(Unittests::compareImage(operation.apply(tile), tile));
+
+    delete filter;
+}
+
 int main ( int argc, char *argv[] ){
     QCoreApplication app( argc, argv );
     ut_regions test;
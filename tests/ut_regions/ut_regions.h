@@ -64,6 +64,12 @@ private slots:
     void testCropImage();
 
     void testUndo();
+
+    // Local filters
+
+    void testAffectedArea();
+
+    void testLocalFilterApply();
 };
 
 #endif  // TEST_QUILL_METADATA_H
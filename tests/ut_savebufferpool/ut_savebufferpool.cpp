@@ -0,0 +1,174 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <QDebug>
+#include <QtTest/QtTest>
+#include <QImage>
+
+#include "tilemap.h"
+#include "tilecache.h"
+#include "savebufferpool.h"
+#include "savemap.h"
+#include "ut_savebufferpool.h"
+
+ut_savebufferpool::ut_savebufferpool()
+{
+}
+
+void ut_savebufferpool::initTestCase()
+{
+}
+
+void ut_savebufferpool::cleanupTestCase()
+{
+}
+
+// A released buffer is handed out again for the same size and format only.
+
+void ut_savebufferpool::testReuse()
+{
+    SaveBufferPool pool(1024*1024);
+
+    QImage image = pool.acquire(QSize(16, 16), QImage::Format_RGB32);
+    QCOMPARE(image.size(), QSize(16, 16));
+    QCOMPARE(image.format(), QImage::Format_RGB32);
+    QCOMPARE(pool.missCount(), 1);
+
+    const uchar *bits = image.constBits();
+    pool.release(image);
+    image = QImage();
+    QCOMPARE(pool.bytes(), (qint64)16*16*4);
+
+    QImage image2 = pool.acquire(QSize(16, 8), QImage::Format_RGB32);
+    QCOMPARE(pool.missCount(), 2);
+    QCOMPARE(pool.hitCount(), 0);
+
+    QImage image3 = pool.acquire(QSize(16, 16), QImage::Format_ARGB32);
+    QCOMPARE(pool.missCount(), 3);
+
+    QImage image4 = pool.acquire(QSize(16, 16), QImage::Format_RGB32);
+    QCOMPARE(pool.hitCount(), 1);
+    QVERIFY(image4.constBits() == bits);
+    QCOMPARE(pool.bytes(), (qint64)0);
+}
+
+// A buffer still in use elsewhere is not handed out.
+
+void ut_savebufferpool::testSharedBuffer()
+{
+    SaveBufferPool pool(1024*1024);
+
+    QImage image = pool.acquire(QSize(16, 16), QImage::Format_RGB32);
+    pool.release(image);
+
+    QImage image2 = pool.acquire(QSize(16, 16), QImage::Format_RGB32);
+    QCOMPARE(pool.hitCount(), 0);
+    QVERIFY(image2.constBits() != image.constBits());
+
+    image = QImage();
+    QImage image3 = pool.acquire(QSize(16, 16), QImage::Format_RGB32);
+    QCOMPARE(pool.hitCount(), 1);
+}
+
+// The pool never keeps more than its limit, and frees the oldest first.
+
+void ut_savebufferpool::testLimit()
+{
+    SaveBufferPool pool(16*16*4*2);
+
+    QImage image1 = pool.acquire(QSize(16, 16), QImage::Format_RGB32);
+    QImage image2 = pool.acquire(QSize(16, 16), QImage::Format_RGB32);
+    QImage image3 = pool.acquire(QSize(16, 16), QImage::Format_RGB32);
+    const uchar *bits3 = image3.constBits();
+
+    pool.release(image1);
+    pool.release(image2);
+    pool.release(image3);
+    image1 = QImage();
+    image2 = QImage();
+    image3 = QImage();
+    QCOMPARE(pool.bytes(), (qint64)16*16*4*2);
+
+    pool.setMaxBytes(16*16*4);
+    QCOMPARE(pool.bytes(), (qint64)16*16*4);
+
+    QImage image = pool.acquire(QSize(16, 16), QImage::Format_RGB32);
+    QVERIFY(image.constBits() == bits3);
+
+    pool.release(image);
+    pool.clear();
+    QCOMPARE(pool.bytes(), (qint64)0);
+
+    pool.setMaxBytes(0);
+    pool.release(image);
+    QCOMPARE(pool.bytes(), (qint64)0);
+}
+
+// Save buffers are recycled through the pool.
+
+void ut_savebufferpool::testSaveMap()
+{
+    SaveBufferPool pool(1024*1024);
+    TileCache cache;
+    TileMap tileMap(QSize(1, 1), QSize(1, 1), &cache);
+    SaveMap map(QSize(2, 7), 4, &tileMap, &pool);
+
+    QCOMPARE(map.buffer().area(), QRect(0, 0, 2, 2));
+    QCOMPARE(map.buffer().size(), QSize(2, 2));
+    QCOMPARE(pool.missCount(), 1);
+
+    map.nextBuffer();
+    QCOMPARE(map.buffer().area(), QRect(0, 2, 2, 2));
+    QCOMPARE(map.buffer().size(), QSize(2, 2));
+    QCOMPARE(pool.hitCount(), 1);
+
+    map.nextBuffer();
+    QCOMPARE(pool.hitCount(), 2);
+
+    map.nextBuffer();
+    QCOMPARE(map.buffer().area(), QRect(0, 6, 2, 1));
+    QCOMPARE(map.buffer().size(), QSize(2, 1));
+    QCOMPARE(pool.missCount(), 2);
+}
+
+int main ( int argc, char *argv[] ){
+    QCoreApplication app( argc, argv );
+    ut_savebufferpool test;
+    return QTest::qExec( &test, argc, argv );
+}
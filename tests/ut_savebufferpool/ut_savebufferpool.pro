@@ -0,0 +1,7 @@
+include(../tests.pri)
+
+TARGET = ../bin/ut_savebufferpool
+
+# Input
+HEADERS += ut_savebufferpool.h
+SOURCES += ut_savebufferpool.cpp
@@ -83,6 +83,70 @@ void ut_savemap::testBufferArea()
     QVERIFY(map.isSaveComplete());
 }
 
+// Test copying tiles into the buffer.
+
+void ut_savemap::testAddToBuffer()
+{
+    QImage image = Unittests::generatePaletteImage();
+
+    TileCache cache;
+    TileMap tileMap(QSize(8, 2), QSize(4, 2), &cache);
+    SaveMap map(QSize(8, 2), 16, &tileMap);
+
+    QCOMPARE(map.bufferCount(), 1);
+    QVERIFY(!map.isBufferComplete());
+
+    QList<int> tiles = tileMap.findArea(QRect(0, 0, 8, 2));
+    QCOMPARE(tiles.count(), 2);
+
+    foreach (int index, tiles) {
+        QuillImage tile = tileMap.tile(index);
+        tile = QuillImage(tile, image.copy(tile.area()));
+        QVERIFY(map.addToBuffer(index, tile));
+        // Only once
+        QVERIFY(!map.addToBuffer(index, tile));
+    }
+
+    QVERIFY(map.isBufferComplete());
+    QCOMPARE(map.buffer().area(), QRect(0, 0, 8, 2));
+    QCOMPARE(map.buffer().fullImageSize(), QSize(8, 2));
+    QVERIFY(Unittests::compareImage(map.buffer(), image));
+}
+
+// Test the buffer and tile layout of a 5 gigapixel image, with tiles
+// which only contain a corner. The image itself is never processed.
+
+void ut_savemap::testGigapixelLayout()
+{
+    const QSize fullImageSize(100000, 50000);
+
+    TileCache cache;
+    TileMap tileMap(fullImageSize, QSize(25000, 25000), &cache);
+    SaveMap map(fullImageSize, 400000, &tileMap);
+
+    QCOMPARE(map.bufferCount(), 12500);
+    QCOMPARE(map.buffer().area(), QRect(0, 0, 100000, 4));
+
+    QList<int> tiles = tileMap.findArea(map.buffer().area());
+    QCOMPARE(tiles.count(), 4);
+
+    QImage image = Unittests::generatePaletteImage();
+    foreach (int index, tiles) {
+        QuillImage tile = tileMap.tile(index);
+        tile = QuillImage(tile, image);
+        QVERIFY(map.addToBuffer(index, tile));
+    }
+
+    QVERIFY(map.isBufferComplete());
+    QVERIFY(Unittests::compareImage(map.buffer().copy(0, 0, 8, 2), image));
+    QVERIFY(Unittests::compareImage(map.buffer().copy(75000, 0, 8, 2), image));
+
+    // A buffer size over 32 bits is limited to the image
+    SaveMap bigBufferMap(QSize(100000, 1), (qint64)3 << 30, &tileMap);
+    QCOMPARE(bigBufferMap.bufferCount(), 1);
+    QCOMPARE(bigBufferMap.buffer().area(), QRect(0, 0, 100000, 1));
+}
+
 int main ( int argc, char *argv[] ){
     QCoreApplication app( argc, argv );
     ut_savemap test;
@@ -53,6 +53,8 @@ private slots:
     void cleanupTestCase();
 
     void testBufferArea();
+    void testAddToBuffer();
+    void testGigapixelLayout();
 };
 
 #endif  // TEST_LIBQUILL_SAVEMAP_H
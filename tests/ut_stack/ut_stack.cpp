@@ -490,6 +490,77 @@ void ut_stack::testDropRedoHistory()
     delete file;
 }
 
+void ut_stack::testHistoryPreviews()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    QuillImage image = Unittests::generatePaletteImage();
+    image.save(testFile.fileName(), "png");
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    QVERIFY(filter);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+    QuillImage resultImage = filter->apply(image);
+
+    Quill::setEditHistoryPath("/tmp/quill/history");
+    Quill::setEditHistoryPreviewsEnabled(true);
+    QVERIFY(Quill::isEditHistoryPreviewsEnabled());
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    file->setDisplayLevel(0);
+    file->runFilter(filter);
+
+    Quill::releaseAndWait(); // load
+    Quill::releaseAndWait(); // filter
+
+    file->save();
+    while (Quill::isCalculationInProgress())
+        Quill::releaseAndWait();
+
+    QVERIFY(Unittests::compareImage(QImage(testFile.fileName()), resultImage));
+    delete file;
+
+    Quill::cleanup();
+    Quill::initTestingMode();
+    Quill::setPreviewSize(0, QSize(8, 2));
+    Quill::setEditHistoryPath("/tmp/quill/history");
+    Quill::setEditHistoryPreviewsEnabled(true);
+
+    // Both states are read in one task each, without calculating
+    // the states leading to them
+    QuillFile *file2 = new QuillFile(testFile.fileName(), Strings::png);
+    file2->setDisplayLevel(0);
+    QVERIFY(file2->image().isNull());
+    Quill::releaseAndWait(); // stored preview
+    QVERIFY(Unittests::compareImage(file2->image(), resultImage));
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    file2->undo();
+    Quill::releaseAndWait(); // stored preview
+    QVERIFY(Unittests::compareImage(file2->image(), image));
+    QVERIFY(!Quill::isCalculationInProgress());
+    delete file2;
+
+    // Previews of a file changed outside Quill are not used
+    QTest::qWait(1100);
+    resultImage.save(testFile.fileName(), "png");
+
+    Quill::cleanup();
+    Quill::initTestingMode();
+    Quill::setPreviewSize(0, QSize(8, 2));
+    Quill::setEditHistoryPath("/tmp/quill/history");
+    Quill::setEditHistoryPreviewsEnabled(true);
+
+    QuillFile *file3 = new QuillFile(testFile.fileName(), Strings::png);
+    file3->setDisplayLevel(0);
+    file3->undo();
+    QVERIFY(file3->image().isNull());
+
+    delete file3;
+}
+
 int main ( int argc, char *argv[] ){
     QCoreApplication app( argc, argv );
     ut_stack test;
@@ -69,6 +69,7 @@ private slots:
 
     void testImmediateSizeQuery();
     void testDropRedoHistory();
+    void testHistoryPreviews();
 };
 
 #endif  // TEST_LIBQUILL_UNDO_COMMAND_STACK_H
@@ -0,0 +1,185 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <utime.h>
+#include <QtTest/QtTest>
+#include <QCryptographicHash>
+#include <QUrl>
+#include "quill.h"
+#include "unittests.h"
+#include "ut_thumbgen.h"
+
+ut_thumbgen::ut_thumbgen()
+{
+}
+
+void ut_thumbgen::initTestCase()
+{
+}
+
+void ut_thumbgen::cleanupTestCase()
+{
+}
+
+void ut_thumbgen::init()
+{
+    Quill::initTestingMode();
+
+    basePath = QDir::tempPath() + "/quill/thumbgen/thumbnails";
+    imagePath = QDir::tempPath() + "/quill/thumbgen/images";
+    QDir().mkpath(basePath);
+    QDir().mkpath(imagePath);
+
+    generator = new ThumbnailGenerator;
+    generator->setThumbnailBasePath(basePath);
+    generator->setThumbnailExtension("png");
+}
+
+void ut_thumbgen::cleanup()
+{
+    delete generator;
+    Quill::cleanup();
+
+    QDirIterator iterator(QDir::tempPath() + "/quill/thumbgen", QDir::Files,
+                          QDirIterator::Subdirectories);
+    while (iterator.hasNext())
+        QFile::remove(iterator.next());
+}
+
+QString ut_thumbgen::thumbnailName(const QString &flavor,
+                                   const QString &fileName,
+                                   const QString &extension) const
+{
+    // The same naming as in libquill
+    const QFileInfo info(fileName);
+    const QByteArray uri =
+        QUrl::fromLocalFile(info.dir().canonicalPath() + "/" +
+                            info.fileName()).toEncoded();
+    return basePath + "/" + flavor + "/" +
+        QCryptographicHash::hash(uri, QCryptographicHash::Md5).toHex() +
+        "." + extension;
+}
+
+// Thumbnails are only made again when the image has changed.
+
+void ut_thumbgen::testUpToDate()
+{
+    const QString fileName = imagePath + "/image.png";
+    QImage image = Unittests::generatePaletteImage();
+    image.save(fileName, "png");
+
+    generator->addFlavor("normal", QSize(4, 4), false);
+    generator->run(QStringList() << imagePath);
+
+    QCOMPARE(generator->generatedCount(), 1);
+    QCOMPARE(generator->skippedCount(), 0);
+
+    const QString thumbnail = thumbnailName("normal", fileName);
+    QImage result(thumbnail);
+    QCOMPARE(result.size(), QSize(4, 1));
+    QCOMPARE(QFileInfo(thumbnail).lastModified().toTime_t(),
+             QFileInfo(fileName).lastModified().toTime_t());
+
+    generator->processFile(fileName);
+    QCOMPARE(generator->generatedCount(), 1);
+    QCOMPARE(generator->skippedCount(), 1);
+
+    // An image modified later gets a new thumbnail
+    struct utimbuf times;
+    times.actime = times.modtime =
+        QFileInfo(fileName).lastModified().toTime_t() + 10;
+    QCOMPARE(utime(QFile::encodeName(fileName).constData(), &times), 0);
+
+    generator->processFile(fileName);
+    QCOMPARE(generator->generatedCount(), 2);
+    QCOMPARE(generator->skippedCount(), 1);
+    QCOMPARE(QFileInfo(thumbnail).lastModified().toTime_t(),
+             (uint)times.modtime);
+}
+
+// Cropped flavors fill their size with the middle of the image, while
+// others fit the whole image inside their size.
+
+void ut_thumbgen::testCroppedFlavor()
+{
+    const QString fileName = imagePath + "/image.png";
+    QImage image = Unittests::generatePaletteImage();
+    image.save(fileName, "png");
+
+    generator->addFlavor("normal", QSize(8, 8), false);
+    generator->addFlavor("cropped", QSize(2, 2), true);
+    generator->processFile(fileName);
+
+    QCOMPARE(generator->generatedCount(), 1);
+
+    QVERIFY(Unittests::compareImage(QImage(thumbnailName("normal", fileName)),
+                                    image));
+    QVERIFY(Unittests::compareImage(QImage(thumbnailName("cropped", fileName)),
+                                    image.copy(3, 0, 2, 2)));
+}
+
+// Files which cannot be read count as failures, without any thumbnails.
+
+void ut_thumbgen::testFailures()
+{
+    const QString fileName = imagePath + "/corrupt.png";
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("not an image");
+    file.close();
+
+    const QString fileName2 = imagePath + "/image.png";
+    Unittests::generatePaletteImage().save(fileName2, "png");
+
+    generator->addFlavor("normal", QSize(4, 4), false);
+    generator->run(QStringList() << imagePath);
+
+    QCOMPARE(generator->generatedCount(), 1);
+    QCOMPARE(generator->failedCount(), 1);
+    QVERIFY(!QFile::exists(thumbnailName("normal", fileName)));
+
+    generator->processFile(imagePath + "/missing.png");
+    QCOMPARE(generator->failedCount(), 2);
+}
+
+int main ( int argc, char *argv[] ){
+    QCoreApplication app( argc, argv );
+    ut_thumbgen test;
+    return QTest::qExec( &test, argc, argv );
+}
@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = ../bin/ut_thumbgen
+INCLUDEPATH += ../../utils/thumbgen/
+QMAKE_LIBDIR += ../../src/
+equals(QT_MAJOR_VERSION, 5): QT += concurrent
+
+# Input
+HEADERS += ../../utils/thumbgen/thumbnailgenerator.h ut_thumbgen.h
+SOURCES += ../../utils/thumbgen/thumbnailgenerator.cpp ut_thumbgen.cpp
@@ -254,6 +254,38 @@ void ut_tilemap::testMultiple()
     QCOMPARE(tileMap2.tile(1), image2);
 }
 
+void ut_tilemap::testKeepApart()
+{
+    TileMap tileMap(QSize(8,2), QSize(2,2), tileCache);
+    tileMap.resizeCache(4);
+
+    TileMap tileMap2(QSize(8,2), QSize(2,2), tileCache);
+
+    QuillImage image1(QImage(QSize(2,2),QImage::Format_ARGB32));
+    image1.setFullImageSize(QSize(8,2));
+    image1.setArea(QRect(0,0,2,2));
+    image1.fill(qRgba(0, 0, 0, 0));
+
+    QuillImage image2(QImage(QSize(2,2),QImage::Format_ARGB32));
+    image2.setFullImageSize(QSize(8,2));
+    image2.setArea(QRect(0,0,2,2));
+    image2.fill(qRgba(128, 0, 0, 0));
+
+    tileMap.setTile(0, image1);
+
+    // Tiles already in the cache stay there
+    tileMap.keepTilesApart();
+    QCOMPARE(tileMap.tile(0), image1);
+
+    tileMap2.setTile(0, image2);
+
+    // Now both maps have their own tile 0
+    QCOMPARE(tileMap.tile(0), image1);
+    QCOMPARE(tileMap2.tile(0), image2);
+    QCOMPARE(tileMap.count(), 1);
+    QCOMPARE(tileMap2.count(), 1);
+}
+
 int main ( int argc, char *argv[] ){
     QCoreApplication app( argc, argv );
     ut_tilemap test;
@@ -60,6 +60,7 @@ private slots:
     void testSetTile();
 
     void testMultiple();
+    void testKeepApart();
 
 private:
     TileCache* tileCache;
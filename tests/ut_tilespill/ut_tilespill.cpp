@@ -0,0 +1,150 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <QDebug>
+#include <QtTest/QtTest>
+#include <QImage>
+#include <QDir>
+
+#include "tilecache.h"
+#include "tilespill.h"
+#include "unittests.h"
+#include "ut_tilespill.h"
+
+ut_tilespill::ut_tilespill()
+{
+}
+
+void ut_tilespill::initTestCase()
+{
+}
+
+void ut_tilespill::cleanupTestCase()
+{
+}
+
+static QuillImage paletteTile(int x)
+{
+    QuillImage tile = Unittests::generatePaletteImage();
+    tile.setFullImageSize(QSize(64, 2));
+    tile.setArea(QRect(x, 0, 8, 2));
+    return tile;
+}
+
+// A tile comes back with its pixels and attributes, only once.
+
+void ut_tilespill::testStoreAndTake()
+{
+    TileSpill spill(QDir::tempPath(), 1024);
+    QuillImage tile = paletteTile(8);
+
+    QVERIFY(!spill.contains(1, 1));
+    QVERIFY(spill.store(1, 1, tile));
+    QVERIFY(spill.contains(1, 1));
+    QVERIFY(!spill.contains(1, 2));
+    QCOMPARE(spill.count(), 1);
+    QCOMPARE(spill.bytes(), (qint64)64);
+
+    QuillImage result = spill.take(1, 1);
+    QVERIFY(Unittests::compareImage(result, tile));
+    QCOMPARE(result.area(), QRect(8, 0, 8, 2));
+    QCOMPARE(result.fullImageSize(), QSize(64, 2));
+
+    QVERIFY(!spill.contains(1, 1));
+    QVERIFY(spill.take(1, 1).isNull());
+    QCOMPARE(spill.count(), 0);
+    QCOMPARE(spill.bytes(), (qint64)0);
+}
+
+// When the file is full, the oldest tiles are dropped.
+
+void ut_tilespill::testLimit()
+{
+    TileSpill spill(QDir::tempPath(), 3 * 64);
+
+    for (int i=0; i<4; i++)
+        QVERIFY(spill.store(i, 1, paletteTile(i * 8)));
+
+    QCOMPARE(spill.count(), 3);
+    QVERIFY(!spill.contains(0, 1));
+    for (int i=1; i<4; i++)
+        QVERIFY(Unittests::compareImage(spill.take(i, 1),
+                                        Unittests::generatePaletteImage()));
+
+    // Too big for the file
+    QuillImage bigTile(QImage(QSize(64, 2), QImage::Format_RGB32));
+    QVERIFY(!spill.store(0, 1, bigTile));
+    QCOMPARE(spill.count(), 0);
+}
+
+// Tiles falling out of the cache are taken back from the spill.
+
+void ut_tilespill::testTileCache()
+{
+    TileSpill spill(QDir::tempPath(), 1024);
+    TileCache cache(1);
+    cache.setSpill(&spill);
+
+    cache.setTile(0, 1, paletteTile(0));
+    QCOMPARE(spill.count(), 0);
+
+    cache.setTile(1, 1, paletteTile(8));
+    QCOMPARE(spill.count(), 1);
+    QVERIFY(spill.contains(0, 1));
+
+    QuillImage tile = cache.tile(0, 1);
+    QVERIFY(Unittests::compareImage(tile, Unittests::generatePaletteImage()));
+    QCOMPARE(tile.area(), QRect(0, 0, 8, 2));
+    QVERIFY(!spill.contains(0, 1));
+    QVERIFY(spill.contains(1, 1));
+
+    // A tile of another map is not found
+    QVERIFY(cache.tile(1, 2).isNull());
+
+    cache.clear();
+    QCOMPARE(spill.count(), 0);
+    QVERIFY(cache.tile(0, 1).isNull());
+    QVERIFY(cache.tile(1, 1).isNull());
+}
+
+int main ( int argc, char *argv[] ){
+    QCoreApplication app( argc, argv );
+    ut_tilespill test;
+    return QTest::qExec( &test, argc, argv );
+}
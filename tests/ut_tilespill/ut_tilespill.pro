@@ -0,0 +1,7 @@
+include(../tests.pri)
+
+TARGET = ../bin/ut_tilespill
+
+# Input
+HEADERS += ut_tilespill.h
+SOURCES += ut_tilespill.cpp
@@ -49,6 +49,10 @@
 #include "ut_tiling.h"
 #include "quillundocommand.h"
 #include "quillundostack.h"
+#include "core.h"
+#include "file.h"
+#include "jpegdecodersession.h"
+#include "borderedtileapply.h"
 #include "../../src/strings.h"
 
 ut_tiling::ut_tiling()
@@ -124,13 +128,7 @@ void ut_tiling::testTiledSaving()
 
     file->save();
 
-    // Overlay 4 tiles
-    Quill::releaseAndWait();
-    Quill::releaseAndWait();
-    Quill::releaseAndWait();
-    Quill::releaseAndWait();
-
-    // Save
+    // Save, tiles are copied into the save buffer directly
     Quill::releaseAndWait();
 
     QImage resultImage(testFile.fileName());
@@ -173,22 +171,18 @@ void ut_tiling::testTiledSavingSmallCache()
     // Tile 1
     Quill::releaseAndWait();
     Quill::releaseAndWait();
-    Quill::releaseAndWait();
 
     // Tile 2
     Quill::releaseAndWait();
     Quill::releaseAndWait();
-    Quill::releaseAndWait();
 
     // Tile 3
     Quill::releaseAndWait();
     Quill::releaseAndWait();
-    Quill::releaseAndWait();
 
     // Tile 4
     Quill::releaseAndWait();
     Quill::releaseAndWait();
-    Quill::releaseAndWait();
 
     // Saving
     Quill::releaseAndWait();
@@ -328,13 +322,7 @@ void ut_tiling::testTiledSaveLoad()
     Quill::releaseAndWait();
     Quill::releaseAndWait();
 
-    // Overlay 4 tiles
-    Quill::releaseAndWait();
-    Quill::releaseAndWait();
-    Quill::releaseAndWait();
-    Quill::releaseAndWait();
-
-    // Save
+    // Save, tiles are copied into the save buffer directly
     Quill::releaseAndWait();
 
     QImage resultImage(testFile.fileName());
@@ -382,6 +370,7 @@ void ut_tiling::testSaveBuffer()
     Quill::setEditHistoryPath("/tmp/quill/history");
     Quill::setDefaultTileSize(QSize(2, 2));
     Quill::setSaveBufferSize(4);
+    QCOMPARE(Quill::saveBufferPoolHitCount() + Quill::saveBufferPoolMissCount(), 0);
 
     QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
     file->setViewPort(QRect(0, 0, 2, 8));
@@ -416,16 +405,9 @@ void ut_tiling::testSaveBuffer()
 
     file->save();
 
-    // Overlay + save (4 times)
+    // Save (4 times)
     Quill::releaseAndWait();
     Quill::releaseAndWait();
-
-    Quill::releaseAndWait();
-    Quill::releaseAndWait();
-
-    Quill::releaseAndWait();
-    Quill::releaseAndWait();
-
     Quill::releaseAndWait();
     Quill::releaseAndWait();
 
@@ -433,6 +415,9 @@ void ut_tiling::testSaveBuffer()
 
     QVERIFY(Unittests::compareImage(resultImage, targetImage));
 
+    // Each save buffer went through the pool
+    QCOMPARE(Quill::saveBufferPoolHitCount() + Quill::saveBufferPoolMissCount(), 4);
+
     delete file;
 }
 
@@ -487,18 +472,13 @@ void ut_tiling::testSaveBufferUnequal()
 
     file->save();
 
-    // Overlay + save (2+1 for first 3 rows)
-    Quill::releaseAndWait();
-    Quill::releaseAndWait();
+    // Save first 3 rows
     Quill::releaseAndWait();
 
-    // Overlay + save (2+1 for second 3 rows)
-    Quill::releaseAndWait();
-    Quill::releaseAndWait();
+    // Save second 3 rows
     Quill::releaseAndWait();
 
-    // Overlay + save (1+1 for last 2 rows)
-    Quill::releaseAndWait();
+    // Save last 2 rows
     Quill::releaseAndWait();
 
     QImage resultImage(testFile.fileName());
@@ -564,6 +544,96 @@ void ut_tiling::testPan()
     delete file;
 }
 
+// Test that tiles cut from decoded strips match the image
+
+void ut_tiling::testDecodedStripCache()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    QImage image = Unittests::generatePaletteImage().scaled(QSize(256, 128));
+    image.save(testFile.fileName(), "jpg", 100);
+    QImage referenceImage(testFile.fileName(), "jpg");
+
+    Quill::setDefaultTileSize(QSize(64, 64));
+    // Room for one row of tiles only
+    Quill::setDecodedStripCacheSize(256 * 64);
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::jpeg);
+    QSignalSpy spy(file, SIGNAL(imageAvailable(QuillImageList)));
+    file->setDisplayLevel(1);
+    file->setViewPort(QRect(0, 0, 256, 128));
+
+    Quill::releaseAndWait();
+    for (int i=0; i<8; i++)
+        Quill::releaseAndWait();
+
+    QList<QuillImage> tiles;
+    for (int i=0; i<spy.count(); i++)
+        foreach (QuillImage tile, spy.at(i).first().value<QuillImageList>())
+            if (tile.z() == 1)
+                tiles.append(tile);
+
+    QCOMPARE(tiles.count(), 8);
+
+    foreach (QuillImage tile, tiles) {
+        QCOMPARE(tile.size(), QSize(64, 64));
+        QVERIFY(Unittests::getPSNR(tile.convertToFormat(QImage::Format_RGB32),
+                                   referenceImage.copy(tile.area()).convertToFormat(QImage::Format_RGB32)) > 40);
+    }
+
+    // All tiles came from the shared session. Tiles are loaded from
+    // the center out, so the top row is needed again after the bottom
+    // row has replaced it, which restarts the decoder once.
+    QSharedPointer<JpegDecoderSession> session =
+        file->internalFile()->decoderSession(testFile.fileName());
+    QCOMPARE(session->startCount(), 2);
+    QVERIFY(session->bytes() <= 256 * 64 * 4);
+
+    delete file;
+}
+
+void ut_tiling::testViewPortPrediction()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    Unittests::generatePaletteImage().save(testFile.fileName(), "png");
+
+    Quill::setDefaultTileSize(QSize(2, 2));
+    Quill::setViewPortPredictionEnabled(true);
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    QSignalSpy spy(file, SIGNAL(imageAvailable(QuillImageList)));
+    file->setDisplayLevel(1);
+
+    Quill::releaseAndWait(); // preview
+
+    // No motion yet, only the visible tile
+    file->setViewPort(QRect(0, 0, 2, 2));
+    Quill::releaseAndWait();
+    QCOMPARE(spy.count(), 2);
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    // Moving right
+    file->setViewPort(QRect(2, 0, 2, 2));
+    Quill::releaseAndWait();
+    QCOMPARE(spy.count(), 3);
+
+    // The next tile to the right is prefetched
+    QVERIFY(Quill::isCalculationInProgress());
+    Quill::releaseAndWait();
+    QCOMPARE(spy.count(), 4);
+    QList<QuillImage> tileList = spy.at(3).first().value<QuillImageList>();
+    QCOMPARE(tileList.count(), 1);
+    QCOMPARE(tileList.at(0).area(), QRect(4, 0, 2, 2));
+
+    // Only one step ahead
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    delete file;
+}
+
 void ut_tiling::testPreviewSizeChanges()
 {
     QTemporaryFile testFile;
@@ -605,6 +675,359 @@ void ut_tiling::testPreviewSizeChanges()
 }
 
 
+// Reduced tiles are scaled down from the full resolution ones
+
+void ut_tiling::testTileZoomLevels()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    QImage image = Unittests::generatePaletteImage();
+    image.save(testFile.fileName(), "png");
+
+    Quill::setDefaultTileSize(QSize(4, 2));
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    QSignalSpy spy(file, SIGNAL(imageAvailable(QuillImageList)));
+    file->setDisplayLevel(1);
+
+    Quill::releaseAndWait(); // preview
+    file->setViewPort(QRect(0, 0, 8, 2));
+    Quill::releaseAndWait(); // tile 0
+    Quill::releaseAndWait(); // tile 1
+    QCOMPARE(spy.count(), 3);
+
+    // Nothing at the reduced level yet
+    file->setTileZoomLevel(1);
+    QCOMPARE(file->tileZoomLevel(), 1);
+    QCOMPARE(spy.count(), 3);
+
+    Quill::releaseAndWait();
+    Quill::releaseAndWait();
+    QCOMPARE(spy.count(), 5);
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    for (int i=3; i<5; i++) {
+        QuillImage tile = spy.at(i).first().value<QuillImageList>().first();
+        QCOMPARE(tile.size(), QSize(2, 1));
+        QCOMPARE(tile.area().size(), QSize(4, 2));
+        QCOMPARE(tile.fullImageSize(), QSize(8, 2));
+        QVERIFY(Unittests::compareImage(tile,
+                                        image.copy(tile.area()).
+                                        scaled(QSize(2, 1),
+                                               Qt::IgnoreAspectRatio,
+                                               Qt::SmoothTransformation)));
+    }
+
+    // Full resolution tiles are still cached and emitted at once
+    file->setTileZoomLevel(0);
+    QCOMPARE(spy.count(), 6);
+    QuillImageList tiles = spy.at(5).first().value<QuillImageList>();
+    QCOMPARE(tiles.count(), 2);
+    QCOMPARE(tiles.first().size(), QSize(4, 2));
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    delete file;
+}
+
+// Two views of the same file, e.g. a main view and a navigator
+
+void ut_tiling::testMultipleViewPorts()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    Unittests::generatePaletteImage().save(testFile.fileName(), "png");
+
+    Quill::setDefaultTileSize(QSize(2, 2));
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    QuillFile *navigator = new QuillFile(testFile.fileName(), Strings::png);
+    QSignalSpy spy(file, SIGNAL(imageAvailable(QuillImageList)));
+    QSignalSpy navigatorSpy(navigator, SIGNAL(imageAvailable(QuillImageList)));
+
+    navigator->setPriority(QuillFile::Priority_High);
+    file->setDisplayLevel(1);
+    navigator->setDisplayLevel(1);
+
+    Quill::releaseAndWait(); // preview
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(navigatorSpy.count(), 1);
+
+    navigator->setViewPort(QRect(6, 0, 2, 2));
+    file->setViewPort(QRect(0, 0, 2, 2));
+    QCOMPARE(file->viewPort(), QRect(0, 0, 2, 2));
+    QCOMPARE(navigator->viewPort(), QRect(6, 0, 2, 2));
+
+    // The higher priority viewport first, only sent where visible
+    Quill::releaseAndWait();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(navigatorSpy.count(), 2);
+    QCOMPARE(navigatorSpy.at(1).first().value<QuillImageList>().first().area(),
+             QRect(6, 0, 2, 2));
+
+    Quill::releaseAndWait();
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(navigatorSpy.count(), 2);
+    QCOMPARE(spy.at(1).first().value<QuillImageList>().first().area(),
+             QRect(0, 0, 2, 2));
+
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    // A calculated tile comes right away when moving onto it
+    navigator->setViewPort(QRect(0, 0, 2, 2));
+    QCOMPARE(navigatorSpy.count(), 3);
+    QCOMPARE(spy.count(), 2);
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    delete navigator;
+    delete file;
+}
+
+// Tiles between distant viewports do not count as visible
+
+void ut_tiling::testDistantViewPortsFullCache()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    Unittests::generatePaletteImage().save(testFile.fileName(), "png");
+
+    Quill::setDefaultTileSize(QSize(2, 2));
+    Quill::setTileCacheSize(2);
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    QuillFile *navigator = new QuillFile(testFile.fileName(), Strings::png);
+
+    navigator->setPriority(QuillFile::Priority_High);
+    file->setDisplayLevel(1);
+    navigator->setDisplayLevel(1);
+
+    Quill::releaseAndWait(); // preview
+
+    // Fill the cache with the middle tiles
+    file->setViewPort(QRect(2, 0, 4, 2));
+    Quill::releaseAndWait();
+    Quill::releaseAndWait();
+    QVERIFY(!Quill::isCalculationInProgress());
+    QCOMPARE(file->allImageLevels().count(), 3);
+
+    navigator->setViewPort(QRect(6, 0, 2, 2));
+    file->setViewPort(QRect(0, 0, 2, 2));
+
+    QVERIFY(Quill::isCalculationInProgress());
+    Quill::releaseAndWait();
+    Quill::releaseAndWait();
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    // Only the visible tiles are given
+    QCOMPARE(file->allImageLevels().count(), 3);
+    QCOMPARE(file->allImageLevels().at(1).area(), QRect(0, 0, 2, 2));
+    QCOMPARE(file->allImageLevels().at(2).area(), QRect(6, 0, 2, 2));
+
+    delete navigator;
+    delete file;
+}
+
+// A filter with a tile border gets its input from neighbouring tiles
+
+void ut_tiling::testTileBorder()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    Unittests::generatePaletteImage().save(testFile.fileName(), "png");
+
+    Quill::setDefaultTileSize(QSize(2, 2));
+    Quill::setTileBorder(QuillImageFilter::Name_BrightnessContrast, 1);
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    file->setDisplayLevel(1);
+
+    Quill::releaseAndWait(); // preview
+
+    file->setViewPort(QRect(0, 0, 2, 2));
+
+    Quill::releaseAndWait();
+    QCOMPARE(file->allImageLevels().count(), 2);
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    QVERIFY(filter);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+
+    QuillImage targetImage =
+        filter->apply(Unittests::generatePaletteImage());
+
+    file->runFilter(filter);
+    Quill::releaseAndWait(); // preview
+
+    // The neighbouring tile is loaded first
+    Quill::releaseAndWait();
+    QCOMPARE(file->allImageLevels().count(), 1);
+
+    Quill::releaseAndWait();
+    QCOMPARE(file->allImageLevels().count(), 2);
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    QuillImage tile = file->allImageLevels().last();
+    QCOMPARE(tile.area(), QRect(0, 0, 2, 2));
+    QVERIFY(Unittests::compareImage(tile, targetImage.copy(0, 0, 2, 2)));
+
+    delete file;
+}
+
+// A border which does not fit in the tile cache is left out
+
+void ut_tiling::testTileBorderSmallCache()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    Unittests::generatePaletteImage().save(testFile.fileName(), "png");
+
+    Quill::setDefaultTileSize(QSize(2, 2));
+    Quill::setTileCacheSize(2);
+    Quill::setTileBorder(QuillImageFilter::Name_BrightnessContrast, 1);
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    file->setDisplayLevel(1);
+
+    Quill::releaseAndWait(); // preview
+
+    file->setViewPort(QRect(2, 0, 2, 2));
+
+    Quill::releaseAndWait();
+    QCOMPARE(file->allImageLevels().count(), 2);
+
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_BrightnessContrast);
+    QVERIFY(filter);
+    filter->setOption(QuillImageFilter::Brightness, QVariant(20));
+
+    QuillImage targetImage =
+        filter->apply(Unittests::generatePaletteImage());
+
+    file->runFilter(filter);
+    Quill::releaseAndWait(); // preview
+
+    // The three tiles around the viewport would not fit together,
+    // so the tile is calculated right away without its neighbours
+    Quill::releaseAndWait();
+    QCOMPARE(file->allImageLevels().count(), 2);
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    QuillImage tile = file->allImageLevels().last();
+    QCOMPARE(tile.area(), QRect(2, 0, 2, 2));
+    QVERIFY(Unittests::compareImage(tile, targetImage.copy(2, 0, 2, 2)));
+
+    delete file;
+}
+
+// Visible tiles with a border do not replace each other's input
+
+void ut_tiling::testTileBorderNeighbours()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    const QuillImage image = Unittests::generatePaletteImage();
+    image.save(testFile.fileName(), "png");
+
+    Quill::setDefaultTileSize(QSize(2, 2));
+    Quill::setTileBorder(QuillImageFilter::Name_FreeRotate, 2);
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    file->setDisplayLevel(1);
+
+    Quill::releaseAndWait(); // preview
+
+    file->setViewPort(QRect(0, 0, 4, 2));
+
+    Quill::releaseAndWait();
+    Quill::releaseAndWait();
+    QCOMPARE(file->allImageLevels().count(), 3);
+
+    // Rotating reads pixels from the neighbouring tiles
+    QuillImageFilter *filter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Name_FreeRotate);
+    QVERIFY(filter);
+    filter->setOption(QuillImageFilter::Angle, QVariant(10));
+
+    file->runFilter(filter);
+
+    // Preview, the missing neighbour and the two visible tiles
+    for (int i=0; (i<10) && Quill::isCalculationInProgress(); i++)
+        Quill::releaseAndWait();
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    const QList<QuillImage> levels = file->allImageLevels();
+    QCOMPARE(levels.count(), 3);
+
+    // Each tile is the filtered bordered area of the original
+    for (int i=1; i<levels.count(); i++) {
+        const QRect area = QRect(2 * (i - 1), 0, 2, 2).
+            adjusted(-2, -2, 2, 2).intersected(QRect(0, 0, 8, 2));
+        QuillImage input(image.copy(area));
+        input.setFullImageSize(QSize(8, 2));
+        input.setArea(area);
+
+        BorderedTileApply operation(filter, levels.at(i));
+        QVERIFY(Unittests::compareImage(levels.at(i),
+                                        operation.apply(input)));
+    }
+
+    delete file;
+}
+
+// Tile size grows with the measured overhead per tile
+
+void ut_tiling::testAdaptiveTileSize()
+{
+    QTemporaryFile testFile;
+    testFile.open();
+
+    Unittests::generatePaletteImage().save(testFile.fileName(), "png");
+
+    Quill::setDefaultTileSize(QSize(2, 2));
+    Quill::setTileCacheSize(100);
+    Quill::setAdaptiveTileSizeEnabled(true);
+    QVERIFY(Quill::isAdaptiveTileSizeEnabled());
+
+    Core *core = Core::instance();
+
+    // Nothing measured yet
+    QCOMPARE(core->tileSizeFor(QSize(8, 2)), QSize(2, 2));
+
+    // 10 us per tile and 0.1 us per pixel
+    core->recordFilterTime(10, 11);
+    core->recordFilterTime(100, 20);
+
+    // Small images may have one tile
+    QCOMPARE(core->tileSizeFor(QSize(8, 2)), QSize(8, 2));
+
+    // Large images are limited by the tile cache memory
+    QCOMPARE(core->tileSizeFor(QSize(100000, 100000)), QSize(4, 4));
+
+    QuillFile *file = new QuillFile(testFile.fileName(), Strings::png);
+    file->setDisplayLevel(1);
+
+    Quill::releaseAndWait(); // preview
+
+    file->setViewPort(QRect(0, 0, 8, 2));
+
+    Quill::releaseAndWait();
+    QList<QuillImage> images = file->allImageLevels();
+    QCOMPARE(images.count(), 2);
+    QCOMPARE(images.last().area(), QRect(0, 0, 8, 2));
+    QVERIFY(!Quill::isCalculationInProgress());
+
+    delete file;
+
+    Quill::setAdaptiveTileSizeEnabled(false);
+    QCOMPARE(core->tileSizeFor(QSize(8, 2)), QSize(2, 2));
+}
+
 // Viewport contains more tiles than the cache
 // This should reach a stable state.
 
@@ -682,20 +1105,16 @@ void ut_tiling::testSaveInterrupted()
     file->runFilter(filter);
     file->save();
 
-    // load both tiles
+    // load and filter tile 1, copied into the save buffer
     Quill::releaseAndWait();
     Quill::releaseAndWait();
 
-    // filter for both tiles
-    Quill::releaseAndWait();
-    Quill::releaseAndWait();
-
-    // overlay 1/2
+    // load tile 2
     Quill::releaseAndWait();
 
     file->undo();
 
-    // overlay 2/2 - should do nothing
+    // filter tile 2 - should do nothing
     Quill::releaseAndWait();
     // save - should do nothing
     Quill::releaseAndWait();
@@ -705,10 +1124,10 @@ void ut_tiling::testSaveInterrupted()
     file->redo();
     file->save();
 
-    // overlay + save
+    // tiles + save
+    Quill::releaseAndWait();
     Quill::releaseAndWait();
     Quill::releaseAndWait();
-    Quill::releaseAndWait();    
     QVERIFY(Unittests::compareImage(QImage(testFile.fileName()), targetImage));
 
     delete file;
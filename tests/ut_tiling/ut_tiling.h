@@ -67,7 +67,16 @@ private slots:
     void testSaveBufferUnequal();
 
     void testPan();
+    void testDecodedStripCache();
+    void testViewPortPrediction();
     void testPreviewSizeChanges();
+    void testTileZoomLevels();
+    void testMultipleViewPorts();
+    void testDistantViewPortsFullCache();
+    void testTileBorder();
+    void testTileBorderSmallCache();
+    void testTileBorderNeighbours();
+    void testAdaptiveTileSize();
 
     void testViewPortBiggerThanCache();
 
@@ -0,0 +1,126 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <iostream>
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTime>
+
+#include "thumbnailgenerator.h"
+
+static void usage()
+{
+    std::cout << "Usage: quill-thumbgen [-j threads] [-b base path] "
+              << "[-e extension] [-f name:WxH[:crop]]... path...\n";
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    ThumbnailGenerator generator;
+    QStringList paths;
+    bool hasFlavors = false;
+
+    QStringList arguments = app.arguments();
+    arguments.removeFirst();
+
+    while (!arguments.isEmpty()) {
+        const QString argument = arguments.takeFirst();
+
+        if (argument.startsWith('-') && arguments.isEmpty()) {
+            usage();
+            return 1;
+        }
+
+        if (argument == "-j")
+            generator.setThreadCount(arguments.takeFirst().toInt());
+        else if (argument == "-b")
+            generator.setThumbnailBasePath(arguments.takeFirst());
+        else if (argument == "-e")
+            generator.setThumbnailExtension(arguments.takeFirst());
+        else if (argument == "-f") {
+            const QStringList flavor = arguments.takeFirst().split(':');
+            const QStringList size = flavor.value(1).split('x');
+            const int width = size.value(0).toInt();
+            const int height = size.value(1).toInt();
+            if (flavor.count() < 2 || width <= 0 || height <= 0) {
+                usage();
+                return 1;
+            }
+            generator.addFlavor(flavor.at(0), QSize(width, height),
+                                flavor.value(2) == "crop");
+            hasFlavors = true;
+        }
+        else if (argument.startsWith('-')) {
+            usage();
+            return 1;
+        }
+        else
+            paths.append(argument);
+    }
+
+    if (paths.isEmpty()) {
+        usage();
+        return 1;
+    }
+
+    // Same as the freedesktop.org thumbnail specification
+    if (!hasFlavors) {
+        generator.addFlavor("normal", QSize(128, 128), false);
+        generator.addFlavor("large", QSize(256, 256), false);
+    }
+
+    QTime time;
+    time.start();
+
+    generator.run(paths);
+
+    const int elapsed = qMax(time.elapsed(), 1);
+    const int count = generator.generatedCount() +
+        generator.skippedCount() + generator.failedCount();
+
+    std::cout << count << " images in " << elapsed << " ms ("
+              << count * 1000.0 / elapsed << " images/s): "
+              << generator.generatedCount() << " generated, "
+              << generator.skippedCount() << " up to date, "
+              << generator.failedCount() << " failed\n";
+
+    return generator.failedCount() > 0 ? 2 : 0;
+}
@@ -0,0 +1,26 @@
+TEMPLATE = app
+TARGET = quill-thumbgen
+DEPENDPATH += .
+INCLUDEPATH += .
+
+equals(QT_MAJOR_VERSION, 4): LIBS += -lquill
+equals(QT_MAJOR_VERSION, 5): LIBS += -lquill-qt5
+equals(QT_MAJOR_VERSION, 5): QT += concurrent
+
+CONFIG += link_pkgconfig
+equals(QT_MAJOR_VERSION, 4): PKGCONFIG += quillmetadata quillimagefilter
+equals(QT_MAJOR_VERSION, 5): PKGCONFIG += quillmetadata-qt5 quillimagefilter-qt5
+
+QMAKE_LIBDIR += ../../src/
+
+# Avoid automatic casts from QString to QUrl. Dangerous!!!
+DEFINES += QT_NO_URL_CAST_FROM_STRING
+
+include(../../common.pri)
+
+# Input
+HEADERS += thumbnailgenerator.h
+SOURCES += thumbnailgenerator.cpp main.cpp
+
+target.path = /usr/lib/quill-utils
+INSTALLS += target
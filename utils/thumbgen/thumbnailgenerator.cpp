@@ -0,0 +1,267 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#include <math.h>
+#include <utime.h>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QImageReader>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <QuillImage>
+#include <QuillImageFilter>
+#include <QuillImageFilterFactory>
+
+#include "thumbnailgenerator.h"
+#include "../../src/quill.h"
+
+namespace {
+
+// Runs ThumbnailGenerator::processFile() for QtConcurrent
+struct ThumbnailJob {
+    typedef void result_type;
+
+    ThumbnailJob(ThumbnailGenerator *generator) : generator(generator) {}
+
+    void operator()(QString &fileName) { generator->processFile(fileName); }
+
+    ThumbnailGenerator *generator;
+};
+
+// Thumbnails carry the modification time of their image
+void setFileModificationDateTime(const QString &fileName,
+                                 const QDateTime &dateTime)
+{
+    struct utimbuf times;
+    times.actime = times.modtime = dateTime.toTime_t();
+    utime(QFile::encodeName(fileName).constData(), &times);
+}
+
+}
+
+ThumbnailGenerator::ThumbnailGenerator() :
+    m_flavorCount(0),
+    m_threadCount(0),
+    m_generatedCount(0),
+    m_skippedCount(0),
+    m_failedCount(0)
+{
+    Quill::setThumbnailExtension("jpeg");
+}
+
+void ThumbnailGenerator::setThumbnailBasePath(const QString &path)
+{
+    Quill::setThumbnailBasePath(path);
+}
+
+void ThumbnailGenerator::setThumbnailExtension(const QString &extension)
+{
+    Quill::setThumbnailExtension(extension);
+}
+
+void ThumbnailGenerator::addFlavor(const QString &name, const QSize &size,
+                                   bool isCropped)
+{
+    const int level = m_flavorCount++;
+    if (level > 0)
+        Quill::setPreviewLevelCount(level + 1);
+
+    Quill::setPreviewSize(level, size);
+    Quill::setMinimumPreviewSize(level, isCropped ? size : QSize());
+    Quill::setThumbnailFlavorName(level, name);
+}
+
+void ThumbnailGenerator::setThreadCount(int count)
+{
+    m_threadCount = count;
+}
+
+void ThumbnailGenerator::run(const QStringList &paths)
+{
+    QStringList fileNames = findImages(paths);
+
+    if (m_threadCount > 0)
+        QThreadPool::globalInstance()->setMaxThreadCount(m_threadCount);
+
+    // Load the filter plugins once here instead of in all workers at once
+    delete QuillImageFilterFactory::createImageFilter(QuillImageFilter::Role_Load);
+    delete QuillImageFilterFactory::createImageFilter(QuillImageFilter::Role_Save);
+
+    QtConcurrent::blockingMap(fileNames, ThumbnailJob(this));
+}
+
+void ThumbnailGenerator::processFile(const QString &fileName)
+{
+    const QDateTime lastModified = QFileInfo(fileName).lastModified();
+
+    QList<int> levels;
+    for (int level=0; level<m_flavorCount; level++)
+        if (!Quill::hasValidThumbnail(fileName, level))
+            levels.append(level);
+
+    if (levels.isEmpty()) {
+        m_skippedCount.ref();
+        return;
+    }
+
+    QuillImageFilter *loadFilter =
+        QuillImageFilterFactory::createImageFilter(QuillImageFilter::Role_Load);
+    loadFilter->setOption(QuillImageFilter::FileName, QVariant(fileName));
+
+    const QSize fullImageSize = loadFilter->newFullImageSize(QSize());
+    if (fullImageSize.isEmpty()) {
+        delete loadFilter;
+        m_failedCount.ref();
+        return;
+    }
+
+    // The image is decoded only once, at the smallest size which is
+    // still enough for the most detailed flavor
+
+    QList<QSize> targetSizes;
+    QList<QRect> areas;
+    qreal scale = 0;
+
+    foreach (int level, levels) {
+        const QSize size = Quill::targetSizeForLevel(level, fullImageSize);
+        const QRect area = Quill::targetAreaForLevel(level, fullImageSize);
+        targetSizes.append(size);
+        areas.append(area);
+
+        scale = qMax(scale, qMax((qreal)size.width() / area.width(),
+                                 (qreal)size.height() / area.height()));
+    }
+    scale = qMin(scale, (qreal)1);
+
+    QuillImage input;
+    input.setFullImageSize(fullImageSize);
+    input.setTargetSize(QSize(qMax(1, (int)ceil(fullImageSize.width() * scale)),
+                              qMax(1, (int)ceil(fullImageSize.height() * scale))));
+    input.setArea(QRect(QPoint(0, 0), fullImageSize));
+
+    const QuillImage image = loadFilter->apply(input);
+    delete loadFilter;
+
+    if (image.isNull()) {
+        m_failedCount.ref();
+        return;
+    }
+
+    const qreal scaleX = (qreal)image.width() / fullImageSize.width();
+    const qreal scaleY = (qreal)image.height() / fullImageSize.height();
+
+    bool hasFailed = false;
+
+    for (int i=0; i<levels.count(); i++) {
+        const QRect area = areas.at(i);
+        const QRect imageArea =
+            QRect(qRound(area.x() * scaleX), qRound(area.y() * scaleY),
+                  qMax(1, qRound(area.width() * scaleX)),
+                  qMax(1, qRound(area.height() * scaleY))) & image.rect();
+
+        const QImage thumbnail =
+            image.copy(imageArea).scaled(targetSizes.at(i),
+                                         Qt::IgnoreAspectRatio,
+                                         Qt::SmoothTransformation);
+
+        const QString thumbnailName =
+            Quill::thumbnailFileName(fileName, levels.at(i));
+        QDir().mkpath(QFileInfo(thumbnailName).path());
+
+        QuillImageFilter *saveFilter =
+            QuillImageFilterFactory::createImageFilter(QuillImageFilter::Role_Save);
+        saveFilter->setOption(QuillImageFilter::FileName,
+                              QVariant(thumbnailName));
+        saveFilter->setOption(QuillImageFilter::Timestamp,
+                              QVariant(lastModified));
+
+        if (saveFilter->apply(thumbnail).isNull())
+            hasFailed = true;
+        else
+            setFileModificationDateTime(thumbnailName, lastModified);
+        delete saveFilter;
+    }
+
+    if (hasFailed)
+        m_failedCount.ref();
+    else
+        m_generatedCount.ref();
+}
+
+int ThumbnailGenerator::generatedCount() const
+{
+    return const_cast<QAtomicInt&>(m_generatedCount).fetchAndAddRelaxed(0);
+}
+
+int ThumbnailGenerator::skippedCount() const
+{
+    return const_cast<QAtomicInt&>(m_skippedCount).fetchAndAddRelaxed(0);
+}
+
+int ThumbnailGenerator::failedCount() const
+{
+    return const_cast<QAtomicInt&>(m_failedCount).fetchAndAddRelaxed(0);
+}
+
+QStringList ThumbnailGenerator::findImages(const QStringList &paths)
+{
+    QStringList nameFilters;
+    foreach (const QByteArray &format, QImageReader::supportedImageFormats()) {
+        nameFilters.append("*." + QString(format).toLower());
+        nameFilters.append("*." + QString(format).toUpper());
+    }
+
+    QStringList fileNames;
+    foreach (const QString &path, paths) {
+        const QFileInfo info(path);
+        if (info.isFile()) {
+            fileNames.append(info.absoluteFilePath());
+            continue;
+        }
+
+        QDirIterator iterator(path, nameFilters, QDir::Files,
+                              QDirIterator::Subdirectories);
+        while (iterator.hasNext())
+            fileNames.append(QFileInfo(iterator.next()).absoluteFilePath());
+    }
+    return fileNames;
+}
@@ -0,0 +1,112 @@
+/****************************************************************************
+**
+** Copyright (C) 2009-11 Nokia Corporation and/or its subsidiary(-ies).
+** Contact: Pekka Marjola <pekka.marjola@nokia.com>
+**
+** This file is part of the Quill package.
+**
+** Commercial Usage
+** Licensees holding valid Qt Commercial licenses may use this file in
+** accordance with the Qt Commercial License Agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Nokia.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Nokia gives you certain
+** additional rights. These rights are described in the Nokia Qt LGPL
+** Exception version 1.0, included in the file LGPL_EXCEPTION.txt in this
+** package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+** If you are unsure which license is appropriate for your use, please
+** contact the sales department at qt-sales@nokia.com.
+**
+****************************************************************************/
+
+#ifndef THUMBNAIL_GENERATOR_H
+#define THUMBNAIL_GENERATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QSize>
+#include <QAtomicInt>
+
+/*!
+  Generates the thumbnails of all images under a set of directories,
+  using the thumbnail file names, sizes and validity rules of libquill,
+  so that applications find them ready. The flavors and paths are set
+  as the display levels and thumbnail settings of Quill. Each image is decoded once at the
+  smallest size enough for all flavors, and images are processed in
+  parallel on all cores.
+ */
+
+class ThumbnailGenerator {
+ public:
+    ThumbnailGenerator();
+
+    void setThumbnailBasePath(const QString &path);
+    void setThumbnailExtension(const QString &extension);
+
+    /*!
+      Adds a thumbnail flavor as the next display level. Cropped
+      flavors fill the whole size, others fit inside it. Must be
+      called before any QuillFile is opened.
+     */
+
+    void addFlavor(const QString &name, const QSize &size, bool isCropped);
+
+    /*!
+      Number of images processed in parallel; 0 for one per core.
+     */
+
+    void setThreadCount(int count);
+
+    /*!
+      Generates all missing or outdated thumbnails for the images under
+      the given files and directories.
+     */
+
+    void run(const QStringList &paths);
+
+    /*!
+      Generates the missing or outdated thumbnails of one image.
+     */
+
+    void processFile(const QString &fileName);
+
+    int generatedCount() const;
+    int skippedCount() const;
+    int failedCount() const;
+
+    /*!
+      All supported images under the given files and directories.
+      Hidden directories, such as the thumbnail directory itself, are
+      skipped.
+     */
+
+    static QStringList findImages(const QStringList &paths);
+
+ private:
+    int m_flavorCount;
+    int m_threadCount;
+
+    QAtomicInt m_generatedCount;
+    QAtomicInt m_skippedCount;
+    QAtomicInt m_failedCount;
+};
+
+#endif // THUMBNAIL_GENERATOR_H